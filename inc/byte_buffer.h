@@ -2,15 +2,30 @@
 #define __BUFFER_H__
 
 #include "basic_head.h"
+#include "logger.h"
 
 namespace basic {
 
 #define MAX_BUFFER_SIZE     1073741824 // 1*1024*1024*1024 (1GB)
 #define MAX_DATA_SIZE       1073741823 // 多的一个字节用于防止，缓存写满时，start_write 和 start_read 重合而造成分不清楚是写满了还是没写
+#define INLINE_BUFFER_SIZE  48         // 小于该大小的数据直接保存在对象内部，不在堆上分配内存
 
 typedef char bufftype;
 typedef char* buffptr;
 
+// 缓存分配和拷贝的统计信息
+// 编译时定义 __BYTE_BUFFER_STATS__ 才会统计，否则不增加任何开销，获取到的统计信息都为 0
+// 开启统计会改变 ByteBuffer 的大小，库和使用者必须使用相同的定义编译
+struct ByteBufferStats {
+    int64_t allocations;        // 在堆上分配缓存的次数
+    int64_t frees;              // 释放堆上缓存的次数
+    int64_t resizes;            // 扩容的次数
+    int64_t bytes_copied_in;    // copy_data_to_buffer 拷贝的字节数
+    int64_t bytes_copied_out;   // copy_data_from_buffer 拷贝的字节数
+    int64_t peak_capacity;      // 缓存容量的最大值
+    int64_t wrap_arounds;       // 读写位置越过缓存末尾回到开头的次数
+};
+
 class ByteBufferIterator;
 class ByteBuffer {
     friend class ByteBufferIterator;
@@ -83,11 +98,19 @@ public:
     // ByteBuffer 是循环队列，读写不一定是连续的
     ssize_t get_cont_write_size(void) const;
     ssize_t get_cont_read_size(void) const;
+    // 返回数据所在的两段连续内存, 数据没有折返时第二段长度为 0
+    void get_read_segments(buffptr &first, ssize_t &first_size, buffptr &second, ssize_t &second_size) const;
 
     // 更新读写数据和剩余的缓冲大小
     ssize_t update_write_pos(ssize_t offset);
     ssize_t update_read_pos(ssize_t offset);
 
+    // 将数据移动到缓冲区开头，使数据成为一段连续内存，返回数据的起始指针(长度为 data_size())
+    // 数据折返时只需要额外拷贝较短的一段，调用后之前获取的迭代器和指针都会失效
+    buffptr linearize(void);
+    // 空闲空间被分成两段时将数据移动到开头，使空闲空间连续，返回 get_cont_write_size()
+    ssize_t compact(void);
+
     // ===================== 操作ByteBuffer ======================
     // 返回 ByteBuffer 中所有匹配 buff 的迭代器
     std::vector<ByteBufferIterator> find(const ByteBuffer &buff);
@@ -110,6 +133,15 @@ public:
     // 返回符合模式 regex 的子串(使用正则表达式)
     std::vector<ByteBuffer> match(ByteBuffer &regex);
 
+    // ===================== 统计信息 ======================
+    // 当前对象的统计信息
+    ByteBufferStats stats(void) const;
+    // 所有 ByteBuffer 对象累计的统计信息，多线程下也是准确的
+    static ByteBufferStats global_stats(void);
+    static void reset_global_stats(void);
+    // 通过全局 Logger 输出统计信息
+    static void dump_stats(const ByteBufferStats &stats, const std::string &name, InfoLevel level = LOG_LEVEL_INFO);
+
 private:
     // 设置外部缓存
     ssize_t set_extern_buffer(buffptr exbuf, ssize_t buff_size);
@@ -122,6 +154,11 @@ private:
     ssize_t copy_data_to_buffer(const void *data, ssize_t size);
     // 从bytebuff中拷贝data个字节到data中
     ssize_t copy_data_from_buffer(void *data, ssize_t size);
+    // 拷贝 src 的数据，数据较少时使用内部缓存
+    void copy_from(const ByteBuffer &src);
+    // 记录缓存的分配和释放
+    void record_alloc(void);
+    void record_free(void);
     
 private:
     buffptr buffer_;
@@ -132,6 +169,13 @@ private:
     ssize_t used_data_size_;
     ssize_t free_data_size_;
     ssize_t max_buffer_size_;
+
+    // 内部缓存，buffer_ 指向这里时不需要释放
+    bufftype inline_buffer_[INLINE_BUFFER_SIZE];
+
+#ifdef __BYTE_BUFFER_STATS__
+    ByteBufferStats stats_ = ByteBufferStats();
+#endif
 };
 
 // 迭代器
@@ -0,0 +1,31 @@
+#ifndef __BYTE_CODEC_H__
+#define __BYTE_CODEC_H__
+
+#include "basic_head.h"
+#include "byte_buffer.h"
+
+namespace basic {
+
+enum Base64Alphabet {
+    BASE64_STANDARD = 0,    // A-Z a-z 0-9 + /
+    BASE64_URL_SAFE = 1     // A-Z a-z 0-9 - _
+};
+
+// 下面的编解码函数从 src 中读取全部数据(不修改 src)，结果追加到 dst 的末尾
+// 支持 AVX2/SSSE3 的 CPU 上运行时自动选择向量化实现，否则使用标量实现
+// src 和 dst 不能是同一个 ByteBuffer
+// 返回写入 dst 的字节数，输入不合法时返回 -1(此时 dst 中可能已经写入了部分数据)
+
+// base64 编码，padding 为 true 时结尾用 '=' 补齐 4 字节
+ssize_t base64_encode(const ByteBuffer &src, ByteBuffer &dst, Base64Alphabet alphabet = BASE64_STANDARD, bool padding = true);
+// base64 解码，结尾的 '=' 可有可无
+ssize_t base64_decode(const ByteBuffer &src, ByteBuffer &dst, Base64Alphabet alphabet = BASE64_STANDARD);
+
+// 十六进制编码，upper 为 true 时输出大写字母
+ssize_t hex_encode(const ByteBuffer &src, ByteBuffer &dst, bool upper = false);
+// 十六进制解码，大小写字母都可以接受
+ssize_t hex_decode(const ByteBuffer &src, ByteBuffer &dst);
+
+}
+
+#endif
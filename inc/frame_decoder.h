@@ -0,0 +1,91 @@
+#ifndef __FRAME_DECODER_H__
+#define __FRAME_DECODER_H__
+
+#include "basic_head.h"
+#include "byte_buffer.h"
+
+namespace basic {
+
+enum FrameType {
+    FRAME_DELIMITER,        // 以分隔符结尾的帧，例如 "\r\n"
+    FRAME_FIXED_LENGTH,     // 固定 1/2/4/8 字节长度头 + 负载
+    FRAME_VARINT_LENGTH,    // varint(LEB128) 长度头 + 负载
+    FRAME_HTTP_CHUNKED      // HTTP chunked 编码，每个 chunk 是一帧
+};
+
+enum FrameStatus {
+    FRAME_ERROR = -1,       // 数据格式错误或是帧超过了最大长度
+    FRAME_NEED_MORE = 0,    // 帧还不完整，需要等待更多的数据
+    FRAME_COMPLETE = 1      // 得到了一个完整的帧
+};
+
+// 帧在 ByteBuffer 中的位置，不拷贝数据
+// ByteBuffer 是循环队列，负载最多分为两段连续内存，第二段长度为 0 表示负载是连续的
+struct FrameView {
+    ssize_t offset;         // 负载相对于读位置的偏移
+    ssize_t size;           // 负载大小，HTTP chunked 中大小为 0 的帧表示数据结束
+    ssize_t frame_size;     // 整个帧的大小(包括长度头、分隔符等)
+    buffptr first;
+    ssize_t first_size;
+    buffptr second;
+    ssize_t second_size;
+};
+
+// 增量解帧：记录已经扫描过的位置，新数据到来时从上次停下的位置继续，不会重复扫描
+// 解析出的帧处理完后必须调用 consume() 移除，不能再通过其他方式修改 ByteBuffer 的读位置
+class FrameDecoder {
+public:
+    FrameDecoder(void);
+    // delimiter 为空时使用默认的 "\n"
+    explicit FrameDecoder(const std::string &delimiter);
+    ~FrameDecoder(void);
+
+    // 设置解帧方式，同时清空已经扫描的状态，参数不合法时返回 -1
+    int set_delimiter(const std::string &delimiter);
+    int set_fixed_length(int field_size, bool big_endian = true);
+    int set_varint_length(void);
+    int set_http_chunked(void);
+
+    // 帧(不包括长度头和分隔符)的最大长度，超过时返回 FRAME_ERROR
+    void set_max_frame_size(ssize_t size) {max_frame_size_ = size;}
+    FrameType type(void) const {return type_;}
+
+    // 从 buff 的读位置开始查找一个完整的帧，不修改 buff
+    FrameStatus decode(const ByteBuffer &buff, FrameView &frame);
+    // 从 buff 中移除 frame，并准备解析下一帧
+    ssize_t consume(ByteBuffer &buff, const FrameView &frame);
+    // 解析一个帧，将负载拷贝到 payload 的末尾并从 buff 中移除该帧
+    FrameStatus read_frame(ByteBuffer &buff, ByteBuffer &payload);
+
+    // 清空扫描状态，buff 被外部修改过读位置之后需要调用
+    void reset(void);
+
+private:
+    FrameStatus decode_delimiter(const ByteBuffer &buff, FrameView &frame);
+    FrameStatus decode_fixed_length(const ByteBuffer &buff, FrameView &frame);
+    FrameStatus decode_varint_length(const ByteBuffer &buff, FrameView &frame);
+    FrameStatus decode_http_chunked(const ByteBuffer &buff, FrameView &frame);
+
+    // 数据的长度头解析完成后，检查负载是否已经完整
+    FrameStatus check_payload(const ByteBuffer &buff, FrameView &frame);
+    // 填充 frame 中负载所在的内存段
+    void make_view(const ByteBuffer &buff, ssize_t offset, ssize_t size, ssize_t frame_size, FrameView &frame);
+
+private:
+    FrameType type_;
+    std::string delimiter_;
+    int field_size_;
+    bool big_endian_;
+    ssize_t max_frame_size_;
+
+    // 当前帧的解析状态，偏移都是相对于 buff 的读位置
+    int state_;
+    ssize_t scan_pos_;          // 下次开始扫描的位置
+    ssize_t header_size_;       // 长度头的大小，未解析出来时为 -1
+    ssize_t payload_size_;
+    ssize_t line_start_;        // HTTP chunked 中当前 trailer 行的开始位置
+};
+
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef __JSON_ARENA_H__
+#define __JSON_ARENA_H__
+
+#include "basic_head.h"
+
+#include <cstddef>
+#include <atomic>
+
+#define JSON_ARENA_BLOCK_SIZE       4096        // 默认的第一个内存块大小
+#define JSON_ARENA_MAX_BLOCK_SIZE   1048576     // 内存块按倍数增长的上限(1MB)
+
+namespace basic {
+
+// 单调增长的内存池：只分配不单独释放，所有内存在 reset() 或析构时一次释放
+// WeJson 解析出来的节点、对象的成员和字符串都从这里分配，避免逐个节点 new/delete
+class JsonArena {
+public:
+    explicit JsonArena(std::size_t block_size = JSON_ARENA_BLOCK_SIZE);
+    ~JsonArena(void);
+
+    void* allocate(std::size_t size, std::size_t align = alignof(std::max_align_t));
+    // 释放所有分配的内存，只有一个内存块时保留下来重用
+    // 有多个内存块时合并成一个，下次分配时一次申请
+    void reset(void);
+
+    // 已经分配出去的字节数和内存块的总大小
+    std::size_t used(void) const {return used_;}
+    std::size_t capacity(void) const {return capacity_;}
+    // ptr 是否指向 arena 中的内存，需要遍历所有内存块
+    bool owns(const void *ptr) const;
+
+    // 多个文档共享同一个 arena 时的引用计数，创建时为 1
+    // remove_ref() 返回剩余的引用数，为 0 时由调用者销毁 arena
+    void add_ref(void) {refs_.fetch_add(1, std::memory_order_relaxed);}
+    uint32_t remove_ref(void) {return refs_.fetch_sub(1, std::memory_order_acq_rel) - 1;}
+    // 被共享时 arena 中的节点是只读的，修改前需要拷贝出来
+    bool is_shared(void) const {return refs_.load(std::memory_order_acquire) > 1;}
+
+private:
+    JsonArena(const JsonArena&);
+    JsonArena& operator=(const JsonArena&);
+
+    // 内存块的头部，数据紧跟在头部之后
+    struct Block {
+        Block *next;
+        std::size_t size;
+    };
+    void* allocate_block(std::size_t size, std::size_t align);
+
+private:
+    Block *head_;       // 当前使用的内存块，之前的内存块链在后面
+    char *pos_;
+    char *end_;
+    std::size_t block_size_;    // 下一个内存块的大小
+    std::size_t used_;
+    std::size_t capacity_;
+    std::atomic<uint32_t> refs_;
+};
+
+// 从 JsonArena 分配内存的 stl 分配器，arena 为空时使用 new/delete
+// 拷贝容器时不使用 arena，拷贝出来的值在文档销毁之后仍然可以使用
+template <typename T>
+class JsonAllocator {
+public:
+    typedef T value_type;
+
+public:
+    JsonAllocator(JsonArena *arena = nullptr) : arena_(arena) {}
+    template <typename U>
+    JsonAllocator(const JsonAllocator<U> &rhs) : arena_(rhs.arena()) {}
+
+    T* allocate(std::size_t n) {
+        if (arena_ != nullptr) {
+            return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T *ptr, std::size_t /*n*/) {
+        if (arena_ == nullptr) {
+            ::operator delete(ptr);
+        }
+    }
+
+    JsonAllocator select_on_container_copy_construction(void) const {return JsonAllocator();}
+    JsonArena* arena(void) const {return arena_;}
+
+private:
+    JsonArena *arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const JsonAllocator<T> &lhs, const JsonAllocator<U> &rhs) {return lhs.arena() == rhs.arena();}
+template <typename T, typename U>
+bool operator!=(const JsonAllocator<T> &lhs, const JsonAllocator<U> &rhs) {return lhs.arena() != rhs.arena();}
+
+}
+
+#endif
@@ -0,0 +1,465 @@
+#ifndef __JSON_BIND_H__
+#define __JSON_BIND_H__
+
+#include "basic_head.h"
+#include "wejson.h"
+#include "json_number.h"
+
+#include <map>
+#include <tuple>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 201703L
+#include <optional>
+#endif
+
+// 在结构体所在的命名空间中声明一次需要绑定的成员(成员需要可以从外部访问)，
+// 编译时生成该结构体专用的解码和编码过程:
+//  struct Order {
+//      int64_t id;
+//      std::string symbol;
+//      std::vector<double> prices;
+//  };
+//  JSON_BIND(Order, JSON_FIELD(id), JSON_FIELD(symbol), JSON_FIELD_NAMED(prices, "px"))
+#define JSON_FIELD(member)              ::basic::json_bind_field(#member, &json_bind_type::member)
+#define JSON_FIELD_NAMED(member, key)   ::basic::json_bind_field(key, &json_bind_type::member)
+// JSON_FIELD 通过 json_bind_type 引用成员，所以成员列表放在辅助的结构体中
+#define JSON_BIND(Type, ...)                                                \
+    struct json_bind_fields_##Type {                                        \
+        typedef Type json_bind_type;                                        \
+        static auto get(void) -> decltype(std::make_tuple(__VA_ARGS__)) {   \
+            return std::make_tuple(__VA_ARGS__);                            \
+        }                                                                   \
+    };                                                                      \
+    inline auto json_bind_fields(const Type*) -> decltype(json_bind_fields_##Type::get()) \
+    {                                                                       \
+        return json_bind_fields_##Type::get();                              \
+    }
+
+namespace basic {
+
+// 绑定的成员：json 中的 key 和成员指针
+template <typename Class, typename Member>
+struct JsonBindField {
+    const char *key;
+    ssize_t key_size;
+    Member Class::*member;
+};
+
+template <typename Class, typename Member, std::size_t N>
+constexpr JsonBindField<Class, Member>
+json_bind_field(const char (&key)[N], Member Class::*member)
+{
+    return JsonBindField<Class, Member>{key, static_cast<ssize_t>(N - 1), member};
+}
+
+// 直接在文本上按顺序读取 json 的游标，不构造中间的 json 树
+// 和 WeJson 一样允许 "//" 注释，字符串不处理转义，格式错误时抛出 std::runtime_error(包含出错的偏移)
+class JsonBindReader {
+public:
+    JsonBindReader(const char *data, ssize_t size);
+    ~JsonBindReader(void);
+
+    // 跳过空白和注释，返回下一个字符，到达结尾时返回 '\0'
+    char peek(void);
+    // 下一个值是 null 时跳过它并返回 true
+    bool read_null(void);
+    bool read_bool(void);
+    void read_number(JsonNumberLiteral &number);
+    // 引号中的内容，不拷贝
+    void read_string(const char *&str, ssize_t &size);
+    // 完整解析下一个值
+    void read_value(JsonValue &value);
+    // 通过括号匹配跳过下一个值
+    void skip_value(void);
+
+    // 读取 '{' 之后通过 next_member 依次读取成员的 key，读到 '}' 时返回 false
+    // first 在第一次调用前设置为 true
+    void begin_object(void);
+    bool next_member(bool &first, const char *&key, ssize_t &key_size);
+    // 读取 '[' 之后每个元素之前调用 next_element，读到 ']' 时返回 false
+    void begin_array(void);
+    bool next_element(bool &first);
+
+    // 已经读取的字节数
+    ssize_t offset(void) const {return pos_ - begin_;}
+    [[noreturn]] void throw_error(const char *what) const;
+
+private:
+    void expect(char ch);
+
+private:
+    const char *begin_;
+    const char *pos_;
+    const char *end_;
+};
+
+// 各类型的解码和编码，未绑定的类型在编译时报错
+template <typename T, typename Enable = void>
+struct JsonCodec {
+    static_assert(sizeof(T) == 0, "type is not bound to json, use JSON_BIND");
+};
+
+// 通过 ADL 查找 JSON_BIND 生成的 json_bind_fields
+template <typename T, typename Enable = void>
+struct JsonBound : std::false_type {};
+
+template <typename T>
+struct JsonBound<T, decltype(static_cast<void>(json_bind_fields(static_cast<const T*>(nullptr))))> : std::true_type {};
+
+// 解码 [data, data + size) 中的一个 json 值到 value，之后只能有空白，返回读取的字节数
+// 对象中没有绑定的 key 直接跳过，缺少的成员和 null 对应的成员保持原值，类型不匹配时抛出异常
+template <typename T>
+ssize_t json_decode(const char *data, ssize_t size, T &value);
+template <typename T>
+ssize_t json_decode(const std::string &json, T &value);
+
+// 把 value 的紧凑形式追加到 out，返回写入的字节数
+// 成员按 JSON_BIND 中声明的顺序输出，没有值的 std::optional 成员不输出
+template <typename T>
+ssize_t json_encode(const T &value, std::string &out);
+template <typename T>
+std::string json_encode(const T &value);
+
+//////////////////////////////////////////////////////////////
+
+template <>
+struct JsonCodec<bool> {
+    static void decode(JsonBindReader &reader, bool &value) {
+        if (!reader.read_null()) {
+            value = reader.read_bool();
+        }
+    }
+    static void encode(const bool &value, std::string &out) {
+        if (value) {
+            out.append("true", 4);
+        } else {
+            out.append("false", 5);
+        }
+    }
+};
+
+// 整数只接受范围内的整数字面量
+template <typename T>
+struct JsonCodec<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+    static void decode(JsonBindReader &reader, T &value) {
+        if (reader.read_null()) {
+            return ;
+        }
+
+        JsonNumberLiteral number;
+        reader.read_number(number);
+        if (number.kind == JSON_NUMBER_INT) {
+            bool in_range = std::is_signed<T>::value
+                ? (number.i >= static_cast<int64_t>(std::numeric_limits<T>::min()) && number.i <= static_cast<int64_t>(std::numeric_limits<T>::max()))
+                : (number.i >= 0 && static_cast<uint64_t>(number.i) <= static_cast<uint64_t>(std::numeric_limits<T>::max()));
+            if (in_range) {
+                value = static_cast<T>(number.i);
+                return ;
+            }
+        } else if (number.kind == JSON_NUMBER_UINT && number.u <= static_cast<uint64_t>(std::numeric_limits<T>::max())) {
+            value = static_cast<T>(number.u);
+            return ;
+        }
+        reader.throw_error("Number is not an integer in range");
+    }
+    static void encode(const T &value, std::string &out) {
+        char buf[JSON_NUMBER_BUFFER_SIZE];
+        char *end = std::is_signed<T>::value
+            ? format_json_int(static_cast<int64_t>(value), buf)
+            : format_json_uint(static_cast<uint64_t>(value), buf);
+        out.append(buf, end - buf);
+    }
+};
+
+template <typename T>
+struct JsonCodec<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    static void decode(JsonBindReader &reader, T &value) {
+        if (reader.read_null()) {
+            return ;
+        }
+
+        JsonNumberLiteral number;
+        reader.read_number(number);
+        switch (number.kind)
+        {
+            case JSON_NUMBER_INT:
+                value = static_cast<T>(number.i);
+                break;
+            case JSON_NUMBER_UINT:
+                value = static_cast<T>(number.u);
+                break;
+            default:
+                value = static_cast<T>(number.d);
+                break;
+        }
+    }
+    static void encode(const T &value, std::string &out) {
+        char buf[JSON_NUMBER_BUFFER_SIZE];
+        out.append(buf, format_json_double(static_cast<double>(value), buf) - buf);
+    }
+};
+
+// 枚举按底层的整数类型读写
+template <typename T>
+struct JsonCodec<T, typename std::enable_if<std::is_enum<T>::value>::type> {
+    typedef typename std::underlying_type<T>::type underlying_type;
+
+    static void decode(JsonBindReader &reader, T &value) {
+        underlying_type number = static_cast<underlying_type>(value);
+        JsonCodec<underlying_type>::decode(reader, number);
+        value = static_cast<T>(number);
+    }
+    static void encode(const T &value, std::string &out) {
+        JsonCodec<underlying_type>::encode(static_cast<underlying_type>(value), out);
+    }
+};
+
+// 和 JsonString 一样保存引号中的原始内容
+template <>
+struct JsonCodec<std::string> {
+    static void decode(JsonBindReader &reader, std::string &value) {
+        if (reader.read_null()) {
+            return ;
+        }
+
+        const char *str = nullptr;
+        ssize_t size = 0;
+        reader.read_string(str, size);
+        value.assign(str, size);
+    }
+    static void encode(const std::string &value, std::string &out) {
+        out += '"';
+        out.append(value);
+        out += '"';
+    }
+};
+
+// 结构中不确定的部分可以保存为 JsonValue
+template <>
+struct JsonCodec<JsonValue> {
+    static void decode(JsonBindReader &reader, JsonValue &value) {
+        reader.read_value(value);
+    }
+    static void encode(const JsonValue &value, std::string &out);
+};
+
+// 解码时清空原有的元素
+template <typename T>
+struct JsonCodec<std::vector<T>> {
+    static void decode(JsonBindReader &reader, std::vector<T> &value) {
+        if (reader.read_null()) {
+            return ;
+        }
+
+        value.clear();
+        reader.begin_array();
+        bool first = true;
+        while (reader.next_element(first)) {
+            value.emplace_back();
+            JsonCodec<T>::decode(reader, value.back());
+        }
+    }
+    static void encode(const std::vector<T> &value, std::string &out) {
+        out += '[';
+        for (std::size_t i = 0; i < value.size(); ++i) {
+            if (i > 0) {
+                out += ',';
+            }
+            JsonCodec<T>::encode(value[i], out);
+        }
+        out += ']';
+    }
+};
+
+// key 不固定的对象
+template <typename T>
+struct JsonCodec<std::map<std::string, T>> {
+    static void decode(JsonBindReader &reader, std::map<std::string, T> &value) {
+        if (reader.read_null()) {
+            return ;
+        }
+
+        value.clear();
+        reader.begin_object();
+        bool first = true;
+        const char *key = nullptr;
+        ssize_t key_size = 0;
+        while (reader.next_member(first, key, key_size)) {
+            JsonCodec<T>::decode(reader, value[std::string(key, key_size)]);
+        }
+    }
+    static void encode(const std::map<std::string, T> &value, std::string &out) {
+        out += '{';
+        for (auto iter = value.begin(); iter != value.end(); ++iter) {
+            if (iter != value.begin()) {
+                out += ',';
+            }
+            JsonCodec<std::string>::encode(iter->first, out);
+            out += ':';
+            JsonCodec<T>::encode(iter->second, out);
+        }
+        out += '}';
+    }
+};
+
+// 成员是否需要输出
+template <typename Member>
+inline bool json_bind_present(const Member&) {return true;}
+
+#if __cplusplus >= 201703L
+// null 时清空，编码时没有值的成员不输出
+template <typename T>
+struct JsonCodec<std::optional<T>> {
+    static void decode(JsonBindReader &reader, std::optional<T> &value) {
+        if (reader.read_null()) {
+            value.reset();
+            return ;
+        }
+        if (!value) {
+            value.emplace();
+        }
+        JsonCodec<T>::decode(reader, *value);
+    }
+    static void encode(const std::optional<T> &value, std::string &out) {
+        if (value) {
+            JsonCodec<T>::encode(*value, out);
+        } else {
+            out.append("null", 4);
+        }
+    }
+};
+
+template <typename Member>
+inline bool json_bind_present(const std::optional<Member> &value) {return value.has_value();}
+#endif
+
+// JSON_BIND 绑定的结构体
+template <typename T>
+struct JsonCodec<T, typename std::enable_if<JsonBound<T>::value>::type> {
+    static void decode(JsonBindReader &reader, T &value) {
+        if (reader.read_null()) {
+            return ;
+        }
+
+        const fields_type fields = json_bind_fields(static_cast<const T*>(nullptr));
+        reader.begin_object();
+        bool first = true;
+        const char *key = nullptr;
+        ssize_t key_size = 0;
+        while (reader.next_member(first, key, key_size)) {
+            if (!decode_member<0>(reader, value, fields, key, key_size)) {
+                reader.skip_value();
+            }
+        }
+    }
+
+    static void encode(const T &value, std::string &out) {
+        const fields_type fields = json_bind_fields(static_cast<const T*>(nullptr));
+        out += '{';
+        bool first = true;
+        encode_member<0>(value, out, first, fields);
+        out += '}';
+    }
+
+private:
+    typedef decltype(json_bind_fields(static_cast<const T*>(nullptr))) fields_type;
+    static const std::size_t field_count = std::tuple_size<fields_type>::value;
+
+    // 按声明的顺序逐个比较 key，匹配后不再比较剩余的成员，I 到达成员数量时结束递归
+    template <std::size_t I>
+    static typename std::enable_if<(I < field_count), bool>::type
+    decode_member(JsonBindReader &reader, T &value, const fields_type &fields, const char *key, ssize_t key_size) {
+        return decode_field(reader, value, std::get<I>(fields), key, key_size)
+            || decode_member<I + 1>(reader, value, fields, key, key_size);
+    }
+
+    template <std::size_t I>
+    static typename std::enable_if<(I == field_count), bool>::type
+    decode_member(JsonBindReader&, T&, const fields_type&, const char*, ssize_t) {
+        return false;
+    }
+
+    template <typename Member>
+    static bool decode_field(JsonBindReader &reader, T &value, const JsonBindField<T, Member> &field, const char *key, ssize_t key_size) {
+        if (field.key_size != key_size || memcmp(field.key, key, key_size) != 0) {
+            return false;
+        }
+        JsonCodec<Member>::decode(reader, value.*field.member);
+        return true;
+    }
+
+    template <std::size_t I>
+    static typename std::enable_if<(I < field_count)>::type
+    encode_member(const T &value, std::string &out, bool &first, const fields_type &fields) {
+        encode_field(value, out, first, std::get<I>(fields));
+        encode_member<I + 1>(value, out, first, fields);
+    }
+
+    template <std::size_t I>
+    static typename std::enable_if<(I == field_count)>::type
+    encode_member(const T&, std::string&, bool&, const fields_type&) {
+    }
+
+    template <typename Member>
+    static void encode_field(const T &value, std::string &out, bool &first, const JsonBindField<T, Member> &field) {
+        if (!json_bind_present(value.*field.member)) {
+            return ;
+        }
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+        out += '"';
+        out.append(field.key, field.key_size);
+        out.append("\":", 2);
+        JsonCodec<Member>::encode(value.*field.member, out);
+    }
+};
+
+//////////////////////////////////////////////////////////////
+
+template <typename T>
+ssize_t
+json_decode(const char *data, ssize_t size, T &value)
+{
+    JsonBindReader reader(data, size);
+    JsonCodec<T>::decode(reader, value);
+    if (reader.peek() != '\0') {
+        reader.throw_error("Unexpected content after json value");
+    }
+
+    return reader.offset();
+}
+
+template <typename T>
+ssize_t
+json_decode(const std::string &json, T &value)
+{
+    return json_decode(json.data(), static_cast<ssize_t>(json.size()), value);
+}
+
+template <typename T>
+ssize_t
+json_encode(const T &value, std::string &out)
+{
+    std::size_t old_size = out.size();
+    JsonCodec<T>::encode(value, out);
+
+    return static_cast<ssize_t>(out.size() - old_size);
+}
+
+template <typename T>
+std::string
+json_encode(const T &value)
+{
+    std::string out;
+    json_encode(value, out);
+
+    return out;
+}
+
+}
+
+#endif
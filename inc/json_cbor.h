@@ -0,0 +1,137 @@
+#ifndef __JSON_CBOR_H__
+#define __JSON_CBOR_H__
+
+#include "basic_head.h"
+#include "byte_buffer.h"
+#include "json_parser.h"
+
+namespace basic {
+
+// json 树和 CBOR(RFC 8949) 之间的转换，数值按二进制保存，不需要格式化和解析文本
+// json 字符串保存的是转义后的文本(和 JsonString 一样)，CBOR 的文本字符串保存原始的 UTF-8：
+// 编码时先去掉转义(包括 \uXXXX)，解码时再对 '"'、'\' 和控制字符转义
+
+// 把 JsonHandler 的事件或是 json 树编码为 CBOR，追加到 out
+// 通过事件编码时不知道容器的大小，对象和数组使用不定长形式(以 0xff 结束)；编码 json 树时使用定长形式
+// 整数使用最短的编码，double 可以无损转换为 float 时使用 4 字节的 float
+class CborEncoder : public JsonHandler {
+public:
+    explicit CborEncoder(std::string &out);
+    virtual ~CborEncoder(void);
+
+    // 编码一个完整的 json 树
+    void encode(const JsonValue &value);
+
+    virtual bool start_object(void) override;
+    virtual bool key(const char *str, ssize_t size) override;
+    virtual bool end_object(void) override;
+    virtual bool start_array(void) override;
+    virtual bool end_array(void) override;
+
+    virtual bool string(const char *str, ssize_t size) override;
+    virtual bool number(double value) override;
+    virtual bool integer(int64_t value) override;
+    virtual bool unsigned_integer(uint64_t value) override;
+    virtual bool boolean(bool value) override;
+    virtual bool null(void) override;
+
+private:
+    // 数据项的类型和参数，参数按最短的形式编码
+    void write_head(uint8_t major, uint64_t value);
+    void write_text(const char *str, ssize_t size);
+    void write_double(double value);
+
+private:
+    std::string &out_;
+    // 去掉转义之后的文本
+    std::string unescaped_;
+};
+
+// 增量解码一个 CBOR 数据项，数据可以分成任意多段传入，解码事件交给 JsonHandler 处理
+// 支持定长和不定长的数组、映射和文本字符串，标签(tag)被忽略，undefined 作为 null
+// 字节字符串、非文本的 key 和其他简单值不能表示为 json，和格式错误一样抛出 std::runtime_error，
+// 之后需要 reset() 才能继续使用
+class CborStreamParser {
+public:
+    explicit CborStreamParser(JsonHandler &handler);
+    ~CborStreamParser(void);
+
+    // 返回本次消耗的字节数，数据项结束之后的数据不会被消耗(属于下一个数据项)
+    // handler 中止解析时返回 -1
+    ssize_t feed(const char *data, ssize_t size);
+    // 消耗的数据从 buff 中移除
+    ssize_t feed(ByteBuffer &buff);
+
+    bool is_complete(void) const {return state_ == STATE_DONE;}
+    bool need_more(void) const {return state_ != STATE_DONE && state_ != STATE_STOPPED && state_ != STATE_ERROR;}
+    // 从上次 reset() 开始消耗的总字节数
+    ssize_t consumed(void) const {return consumed_;}
+    void reset(void);
+
+private:
+    enum State {
+        STATE_HEAD,         // 等待数据项的开头
+        STATE_HEAD_PART,    // 数据项的开头(类型和参数)跨越了两段数据
+        STATE_STRING,       // 文本字符串的内容跨越了两段数据
+        STATE_DONE,
+        STATE_STOPPED,      // handler 中止了解析
+        STATE_ERROR
+    };
+
+    // 没有结束的数组或映射
+    struct Frame {
+        uint64_t remaining;     // 剩余的元素或成员数量，不定长时不使用
+        bool indefinite;
+        bool is_map;
+        bool expect_key;        // 映射中下一个数据项是 key
+    };
+
+    // 以下函数返回 false 表示 handler 中止了解析
+    bool parse_head(const char *&pos, const char *end);
+    bool process_head(uint8_t head, uint64_t value, const char *&pos, const char *end);
+    bool parse_string(const char *&pos, const char *end);
+    // 文本字符串转义后作为 key 或是值交给 handler
+    bool emit_text(const char *str, ssize_t size);
+    bool start_container(bool is_map, uint8_t info, uint64_t value);
+    bool emit_break(void);
+    // 一个完整的值结束之后更新外层容器，容器结束时继续向外更新
+    bool value_done(void);
+
+    bool expect_key(void) const {return !stack_.empty() && stack_.back().is_map && stack_.back().expect_key;}
+    void throw_error(const char *what, const char *pos);
+
+private:
+    JsonHandler &handler_;
+    State state_;
+    const char *chunk_;
+    ssize_t consumed_;
+    std::vector<Frame> stack_;
+
+    // 跨越数据段的数据项开头
+    uint8_t head_[9];
+    int head_size_;
+    int head_need_;
+    // 跨越数据段或是分块的文本字符串
+    std::string buffer_;
+    uint64_t string_left_;
+    // 正在读取不定长文本字符串的分块
+    bool chunked_;
+    // 转义之后的文本
+    std::string escaped_;
+};
+
+// 把 json 树编码为 CBOR 追加到 out，返回写入的字节数
+ssize_t cbor_encode(const JsonValue &value, std::string &out);
+ssize_t cbor_encode(const JsonValue &value, ByteBuffer &out);
+// 解码 data 开头的一个 CBOR 数据项到 value(值在堆上创建)，返回消耗的字节数，不修改 data
+// 数据不完整或格式错误时抛出 std::runtime_error
+ssize_t cbor_decode(const char *data, ssize_t size, JsonValue &value);
+ssize_t cbor_decode(const ByteBuffer &data, JsonValue &value);
+// 直接把 json 文本转码为 CBOR，不构建 json 树，返回写入的字节数
+// 和 JsonParser::parse_document 一样跳过开头不属于 json 的内容
+ssize_t json_to_cbor(const char *data, ssize_t size, std::string &out);
+ssize_t json_to_cbor(const char *data, ssize_t size, ByteBuffer &out);
+
+}
+
+#endif
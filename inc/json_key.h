@@ -0,0 +1,135 @@
+#ifndef __JSON_KEY_H__
+#define __JSON_KEY_H__
+
+#include "basic_head.h"
+#include "json_arena.h"
+
+#include <mutex>
+
+#define JSON_KEY_TABLE_SHARDS   16      // JsonKeyTable 按哈希值分片加锁的数量
+#define JSON_KEY_INLINE_SIZE    15      // 直接保存在 JsonKey 中的 key 的最大长度
+
+namespace basic {
+
+class JsonKeyTable;
+
+// 对象成员的 key，字符串以 '\0' 结尾
+// 不超过 JSON_KEY_INLINE_SIZE 个字符的 key 直接保存在 JsonKey 中，
+// 更长的保存在 arena、堆或是 JsonKeyTable(驻留)中：
+//  拷贝驻留的 key 只复制指针，arena 和堆上的 key 拷贝时复制到堆上
+//  同一个 JsonKeyTable 中驻留的 key 只需要比较指针
+class JsonKey {
+public:
+    JsonKey(void);
+    // 复制字符串，arena 不为空时保存在 arena 中
+    JsonKey(const char *str, std::size_t size, JsonArena *arena = nullptr);
+    explicit JsonKey(const std::string &str);
+    JsonKey(const JsonKey &rhs);
+    JsonKey(JsonKey &&rhs) noexcept;
+    ~JsonKey(void);
+
+    JsonKey& operator=(const JsonKey &rhs);
+    JsonKey& operator=(JsonKey &&rhs) noexcept;
+
+    const char* data(void) const {return storage_ == KEY_INLINE ? buf_ : ptr_;}
+    const char* c_str(void) const {return this->data();}
+    std::size_t size(void) const {return size_;}
+    bool empty(void) const {return size_ == 0;}
+    std::string to_string(void) const {return std::string(this->data(), size_);}
+    // 兼容 key 是 std::string 时的用法，如 std::string key = iter->first;
+    operator std::string(void) const {return this->to_string();}
+
+    // 是否保存在 JsonKeyTable 中
+    bool is_interned(void) const {return storage_ == KEY_INTERNED;}
+    // 驻留的 key 直接返回驻留时计算的哈希值
+    std::size_t hash(void) const;
+    // 对象的哈希索引和 JsonKeyTable 使用的哈希函数(FNV-1a)
+    static std::size_t hash_string(const char *str, std::size_t size);
+
+    bool equals(const char *str, std::size_t size) const {
+        return size_ == size && memcmp(this->data(), str, size) == 0;
+    }
+    bool operator==(const JsonKey &rhs) const;
+    bool operator!=(const JsonKey &rhs) const {return !(*this == rhs);}
+    bool operator<(const JsonKey &rhs) const;
+
+private:
+    friend class JsonKeyTable;
+
+    enum KeyStorage {
+        KEY_INLINE = 0,     // 字符串在 buf_ 中
+        KEY_ARENA = 1,      // 字符串在 arena 中，不需要释放
+        KEY_HEAP = 2,       // 字符串在堆上，析构时释放
+        KEY_INTERNED = 3    // 字符串在 JsonKeyTable 中
+    };
+
+    void release(void);
+    // 接管 rhs 的字符串，rhs 变为空字符串
+    void take(JsonKey &rhs);
+
+private:
+    union {
+        const char *ptr_;
+        char buf_[JSON_KEY_INLINE_SIZE + 1];
+    };
+    uint32_t size_;
+    uint32_t storage_;  // KeyStorage
+};
+
+bool operator==(const JsonKey &lhs, const std::string &rhs);
+bool operator==(const std::string &lhs, const JsonKey &rhs);
+bool operator!=(const JsonKey &lhs, const std::string &rhs);
+bool operator!=(const std::string &lhs, const JsonKey &rhs);
+std::ostream& operator<<(std::ostream &os, const JsonKey &key);
+
+// 线程安全的 key 驻留表，可以被多个文档和多个线程共享
+// 相同的字符串只保存一份，直到 JsonKeyTable 销毁时才释放，所以 JsonKeyTable 需要比使用它的文档活得更久
+// 按哈希值分成 JSON_KEY_TABLE_SHARDS 个分片，每个分片有自己的互斥锁
+// 适合 key 的种类有限、重复出现很多次的数据，key 的种类不受控制时(例如用户 id 作为 key)不要使用
+class JsonKeyTable {
+public:
+    JsonKeyTable(void);
+    ~JsonKeyTable(void);
+
+    // 返回驻留的 key，第一次出现时复制字符串
+    JsonKey intern(const char *str, std::size_t size);
+    JsonKey intern(const std::string &str) {return this->intern(str.data(), str.size());}
+
+    // 驻留的 key 的数量和字符串占用的内存
+    std::size_t size(void) const;
+    std::size_t memory_size(void) const;
+
+    // 进程内共享的驻留表，不会被销毁
+    static JsonKeyTable& global(void);
+
+private:
+    friend class JsonKey;
+
+    struct Entry {
+        const JsonKeyTable *table;
+        std::size_t hash;
+        std::size_t size;
+        char data[1];
+    };
+    // 开放寻址的哈希表
+    struct Shard {
+        mutable std::mutex mutex;
+        std::vector<Entry*> slots;
+        std::size_t count;
+        std::size_t memory;
+    };
+
+    static const Entry* get_entry(const char *data) {
+        return reinterpret_cast<const Entry*>(data - offsetof(Entry, data));
+    }
+
+    JsonKeyTable(const JsonKeyTable&);
+    JsonKeyTable& operator=(const JsonKeyTable&);
+
+private:
+    Shard shards_[JSON_KEY_TABLE_SHARDS];
+};
+
+}
+
+#endif
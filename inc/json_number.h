@@ -0,0 +1,43 @@
+#ifndef __JSON_NUMBER_H__
+#define __JSON_NUMBER_H__
+
+#include "basic_head.h"
+
+#define JSON_NUMBER_BUFFER_SIZE     32      // 输出数值需要的缓冲区大小
+
+namespace basic {
+
+// json 数值字面量保存的精确类型
+enum JsonNumberKind {
+    JSON_NUMBER_DOUBLE = 0,     // 带小数点或指数，或是超出 64 位整数范围
+    JSON_NUMBER_INT = 1,        // 在 int64_t 范围内的整数
+    JSON_NUMBER_UINT = 2        // 大于 INT64_MAX 的 uint64_t 整数
+};
+
+// 解析 json 数值字面量的结果
+struct JsonNumberLiteral {
+    JsonNumberKind kind;
+    union {
+        double d;
+        int64_t i;
+        uint64_t u;
+    };
+};
+
+// 直接在输入字节上解析 [begin, end) 开头的数值(允许开头的 '+' 和指数)，不需要以 '\0' 结尾
+// 整数在 64 位范围内时保存精确值，其他情况用 Eisel-Lemire 算法转换为最接近的 double，
+// 极少数无法判断舍入方向的情况再交给 strtod
+// 返回数值之后的位置；格式错误时返回 nullptr，error 指向错误的原因
+const char* parse_json_number(const char *begin, const char *end, JsonNumberLiteral &number, const char **error = nullptr);
+
+// 以下函数把数值写入 buf(至少 JSON_NUMBER_BUFFER_SIZE 个字节)，返回写入内容的结尾，不添加 '\0'
+// double 使用 Grisu2 算法输出能还原出原值的最短(或接近最短)的十进制形式，
+// 指数在 [-6, 21) 之间时不使用科学计数法；NaN 和无穷大不能用 json 表示，输出 null
+char* format_json_double(double value, char *buf);
+// 整数每次输出两位数字
+char* format_json_int(int64_t value, char *buf);
+char* format_json_uint(uint64_t value, char *buf);
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef __JSON_PARSER_H__
+#define __JSON_PARSER_H__
+
+#include "basic_head.h"
+#include "wejson.h"
+#include "json_structural.h"
+
+#include <deque>
+
+namespace basic {
+
+// 事件驱动的解析接口，JsonParser 按照文本的顺序调用对应的函数，不构建 json 树
+// 回调返回 false 时停止解析；默认实现忽略事件，只需要重写关心的事件
+// 字符串和 key 指向输入文本中引号内的内容(和 JsonString 一样不处理转义)，回调返回后不能再使用
+class JsonHandler {
+public:
+    virtual ~JsonHandler(void) {}
+
+    virtual bool start_object(void) {return true;}
+    virtual bool key(const char * /*str*/, ssize_t /*size*/) {return true;}
+    virtual bool end_object(void) {return true;}
+    virtual bool start_array(void) {return true;}
+    virtual bool end_array(void) {return true;}
+
+    virtual bool string(const char * /*str*/, ssize_t /*size*/) {return true;}
+    virtual bool number(double /*value*/) {return true;}
+    // 整数在 int64_t/uint64_t 范围内时调用，默认转为 double 交给 number()
+    virtual bool integer(int64_t value) {return this->number(static_cast<double>(value));}
+    virtual bool unsigned_integer(uint64_t value) {return this->number(static_cast<double>(value));}
+    virtual bool boolean(bool /*value*/) {return true;}
+    virtual bool null(void) {return true;}
+};
+
+// 根据解析事件构建 json 树，结果写入构造时传入的 value
+// arena 不为空时 json 树中的值都在 arena 中创建，arena 需要在 value 析构之后才能释放
+// key_table 不为空时对象的 key 驻留在其中，否则和值一样保存在 arena 或堆上
+class JsonDomBuilder : public JsonHandler {
+public:
+    explicit JsonDomBuilder(JsonValue &value, JsonArena *arena = nullptr, JsonKeyTable *key_table = nullptr);
+    virtual ~JsonDomBuilder(void);
+
+    virtual bool start_object(void) override;
+    virtual bool key(const char *str, ssize_t size) override;
+    virtual bool end_object(void) override;
+    virtual bool start_array(void) override;
+    virtual bool end_array(void) override;
+
+    virtual bool string(const char *str, ssize_t size) override;
+    virtual bool number(double value) override;
+    virtual bool integer(int64_t value) override;
+    virtual bool unsigned_integer(uint64_t value) override;
+    virtual bool boolean(bool value) override;
+    virtual bool null(void) override;
+
+private:
+    // 返回下一个值要写入的位置：根节点、对象的成员或是数组的元素
+    JsonValue& next_value(void);
+
+private:
+    struct Frame {
+        JsonValue *value;
+    };
+
+    JsonValue &root_;
+    JsonArena *arena_;
+    JsonKeyTable *key_table_;
+    std::vector<Frame> stack_;
+    JsonKey key_;
+    // 对象的成员按所在的层次暂存，结束时一次放入对象，暂存区在同一层的对象之间重复使用
+    // 使用 deque 保证暂存的成员不会因为扩容而移动(stack_ 中保存了指向暂存值的指针)
+    std::vector<std::deque<JsonObject::member_type>> members_;
+    // 数组的元素同样按层次暂存，结束时一次放入数组
+    std::vector<std::deque<JsonValue>> items_;
+};
+
+// 在一段连续内存上单遍解析 json 文本，不需要预先去掉空白和注释
+// 空白和 "//" 开头的注释在解析过程中直接跳过，解析失败时抛出 std::runtime_error
+// 较大的文本先用 build_structural_index() 构建结构索引，再沿着索引产生解析事件
+class JsonParser {
+public:
+    JsonParser(const char *data, ssize_t size);
+    ~JsonParser(void);
+
+    // 从当前位置开始解析一个 json 值，返回解析结束的位置(相对于 data 的偏移)
+    ssize_t parse(JsonValue &value);
+    // 解析事件交给 handler 处理，handler 中止解析时返回 -1
+    ssize_t parse(JsonHandler &handler);
+    // 跳过开头不属于 json 的内容，从第一个 '{' 或 '[' 开始解析
+    ssize_t parse_document(JsonValue &value);
+    ssize_t parse_document(JsonHandler &handler);
+    // 是否使用结构索引，默认文本大于 JSON_STRUCTURAL_INDEX_MIN_SIZE 时使用
+    void set_use_index(bool use_index) {use_index_ = use_index;}
+
+private:
+    // 返回 false 表示 handler 中止了解析
+    bool parse_value(JsonHandler &handler);
+    bool parse_object(JsonHandler &handler);
+    bool parse_array(JsonHandler &handler);
+    // 返回引号中的内容，pos_ 移动到结尾引号之后
+    void parse_string(const char *&str, ssize_t &size);
+    bool parse_number(JsonHandler &handler);
+    void parse_literal(const char *literal, ssize_t size);
+
+    // 跳过空白和注释，返回下一个字符，到达结尾时返回 '\0'
+    char skip_whitespace(void);
+    void expect(char ch);
+    // 数值、true、false、null 之后必须是分隔字符
+    void check_value_end(void);
+    void throw_error(const char *what);
+
+private:
+    const char *begin_;
+    const char *pos_;
+    const char *end_;
+
+    // 结构索引，index_ 中的偏移相对于 index_base_，next_ 是下一个未处理的位置
+    bool use_index_;
+    bool has_index_;
+    std::vector<uint32_t> index_;
+    const char *index_base_;
+    std::size_t next_;
+};
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef __JSON_PATH_H__
+#define __JSON_PATH_H__
+
+#include "basic_head.h"
+#include "wejson.h"
+#include "lazy_json.h"
+
+namespace basic {
+
+// 预先编译的路径，解析一次之后可以在多个文档上重复查找
+// 支持两种写法：
+//  JSON Pointer(RFC 6901)：空字符串表示根节点，"/a/b/0"，key 中的 '~' 和 '/' 写成 "~0" 和 "~1"
+//  点号路径："a.b[0].c"，[n] 只匹配数组的下标，["k"] 或 ['k'] 表示包含 '.' 或 '[' 的 key
+// 纯数字的段(例如 "/a/0" 或 "a.0")在对象中是 key，在数组中是下标
+// key 和文本中的内容直接比较，不处理转义
+class JsonPath {
+public:
+    // 根节点
+    JsonPath(void);
+    // '/' 开头或是空字符串按 JSON Pointer 解析，其他的按点号路径解析，格式错误时抛出 std::runtime_error
+    explicit JsonPath(const std::string &path);
+    ~JsonPath(void);
+
+    static JsonPath from_pointer(const std::string &pointer);
+    static JsonPath from_dotted(const std::string &path);
+
+    // 查找路径对应的值，找不到时返回 nullptr，不抛出异常
+    // 非 const 的版本通过 get_object()/get_array() 访问，只复制被共享的路径(写时复制)
+    const JsonValue* find(const JsonValue &root) const;
+    JsonValue* find(JsonValue &root) const;
+    // 在按需解析的文本中查找，找不到时返回的值 valid() 为 false
+    LazyJsonValue find(const LazyJsonValue &root) const;
+
+    // 段的数量，根节点为 0
+    std::size_t size(void) const {return tokens_.size();}
+    // 转换为 JSON Pointer 的写法
+    std::string to_pointer(void) const;
+
+    bool operator==(const JsonPath &rhs) const;
+    bool operator!=(const JsonPath &rhs) const {return !(*this == rhs);}
+
+private:
+    friend class JsonPathExtractor;
+
+    struct Token {
+        std::string key;
+        int64_t index;      // 可以作为数组下标时大于等于 0，否则为 -1
+        bool index_only;    // "[n]" 只匹配数组
+
+        bool operator==(const Token &rhs) const {
+            return key == rhs.key && index == rhs.index && index_only == rhs.index_only;
+        }
+        // 是否匹配对象中的 key
+        bool match_key(const char *str, std::size_t size) const {
+            return !index_only && key.size() == size && memcmp(key.data(), str, size) == 0;
+        }
+    };
+
+    // 纯数字并且没有多余的前导 0 时返回下标，否则返回 -1
+    static int64_t parse_index(const std::string &str);
+
+private:
+    std::vector<Token> tokens_;
+};
+
+// 在 json 文本中单遍扫描，一次取出多条路径的值，不构建 json 树
+// 路径按段合并成前缀树，扫描时只进入路径经过的对象和数组，其他的值通过括号匹配跳过，
+// 所有路径都找到之后不再扫描剩余的文本
+// 适合每条消息都要取出相同几个字段的场景：创建一次，在多个线程中同时调用 extract
+class JsonPathExtractor {
+public:
+    JsonPathExtractor(void);
+    ~JsonPathExtractor(void);
+
+    // 添加路径，返回路径的序号，结果按照这个序号保存
+    std::size_t add(const JsonPath &path);
+    std::size_t add(const std::string &path);
+    // 路径的数量
+    std::size_t size(void) const {return path_count_;}
+
+    // results[i] 是第 i 条路径的值，指向 data 中的文本，找不到时 valid() 为 false
+    // 返回找到的路径数量，文本格式错误时抛出 std::runtime_error
+    ssize_t extract(const char *data, ssize_t size, std::vector<LazyJsonValue> &results) const;
+    ssize_t extract(const std::string &data, std::vector<LazyJsonValue> &results) const;
+    ssize_t extract(const LazyJsonValue &root, std::vector<LazyJsonValue> &results) const;
+
+private:
+    // 前缀树的节点，nodes_[0] 是根节点
+    struct Node {
+        JsonPath::Token token;
+        std::vector<uint32_t> children;     // 子节点在 nodes_ 中的位置
+        std::vector<uint32_t> paths;        // 在这个节点结束的路径的序号
+        int64_t max_index;                  // 子节点中最大的数组下标，没有时为 -1
+        std::size_t key_children;           // 可以匹配对象 key 的子节点数量
+    };
+
+    // 返回 true 表示所有路径都已经找到
+    bool scan(const Node &node, const LazyJsonValue &value, std::vector<LazyJsonValue> &results, std::size_t &found) const;
+
+private:
+    std::vector<Node> nodes_;
+    std::size_t path_count_;
+};
+
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef __JSON_STREAM_PARSER_H__
+#define __JSON_STREAM_PARSER_H__
+
+#include "basic_head.h"
+#include "byte_buffer.h"
+#include "json_parser.h"
+
+namespace basic {
+
+// 增量解析 json 文档，数据可以分成任意多段传入(例如直接从 socket 收到的 ByteBuffer)
+// 解析状态保存在对象中，每次 feed 从上一段结束的地方继续，解析事件交给 JsonHandler 处理
+// 和 JsonParser::parse_document 一样跳过开头不属于 json 的内容，从第一个 '{' 或 '[' 开始
+// 格式错误时抛出 std::runtime_error，之后需要 reset() 才能继续使用
+class JsonStreamParser {
+public:
+    explicit JsonStreamParser(JsonHandler &handler);
+    ~JsonStreamParser(void);
+
+    // 返回本次消耗的字节数，文档结束之后的数据不会被消耗(属于下一个文档)
+    // handler 中止解析时返回 -1
+    ssize_t feed(const char *data, ssize_t size);
+    // 消耗的数据从 buff 中移除
+    ssize_t feed(ByteBuffer &buff);
+
+    // 文档已经解析完成
+    bool is_complete(void) const {return state_ == STATE_DONE;}
+    // 文档还没有结束，需要继续传入数据
+    bool need_more(void) const {return state_ != STATE_DONE && state_ != STATE_STOPPED && state_ != STATE_ERROR;}
+    // 从上次 reset() 开始消耗的总字节数
+    ssize_t consumed(void) const {return consumed_;}
+    // 清除解析状态，开始解析下一个文档
+    void reset(void);
+
+private:
+    enum State {
+        STATE_START,        // 跳过开头不属于 json 的内容
+        STATE_VALUE,        // 等待一个值
+        STATE_ARRAY_FIRST,  // '[' 之后，等待一个值或是 ']'
+        STATE_OBJECT_FIRST, // '{' 之后，等待 key 或是 '}'
+        STATE_OBJECT_KEY,   // 对象中 ',' 之后，等待 key
+        STATE_COLON,        // key 之后，等待 ':'
+        STATE_AFTER_VALUE,  // 值之后，等待 ',' 或是结束括号
+        STATE_DONE,
+        STATE_STOPPED,      // handler 中止了解析
+        STATE_ERROR
+    };
+
+    // 可能跨越两段数据的部分
+    enum Token {
+        TOKEN_NONE,
+        TOKEN_STRING,
+        TOKEN_KEY,
+        TOKEN_NUMBER,
+        TOKEN_LITERAL,
+        TOKEN_SLASH,    // 遇到了 '/'，等待注释的第二个 '/'
+        TOKEN_COMMENT   // "//" 开头的注释，直到行尾
+    };
+
+    // 以下函数处理 pos 处的数据并向后移动 pos，返回 false 表示 handler 中止了解析
+    bool parse_char(const char *&pos, const char *end);
+    bool start_value(const char *&pos, const char *end);
+    // 继续处理当前的 token，到达 end 时把内容保存到 buffer_ 中
+    bool parse_token(const char *&pos, const char *end);
+    bool emit_token(Token token, const char *str, ssize_t size, const char *pos);
+
+    void start_token(Token token);
+    // 一个完整的值结束之后更新状态
+    void value_done(void);
+    void throw_error(const char *what, const char *pos);
+
+private:
+    JsonHandler &handler_;
+    State state_;
+    Token token_;
+    // 当前数据段的开始，用来计算错误的位置
+    const char *chunk_;
+    ssize_t consumed_;
+    // 没有结束的容器，'{' 或是 '['
+    std::vector<char> stack_;
+
+    // 跨越数据段的内容拷贝到 buffer_ 中，buffered_ 表示当前 token 的开头在之前的数据段中
+    std::string buffer_;
+    bool buffered_;
+    // 字符串中上一个字符是 '\'
+    bool escaped_;
+};
+
+}
+
+#endif
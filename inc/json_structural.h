@@ -0,0 +1,21 @@
+#ifndef __JSON_STRUCTURAL_H__
+#define __JSON_STRUCTURAL_H__
+
+#include "basic_head.h"
+
+namespace basic {
+
+// 文本大于该大小时 JsonParser 才会先构建结构索引，小文本直接逐字符解析更快
+#define JSON_STRUCTURAL_INDEX_MIN_SIZE  4096
+
+// 构建 json 文本的结构索引(每次处理 64 个字节，运行时选择 AVX2/SSE2 或普通实现)
+// index 中按顺序保存以下字符相对于 data 的偏移:
+//  1. 字符串外的 '{' '}' '[' ']' ':' ','
+//  2. 字符串开头和结尾的 '"'，两者在 index 中相邻
+//  3. 数值、true、false、null 等值的第一个字符
+// 文本中有字符串外的 '/'(注释) 或是大于 4GB 时返回 false，需要逐字符解析
+bool build_structural_index(const char *data, ssize_t size, std::vector<uint32_t> &index);
+
+}
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef __JSON_TAPE_H__
+#define __JSON_TAPE_H__
+
+#include "basic_head.h"
+#include "json_parser.h"
+
+#define JSON_TAPE_VERSION       1
+
+namespace basic {
+
+// tape 文件的头部，之后依次是 tape 和字符串区，所有字段按本机字节序(小端)保存
+struct JsonTapeHeader {
+    char magic[8];          // "WEJTAPE"
+    uint32_t version;       // JSON_TAPE_VERSION
+    uint32_t header_size;   // sizeof(JsonTapeHeader)
+    uint64_t source_size;   // 生成 tape 的源文件的大小
+    uint64_t source_hash;   // 源文件内容的 json_tape_hash()
+    uint64_t tape_size;     // tape 中 64 位字的数量
+    uint64_t string_size;   // 字符串区的字节数
+    uint64_t reserved;
+    uint64_t header_hash;   // 以上字段的 json_tape_hash()，检查头部是否被破坏
+};
+
+// 64 位的 hash(XXH64，seed 为 0)，用来判断源文件是否发生了变化
+uint64_t json_tape_hash(const char *data, ssize_t size);
+
+class JsonTape;
+class JsonTapeIterator;
+
+// tape 中的一个值，只保存 tape 和值的位置，不拷贝内容，在 JsonTape 销毁或是重新加载之前有效
+// 接口和 LazyJsonValue 相同，类型不一致或是找不到时抛出 std::runtime_error
+class JsonTapeValue {
+    friend class JsonTape;
+    friend class JsonTapeIterator;
+public:
+    typedef JsonTapeIterator iterator;
+public:
+    JsonTapeValue(void);
+    ~JsonTapeValue(void);
+
+    ValueType type(void) const;
+    bool valid(void) const {return tape_ != nullptr;}
+
+    // 按顺序比较成员的 key，直接跳过成员的值
+    bool find(const std::string &key, JsonTapeValue &value) const;
+    JsonTapeValue operator[](const std::string &key) const;
+    JsonTapeValue operator[](const char *key) const;
+    // 数组的元素按顺序跳过，超出范围时抛出异常
+    JsonTapeValue operator[](int index) const;
+    // 对象成员或是数组元素的数量，保存在容器开头，不需要扫描
+    int size(void) const;
+
+    iterator begin(void) const;
+    iterator end(void) const;
+
+    double to_double(void) const;
+    int64_t to_int(void) const;
+    bool to_bool(void) const;
+    bool is_null(void) const;
+    // 和 JsonString 一样不处理转义
+    std::string to_string(void) const;
+    // 字符串在 tape 中的内容，不拷贝，以 '\0' 结尾
+    const char* string_data(void) const;
+    ssize_t string_size(void) const;
+    // 把当前值构建为 json 树(在堆上)
+    JsonValue to_value(void) const;
+
+private:
+    JsonTapeValue(const JsonTape *tape, uint64_t index);
+    // 按 tape 中的顺序产生解析事件
+    bool emit(JsonHandler &handler) const;
+
+private:
+    const JsonTape *tape_;
+    uint64_t index_;
+};
+
+// 遍历对象(key() 返回成员名)或是数组(key() 返回空字符串)
+class JsonTapeIterator {
+    friend class JsonTapeValue;
+public:
+    JsonTapeIterator(void);
+    ~JsonTapeIterator(void);
+
+    std::string key(void) const;
+    const char* key_data(void) const;
+    ssize_t key_size(void) const;
+    JsonTapeValue value(void) const;
+    JsonTapeValue operator*(void) const {return this->value();}
+
+    JsonTapeIterator& operator++();
+    bool operator==(const JsonTapeIterator &rhs) const;
+    bool operator!=(const JsonTapeIterator &rhs) const;
+
+private:
+    JsonTapeIterator(const JsonTape *tape, bool is_object, uint64_t pos);
+
+private:
+    const JsonTape *tape_;
+    bool is_object_;
+    uint64_t pos_;      // 当前成员的 key 或是当前元素在 tape 中的位置，结束时是容器结尾的位置
+};
+
+// 解析好的文档的扁平表示：值按文本中的顺序保存在 64 位字组成的 tape 中，字符串保存在字符串区，
+// 所有引用都是 tape 中的下标或是字符串区中的偏移，不包含指针，可以直接写入文件，之后通过 mmap 映射后查询，
+// 不需要再解析文本或是构建 json 树
+// 每个字的高 8 位是类型，低 56 位是参数：
+//  '{' '[': 低 32 位是容器结尾之后的下标，32~55 位是成员或元素的数量(超过 0xffffff 时为 0xffffff)
+//  '}' ']': 容器开头的下标
+//  '"': 字符串在字符串区的偏移，字符串区中先保存 32 位的长度，之后是内容和 '\0'，对象的 key 也是字符串
+//  'l' 'u' 'd': int64_t、uint64_t、double，值保存在下一个字
+//  't' 'f' 'n': true、false、null
+class JsonTape {
+    friend class JsonTapeValue;
+    friend class JsonTapeIterator;
+    friend class JsonTapeBuilder;
+public:
+    JsonTape(void);
+    ~JsonTape(void);
+
+    // 从 json 树构建 tape，保存在内存中
+    void build(const JsonValue &value);
+    // 直接把 json 文本构建为 tape，不构建 json 树，和 JsonParser::parse_document 一样跳过开头不属于 json 的内容
+    void build(const char *data, ssize_t size);
+
+    // 头部和 tape 写入 out 或是文件，source_hash 和 source_size 描述生成 tape 的源文件，返回写入的字节数
+    // 写文件时先写入临时文件再改名，读取的进程不会看到写了一半的文件
+    ssize_t serialize(std::string &out, uint64_t source_hash, uint64_t source_size) const;
+    ssize_t save(const std::string &path, uint64_t source_hash, uint64_t source_size) const;
+
+    // 使用 data 中序列化的 tape，不拷贝(data 需要 8 字节对齐并且在使用期间有效)
+    // 头部无效、版本不一致或是和源文件不匹配时返回 false
+    bool load(const char *data, ssize_t size, uint64_t source_hash, uint64_t source_size);
+    // 通过 mmap 映射 tape 文件，文件不存在时返回 false，其他读取错误时抛出异常
+    bool load_file(const std::string &path, uint64_t source_hash, uint64_t source_size);
+    // 源文件没有变化时直接映射 tape 文件，否则解析源文件并重新生成 tape 文件
+    // 返回 true 表示使用了已有的 tape 文件
+    bool open(const std::string &source_path, const std::string &tape_path);
+
+    bool empty(void) const {return words_ == nullptr;}
+    JsonTapeValue root(void) const;
+    JsonTapeValue operator[](const std::string &key) const {return this->root()[key];}
+    JsonTapeValue operator[](const char *key) const {return this->root()[key];}
+    JsonTapeValue operator[](int index) const {return this->root()[index];}
+
+    // tape 中 64 位字的数量和字符串区的字节数
+    uint64_t tape_size(void) const {return word_count_;}
+    uint64_t string_size(void) const {return string_size_;}
+    // 是否映射自文件
+    bool is_mapped(void) const {return map_addr_ != nullptr;}
+
+private:
+    JsonTape(const JsonTape&);
+    JsonTape& operator=(const JsonTape&);
+
+    // 释放映射的文件和构建的 tape
+    void release(void);
+    // 下标处的值之后的下标
+    uint64_t next_index(uint64_t index) const;
+    uint8_t type_at(uint64_t index) const {return static_cast<uint8_t>(words_[index] >> 56);}
+    uint64_t payload_at(uint64_t index) const {return words_[index] & 0x00ffffffffffffffULL;}
+    // 下标处的字符串
+    const char* string_at(uint64_t index, uint32_t &size) const;
+    void throw_corrupted(uint64_t index) const;
+
+private:
+    // build() 构建的 tape
+    std::vector<uint64_t> tape_;
+    std::string strings_;
+    // 映射的文件
+    void *map_addr_;
+    ssize_t map_size_;
+    // 当前使用的 tape，指向 tape_、strings_ 或是映射的文件
+    const uint64_t *words_;
+    uint64_t word_count_;
+    const char *string_base_;
+    uint64_t string_size_;
+};
+
+}
+
+#endif
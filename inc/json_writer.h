@@ -0,0 +1,85 @@
+#ifndef __JSON_WRITER_H__
+#define __JSON_WRITER_H__
+
+#include "basic_head.h"
+#include "byte_buffer.h"
+#include "wejson.h"
+
+namespace basic {
+
+// 把 json 树序列化到调用者提供的输出中，只遍历一次，不为每个子节点产生中间的字符串
+// 默认先遍历一次估算输出大小的上限，一次分配好内存后直接写入：
+//  std::string: 扩展到上限后直接写入，结束时截断到实际大小
+//  ByteBuffer: 预留一段连续的空闲空间直接写入，结束时 update_write_pos()
+// 和 to_string() 一样字符串按原样输出(不处理转义)，默认不格式化
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string &out);
+    explicit JsonWriter(ByteBuffer &out);
+    ~JsonWriter(void);
+
+    // 是否先估算输出的大小，关闭时 std::string 随写入增长，ByteBuffer 先写入临时字符串再拷贝
+    void set_estimate_size(bool estimate) {estimate_ = estimate;}
+
+    // 格式化输出：每个成员占一行，每层缩进 width 个 ch，width 为 0 时不格式化(默认)
+    void set_indent(int width, char ch = ' ');
+    // 对象的成员按 key 排序输出，关闭时(默认)按照对象中保存的顺序输出
+    void set_sort_keys(bool sort_keys) {sort_keys_ = sort_keys;}
+    // 格式化输出时，紧凑形式不超过 width 个字符的对象和数组在一行内输出，0 表示不合并(默认)
+    void set_max_inline_width(int width) {max_inline_width_ = width > 0 ? width : 0;}
+
+    // 追加 value 的序列化结果，返回写入的字节数
+    ssize_t write(const JsonValue &value);
+    ssize_t write(const JsonObject &value);
+    ssize_t write(const JsonArray &value);
+
+    // 不格式化时序列化结果大小的上限(数值按最大长度计算)
+    static std::size_t estimate_size(const JsonValue &value);
+    static std::size_t estimate_size(const JsonObject &value);
+    static std::size_t estimate_size(const JsonArray &value);
+
+private:
+    template <typename T>
+    ssize_t write_root(const T &value);
+
+    // pretty 为 false 时按紧凑形式输出
+    template <typename Sink>
+    void write_node(const JsonValue &value, Sink &sink, int depth, bool pretty);
+    template <typename Sink>
+    void write_node(const JsonObject &value, Sink &sink, int depth, bool pretty);
+    template <typename Sink>
+    void write_node(const JsonArray &value, Sink &sink, int depth, bool pretty);
+    template <typename Sink>
+    void write_member(const JsonKey &key, const JsonValue &value, bool first, Sink &sink, int depth, bool pretty);
+    template <typename Sink>
+    void write_newline(Sink &sink, int depth);
+
+    // 紧凑形式的长度是否不超过 max_inline_width_，超过时提前返回
+    template <typename T>
+    bool fits_inline(const T &value) const;
+    bool measure(const JsonValue &value, std::size_t &size) const;
+    bool measure(const JsonObject &value, std::size_t &size) const;
+    bool measure(const JsonArray &value, std::size_t &size) const;
+
+    // 每层缩进 width 个字符时输出大小的上限
+    static std::size_t estimate_node(const JsonValue &value, int depth, int width);
+    static std::size_t estimate_node(const JsonObject &value, int depth, int width);
+    static std::size_t estimate_node(const JsonArray &value, int depth, int width);
+
+    JsonWriter(const JsonWriter&);
+    JsonWriter& operator=(const JsonWriter&);
+
+private:
+    std::string *string_out_;
+    ByteBuffer *buffer_out_;
+    bool estimate_;
+
+    int indent_width_;
+    char indent_char_;
+    bool sort_keys_;
+    int max_inline_width_;
+};
+
+}
+
+#endif
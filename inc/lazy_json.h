@@ -0,0 +1,129 @@
+#ifndef __LAZY_JSON_H__
+#define __LAZY_JSON_H__
+
+#include "basic_head.h"
+#include "byte_buffer.h"
+#include "wejson.h"
+
+namespace basic {
+
+class LazyJsonIterator;
+
+// 按需解析的 json 值，只保存值在文本中的位置，不拷贝文本
+// 访问对象的成员或是数组的元素时才解析，没有访问的部分通过括号匹配直接跳过
+// 文本的格式错误在访问到的时候才会发现，和 WeJson 一样抛出 std::runtime_error
+class LazyJsonValue {
+    friend class LazyJson;
+    friend class LazyJsonIterator;
+    friend class JsonBindReader;
+public:
+    typedef LazyJsonIterator iterator;
+public:
+    LazyJsonValue(void);
+    ~LazyJsonValue(void);
+
+    // 根据第一个字符判断类型，无效的值返回 JSON_UNKNOWN_TYPE
+    ValueType type(void) const;
+    bool valid(void) const {return pos_ != nullptr;}
+
+    // 查找对象的成员，找不到时 find 返回 false，operator[] 抛出异常
+    bool find(const std::string &key, LazyJsonValue &value) const;
+    LazyJsonValue operator[](const std::string &key) const;
+    LazyJsonValue operator[](const char *key) const;
+    // 获取数组的元素，超出范围时抛出异常
+    LazyJsonValue operator[](int index) const;
+    // 对象成员或是数组元素的数量，需要扫描整个值
+    int size(void) const;
+
+    // 遍历对象或是数组
+    iterator begin(void) const;
+    iterator end(void) const;
+
+    // 转换为具体的值，类型不一致时抛出异常
+    double to_double(void) const;
+    int64_t to_int(void) const;
+    bool to_bool(void) const;
+    bool is_null(void) const;
+    // 字符串返回引号中的内容(和 JsonString 一样不处理转义)
+    std::string to_string(void) const;
+    // 值的原始文本
+    std::string raw(void) const;
+    // 完整解析当前值
+    JsonValue to_value(void) const;
+
+private:
+    LazyJsonValue(const char *pos, const char *end);
+    // 返回当前值之后的位置
+    const char* skip(void) const;
+
+private:
+    const char *pos_;   // 值的第一个字符
+    const char *end_;   // 文本的结尾
+};
+
+// 遍历对象(key() 返回成员名)或是数组(key() 返回空字符串)
+class LazyJsonIterator {
+    friend class LazyJsonValue;
+public:
+    LazyJsonIterator(void);
+    ~LazyJsonIterator(void);
+
+    std::string key(void) const;
+    // key 在文本中的内容，不拷贝(和 key() 一样不处理转义)
+    const char* key_data(void) const {return key_;}
+    ssize_t key_size(void) const {return key_size_;}
+    LazyJsonValue value(void) const {return value_;}
+    LazyJsonValue operator*(void) const {return value_;}
+
+    LazyJsonIterator& operator++();
+    bool operator==(const LazyJsonIterator &rhs) const;
+    bool operator!=(const LazyJsonIterator &rhs) const;
+
+private:
+    LazyJsonIterator(bool is_object, const char *pos, const char *end);
+    // 解析 pos_ 处的成员或是元素，到达结尾时变为 end()
+    void load(void);
+
+private:
+    bool is_object_;
+    const char *pos_;       // 当前成员(key 的引号)或是元素的开始位置，nullptr 表示结束
+    const char *end_;
+    const char *key_;       // 当前成员 key 的内容
+    ssize_t key_size_;
+    LazyJsonValue value_;
+};
+
+// 按需解析的 json 文档
+class LazyJson {
+public:
+    LazyJson(void);
+    // 不拷贝文本，文本在使用期间必须有效
+    LazyJson(const char *data, ssize_t size);
+    // 拷贝一份文本
+    explicit LazyJson(const std::string &json);
+    explicit LazyJson(const ByteBuffer &data);
+    ~LazyJson(void);
+
+    // 不拷贝文本，跳过开头不属于 json 的内容，从第一个 '{' 或 '[' 开始
+    void parse(const char *data, ssize_t size);
+    // 拷贝一份文本后再解析
+    void parse(const std::string &json);
+    void parse(const ByteBuffer &data);
+
+    LazyJsonValue root(void) const {return root_;}
+    LazyJsonValue operator[](const std::string &key) const {return root_[key];}
+    LazyJsonValue operator[](const char *key) const {return root_[key];}
+    LazyJsonValue operator[](int index) const {return root_[index];}
+
+private:
+    LazyJson(const LazyJson&);
+    LazyJson& operator=(const LazyJson&);
+
+private:
+    std::string text_;
+    LazyJsonValue root_;
+};
+
+}
+
+#endif
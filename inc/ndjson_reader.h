@@ -0,0 +1,81 @@
+#ifndef __NDJSON_READER_H__
+#define __NDJSON_READER_H__
+
+#include "basic_head.h"
+#include "byte_buffer.h"
+#include "wejson.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// 工作线程每次领取的记录数量
+#define NDJSON_BATCH_RECORDS    64
+
+namespace basic {
+
+// 并行解析 NDJSON(JSON Lines) 文本：每行一条 json 记录，空行被跳过
+// 先按 '\n' 切分记录，再由线程池中的线程并行解析，调用 parse 的线程也参与解析
+// 任何一条记录格式错误时停止解析并抛出 std::runtime_error，错误信息中包含记录的序号和偏移
+// 同一个 NdJsonReader 不能在多个线程中同时调用 parse
+class NdJsonReader {
+public:
+    // index 是记录的序号(不包括空行)
+    typedef std::function<void(std::size_t index, WeJson &record)> RecordCallback;
+
+public:
+    // thread_num 是工作线程的数量(不包括调用 parse 的线程)，小于 0 时根据 cpu 核数决定
+    explicit NdJsonReader(int thread_num = -1);
+    ~NdJsonReader(void);
+
+    // 按输入顺序返回所有记录，返回记录的数量
+    ssize_t parse(const char *data, ssize_t size, std::vector<WeJson> &records);
+    ssize_t parse(const ByteBuffer &data, std::vector<WeJson> &records);
+    // 每条记录解析完成后在解析线程中调用 callback，调用顺序不确定，callback 需要是线程安全的
+    ssize_t parse(const char *data, ssize_t size, const RecordCallback &callback);
+
+    // 通过 mmap 映射文件后解析，不需要把文件读入内存
+    ssize_t parse_file(const std::string &path, std::vector<WeJson> &records);
+    ssize_t parse_file(const std::string &path, const RecordCallback &callback);
+
+    int thread_num(void) const {return static_cast<int>(threads_.size());}
+    // 记录中对象的 key 驻留在 table 中，所有记录共享相同的 key，为空时不驻留(默认)
+    void set_key_table(JsonKeyTable *table) {key_table_ = table;}
+
+private:
+    ssize_t parse_records(const char *data, ssize_t size, std::vector<WeJson> *records, const RecordCallback *callback);
+    ssize_t parse_mapped_file(const std::string &path, std::vector<WeJson> *records, const RecordCallback *callback);
+    // 按 '\n' 切分记录，去掉开头的空白，跳过空行
+    void split_records(const char *data, ssize_t size);
+    // 不断领取记录并解析，直到没有剩余的记录或是出现错误
+    void run_job(void);
+    void worker_loop(void);
+
+    NdJsonReader(const NdJsonReader&);
+    NdJsonReader& operator=(const NdJsonReader&);
+
+private:
+    JsonKeyTable *key_table_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable work_cond_;
+    std::condition_variable done_cond_;
+    uint64_t generation_;   // 每次提交任务加一，工作线程据此判断是否有新任务
+    int running_;           // 还没有完成当前任务的工作线程数量
+    bool exit_;
+
+    // 当前任务
+    const char *data_;
+    std::vector<std::pair<const char*, const char*>> lines_;
+    std::vector<WeJson> *records_;
+    const RecordCallback *callback_;
+    std::atomic<std::size_t> next_;
+    std::atomic<bool> failed_;
+    std::string error_;
+};
+
+}
+
+#endif
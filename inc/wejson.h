@@ -4,6 +4,11 @@
 #include "basic_head.h"
 #include "byte_buffer.h"
 #include "logger.h"
+#include "json_arena.h"
+#include "json_number.h"
+#include "json_key.h"
+
+#define JSON_OBJECT_INDEX_THRESHOLD     16      // 对象的成员超过这个数量时建立哈希索引，否则顺序查找
 
 namespace basic {
 // json中重要的分割字符
@@ -21,38 +26,48 @@ enum ValueType {
     JSON_OBJECT_TYPE = 10006
 };
 
+// 各个 json 类型的公共部分，只提供静态的辅助函数
+// JsonValue 根据类型标记直接保存值，不通过 JsonType 指针和虚函数访问
 class JsonType {
 public:
     JsonType(void) {}
-    virtual ~JsonType(void) {}
+    ~JsonType(void) {}
 
     // 检查当前位置的字符来判断接下来的是什么类型，具体参考doc中的资料
     static ValueType check_value_type(ByteBuffer::iterator &iter);
 
     // ValueType 转为字符串表示
     static std::string value_type_to_string(ValueType type);
-
-    // 解析遇到的类型，具体取决于check_value_type()返回的类型和继承该类的实现
-    virtual ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos){return ByteBuffer::iterator();}
-    
-    // 将json值反序列化为字符串输出， 没有格式化
-    virtual std::string to_string(void) const { return "";}
 };
 
-// json 数值类型
+// json 数值类型：整数在 int64_t/uint64_t 范围内时保存精确值，其他情况保存为 double
 class JsonNumber : public JsonType {
     friend std::ostream& operator<<(std::ostream &os, JsonNumber &rhs);
 public:
     explicit JsonNumber(void);
     explicit JsonNumber(const double &val);
+    explicit JsonNumber(const int &val);
+    explicit JsonNumber(const int64_t &val);
+    explicit JsonNumber(const uint64_t &val);
+    explicit JsonNumber(const JsonNumberLiteral &val);
     ~JsonNumber(void);
 
-    virtual ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos) override;
-    virtual std::string to_string(void) const override;
+    // 解析遇到的类型，具体取决于check_value_type()返回的类型
+    ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos);
+    // 将json值反序列化为字符串输出， 没有格式化
+    // 浮点数输出能还原出原值的最短形式
+    std::string to_string(void) const;
+    // 写入 buf(至少 JSON_NUMBER_BUFFER_SIZE 个字节)，返回写入内容的结尾
+    char* to_chars(char *buf) const;
+
+    double to_double(void) const;
+    // 保存的是整数时返回精确值，浮点数会丢失小数部分
+    uint64_t to_uint(void) const;
+    int64_t to_int(void) const;
 
-    double to_double(void) const  {return value_;}
-    uint64_t to_uint(void) const {return static_cast<uint64_t>(value_);}
-    int64_t to_int(void) const {return static_cast<int64_t>(value_);}
+    // 数值保存的精确类型
+    JsonNumberKind kind(void) const {return value_.kind;}
+    bool is_integer(void) const {return value_.kind != JSON_NUMBER_DOUBLE;}
 
     bool operator==(const JsonNumber& rhs) const;
     bool operator!=(const JsonNumber& rhs) const;
@@ -61,7 +76,7 @@ public:
     JsonNumber& operator=(JsonNumber rhs);
 
 private:
-    double        value_;
+    JsonNumberLiteral value_;
 };
 
 // json 布尔类型
@@ -72,8 +87,10 @@ public:
     explicit JsonBool(bool val);
     ~JsonBool(void);
 
-    virtual ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos) override;
-    virtual std::string to_string(void) const override;
+    // 解析遇到的类型，具体取决于check_value_type()返回的类型
+    ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos);
+    // 将json值反序列化为字符串输出， 没有格式化
+    std::string to_string(void) const;
 
     bool to_bool(void) const  {return value_;}
 
@@ -94,8 +111,10 @@ public:
     explicit JsonNull(void);
     ~JsonNull(void);
 
-    virtual ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos) override;
-    virtual std::string to_string(void) const override;
+    // 解析遇到的类型，具体取决于check_value_type()返回的类型
+    ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos);
+    // 将json值反序列化为字符串输出， 没有格式化
+    std::string to_string(void) const;
 
     bool operator==(const JsonNull& rhs) const;
     bool operator!=(const JsonNull& rhs) const;
@@ -107,15 +126,19 @@ private:
 
 // json 字符串类型
 class JsonString : public JsonType {
+    friend class JsonValue;
     friend std::ostream& operator<<(std::ostream &os, JsonString &rhs);
 public:
     explicit JsonString(void);
     explicit JsonString(const std::string val);
     explicit JsonString(const char *val);
+    JsonString(const char *str, ssize_t size);
     ~JsonString(void);
 
-    virtual ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos) override;
-    virtual std::string to_string(void) const override;
+    // 解析遇到的类型，具体取决于check_value_type()返回的类型
+    ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos);
+    // 将json值反序列化为字符串输出， 没有格式化
+    std::string to_string(void) const;
 
     bool operator==(const JsonString& rhs) const;
     bool operator!=(const JsonString& rhs) const;
@@ -128,66 +151,134 @@ private:
 };
 
 class JsonValue;
+class JsonParser;
 class JsonObject : public JsonType {
 public:
     friend class JsonValue;
+    friend class JsonDomBuilder;
+    friend class JsonWriter;
+    friend class CborEncoder;
+    friend class JsonTapeBuilder;
     friend std::ostream& operator<<(std::ostream &os, JsonObject &rhs);
-    typedef std::map<std::string, JsonValue>::iterator iterator;
+    // 成员按插入顺序连续保存，不要通过迭代器修改 first(key)
+    typedef std::pair<JsonKey, JsonValue> member_type;
+    typedef std::vector<member_type, JsonAllocator<member_type>> member_array;
+    typedef member_array::iterator iterator;
+    typedef member_array::const_iterator const_iterator;
 public:
     JsonObject(void);
+    // 成员保存在 arena 中(为空时在堆上)
+    explicit JsonObject(JsonArena *arena);
     JsonObject(const JsonObject &jobj);
+    // 接管 jobj 在堆上的成员；jobj 的成员在 arena 中时拷贝到堆上，arena 可能随文档一起释放
+    JsonObject(JsonObject &&jobj);
     ~JsonObject(void);
 
     // 序列化和反序列化
-    virtual ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos) override;
-    virtual std::string to_string(void) const override;
+    // 解析遇到的类型，具体取决于check_value_type()返回的类型
+    ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos);
+    // 将json值反序列化为字符串输出， 没有格式化
+    std::string to_string(void) const;
     
-    // 查找元素
+    // 查找元素，不存在时返回 end()
     JsonObject::iterator find(const std::string &key);
-    // 删除元素
+    JsonObject::const_iterator find(const std::string &key) const;
+    // 和对象中的 key 驻留在同一个 JsonKeyTable 时只需要比较指针
+    JsonObject::iterator find(const JsonKey &key);
+    // 删除元素，之后的元素保持原来的顺序
     int erase(const std::string &key);
     JsonObject::iterator erase(JsonObject::iterator &remove_iter);
-    // 当前类型为对象时添加元素
+    // 当前类型为对象时添加元素，key 已经存在时替换原来的值
     int add(const std::string &key, const JsonValue &value);
+    // value 和对象在同一个 arena 中(或都在堆上)时直接接管，否则拷贝过来
+    int add(const std::string &key, JsonValue &&value);
+    // 用 args 直接在对象中构造元素并返回它，key 已经存在时替换原来的值
+    template <typename... Args>
+    JsonValue& emplace(const std::string &key, Args&&... args);
     // 返回元素数量
     int size(void) const {return static_cast<int>(value_.size());}
     // 清空元素
-    void clear(void) {value_.clear();}
+    void clear(void);
 
     // 重载操作符
+    // 成员的顺序不影响比较的结果
     bool operator==(const JsonObject& rhs) const;
     bool operator!=(const JsonObject& rhs) const;
     JsonObject& operator=(const JsonObject &rhs);
+    // 同一个 arena 或是都在堆上时直接接管 rhs 的成员；否则逐个移动，其他 arena 中的 key 和值拷贝过来
+    // 在堆上时 arena 中的值都拷贝过来
+    JsonObject& operator=(JsonObject &&rhs);
     JsonValue& operator[](const std::string &key);
+    const JsonValue& operator[](const std::string &key) const;
 
-    // 迭代器
+    // 迭代器，按照插入的顺序
     iterator begin();
     iterator end();
+    const_iterator begin() const {return value_.begin();}
+    const_iterator end() const {return value_.end();}
 
 private:
-    std::map<std::string, JsonValue> value_;
+    // 返回 key 在 value_ 中的位置，不存在时返回 -1
+    ssize_t find_pos(const char *key, std::size_t size) const;
+    ssize_t find_pos(const JsonKey &key) const;
+    // 成员数量超过 JSON_OBJECT_INDEX_THRESHOLD 时重建哈希索引，否则释放索引
+    // check_duplicate 为 true 时遇到重复的 key 抛出异常
+    void rebuild_index(bool check_duplicate = false);
+    void insert_index(std::size_t pos);
+    // 容量已满时扩容，成员逐个交换到新的内存中(JsonValue 的移动会拷贝 arena 中的值)
+    void reserve_one(void);
+    // 删除 pos 处的成员，之后的成员交换到前面，不重建索引
+    void remove_at(std::size_t pos);
+    // 在堆上的成员引用了 arena 时拷贝到堆上
+    void detach_members(void);
+    // 被多个 JsonValue 引用或是所在的 arena 被多个文档共享时不能直接修改
+    bool is_shared(void) const;
+
+private:
+    member_array value_;
+    // 开放寻址的哈希表，保存成员位置 + 1，0 表示空位
+    std::vector<uint32_t, JsonAllocator<uint32_t>> index_;
+    // 引用这个对象的 JsonValue 的数量，由 JsonValue 维护
+    std::atomic<uint32_t> refs_;
 };
 
 // json 数组类型
 class JsonArray : public JsonType {
 public:
     friend class JsonValue;
+    friend class JsonDomBuilder;
+    friend class JsonWriter;
+    friend class CborEncoder;
+    friend class JsonTapeBuilder;
     friend std::ostream& operator<<(std::ostream &os, JsonArray &rhs);
-    typedef std::vector<JsonValue>::iterator iterator;
+    typedef std::vector<JsonValue, JsonAllocator<JsonValue>> array_type;
+    typedef array_type::iterator iterator;
+    typedef array_type::const_iterator const_iterator;
 public:
     JsonArray(void);
+    // 元素保存在 arena 中(为空时在堆上)
+    explicit JsonArray(JsonArena *arena);
     JsonArray(JsonArray &jarr);
+    // 接管 jarr 在堆上的元素；jarr 的元素在 arena 中时拷贝到堆上，arena 可能随文档一起释放
+    JsonArray(JsonArray &&jarr);
     ~JsonArray(void);
 
     // 序列化和反序列化
-    virtual ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos) override;
-    virtual std::string to_string(void) const override;
+    // 解析遇到的类型，具体取决于check_value_type()返回的类型
+    ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos);
+    // 将json值反序列化为字符串输出， 没有格式化
+    std::string to_string(void) const;
 
     // 数组或是对象删除元素
     iterator erase(const int &index);
     iterator erase(const iterator &remove_iter);
     // 当前添加元素
     int add(const JsonValue &value);
+    // value 和数组在同一个 arena 中(或都在堆上)时直接接管，否则拷贝过来
+    int add(JsonValue &&value);
+    // 用 args 直接在数组末尾构造元素并返回它
+    template <typename... Args>
+    JsonValue& emplace_back(Args&&... args);
     // 返回元素数量
     int size(void) const {return static_cast<int>(value_.size());}
     // 清空元素
@@ -199,16 +290,44 @@ public:
     bool operator==(const JsonArray& rhs) const;
     bool operator!=(const JsonArray& rhs) const; 
     JsonArray& operator=(const JsonArray &rhs);
+    // 同一个 arena 或是都在堆上时直接接管 rhs 的元素；否则逐个移动，其他 arena 中的值拷贝过来
+    // 在堆上时 arena 中的值都拷贝过来
+    JsonArray& operator=(JsonArray &&rhs);
 
     // 迭代器
     iterator begin();
     iterator end();
+    const_iterator begin() const {return value_.begin();}
+    const_iterator end() const {return value_.end();}
+
+private:
+    // 和 JsonObject 相同
+    void reserve_one(void);
+    void remove_at(std::size_t pos);
+    void detach_values(void);
+    bool is_shared(void) const;
+
 private:
-    std::vector<JsonValue> value_;
+    array_type value_;
+    // 引用这个数组的 JsonValue 的数量，由 JsonValue 维护
+    std::atomic<uint32_t> refs_;
 };
 
 // json中转类型：可以安装当前存储的类型输出或是接收不同的类型
+// 每个值占用 16 个字节：类型标记，数值(double 或 64 位整数)和布尔值直接保存，字符串保存指针和长度，对象和数组保存指针
+// 根据类型标记分发，不需要虚函数和 dynamic_cast
+// 移动时直接接管堆上的字符串、对象和数组，不拷贝也不分配内存；文档 arena 中的值移动时拷贝到堆上，
+// 文档销毁之后仍然可以使用。文档内部的移动(add(&&)、对象和数组的扩容和删除)直接交换，不拷贝
+// 堆上的对象和数组在拷贝时共享(引用计数)，通过非 const 的接口访问时才拷贝被共享的节点(写时复制)，
+// 只复制从根节点到修改位置的路径，其余的子树继续共享；const 的接口不会拷贝
 class JsonValue {
+    friend class JsonObject;
+    friend class JsonArray;
+    friend class JsonDomBuilder;
+    friend class JsonWriter;
+    friend class CborEncoder;
+    friend class JsonTapeBuilder;
+    friend class WeJson;
 public:
     JsonValue(void);
     JsonValue(const JsonBool &value);
@@ -218,9 +337,14 @@ public:
     JsonValue(const JsonArray &value);
     JsonValue(const JsonNull &value);
     JsonValue(const JsonValue &value);
-    
+    JsonValue(JsonValue &&value);
+    JsonValue(JsonObject &&value);
+    JsonValue(JsonArray &&value);
+
     JsonValue(const bool &value);
     JsonValue(const int &value);
+    JsonValue(const int64_t &value);
+    JsonValue(const uint64_t &value);
     JsonValue(const double &value);
     JsonValue(const std::string &value);
     JsonValue(const char *value);
@@ -230,8 +354,11 @@ public:
     operator JsonNumber();
     operator JsonString();
     operator JsonBool();
-    operator JsonObject();
-    operator JsonArray();
+    operator JsonObject() &;
+    operator JsonArray() &;
+    // 临时值转换时移动对象和数组的内容
+    operator JsonObject() &&;
+    operator JsonArray() &&;
     operator JsonNull();
 
     JsonValue& operator=(const JsonBool &val);
@@ -241,36 +368,101 @@ public:
     JsonValue& operator=(const JsonArray &val);
     JsonValue& operator=(const JsonNull &val);
     JsonValue& operator=(const JsonValue &val);
+    JsonValue& operator=(JsonValue &&val);
+    JsonValue& operator=(JsonObject &&val);
+    JsonValue& operator=(JsonArray &&val);
 
     bool operator==(const JsonValue& rhs) const;
     bool operator!=(const JsonValue& rhs) const;
 
+    // 非 const 的访问会先拷贝被共享的对象或数组
     JsonValue& operator[](const std::string &key);
     JsonValue& operator[](const int &key);
+    const JsonValue& operator[](const std::string &key) const;
+    const JsonValue& operator[](const int &key) const;
 
-    ValueType type(void) const {return type_;}
-    std::string to_string(void);
+    ValueType type(void) const {return static_cast<ValueType>(type_);}
+    std::string to_string(void) const;
+
+    // 返回当前保存的对象或数组，可以直接修改，类型不符时抛出异常
+    // 拷贝之后不要再通过之前得到的引用修改，修改会同时出现在共享的拷贝中
+    JsonObject& get_object(void);
+    JsonArray& get_array(void);
+    const JsonObject& get_object(void) const;
+    const JsonArray& get_array(void) const;
+
+    // 交换两个值，不拷贝具体内容
+    void swap(JsonValue &rhs);
 
 public:
     void copy(const JsonValue &val, bool is_release = true);
 
-public:
-    ValueType type_;
-    JsonType *value_;
+private:
+    // 释放当前保存的字符串、对象或数组，之后变为 JSON_NULL_TYPE
+    // 内存在 arena 中时只调用析构函数，内存随 arena 一起释放
+    void release(void);
+    // 以下函数替换当前的值，arena 为空时在堆上分配
+    void set_string(const char *str, std::size_t size, JsonArena *arena = nullptr);
+    JsonObject* set_object(JsonArena *arena = nullptr);
+    JsonArray* set_array(JsonArena *arena = nullptr);
+    void set_number(double value);
+    void set_number(const JsonNumber &value);
+    void set_int(int64_t value);
+    void set_uint(uint64_t value);
+    void set_bool(bool value);
+    JsonNumber to_number(void) const;
+    // 浅拷贝：对象和数组增加引用计数，arena 中的字符串共享指针，只在文档内部使用
+    void share(const JsonValue &val);
+    // 返回可以修改的对象或数组，被共享时先拷贝一层，子节点继续共享
+    JsonObject* mutable_object(void);
+    JsonArray* mutable_array(void);
+    // 值(或是它的子节点)是否引用了 arena 之外的 arena 内存，arena 为空表示堆
+    bool is_foreign(const JsonArena *arena) const;
+    // 放入 arena 中(为空时在堆上)的对象或数组时调用，引用了其他 arena 的内容拷贝到堆上
+    void detach(const JsonArena *arena);
+
+private:
+    int16_t type_;      // ValueType
+    uint8_t in_arena_;  // 1: 字符串、对象或数组的内存在 arena 中，2: 对象或数组在堆上，但是子节点可能在 arena 中
+    uint8_t kind_;      // 数值的精确类型(JsonNumberKind)
+    uint32_t size_;     // 字符串的长度
+    union {
+        double number_;
+        int64_t int_;
+        uint64_t uint_;
+        bool bool_;
+        char *string_;
+        JsonObject *object_;
+        JsonArray *array_;
+    };
 };
 
+// 解析出来的 json 树保存在 WeJson 自己的 JsonArena 中，销毁或是重新解析时一次释放
+// 拷贝的文档共享 arena(引用计数)，最后一个文档销毁时释放
 class WeJson : public JsonValue 
 {
 public:
     WeJson(void);
     WeJson(const std::string &json);
     WeJson(const ByteBuffer &data);
+    // 拷贝时和 rhs 共享 arena 和 json 树，不复制节点，修改时只复制被修改的路径
+    WeJson(const WeJson &rhs);
+    // 连同 arena 一起接管 rhs 的文档，不拷贝
+    WeJson(WeJson &&rhs) noexcept;
     virtual ~WeJson(void);
 
+    WeJson& operator=(const WeJson &rhs);
+    WeJson& operator=(WeJson &&rhs) noexcept;
+
     // 解析保存在ByteBuffer的数据
     virtual int parse(const ByteBuffer &data);
     // 解析保存在string中的数据
     virtual int parse(const std::string &data);
+    // 解析保存在连续内存中的数据
+    virtual int parse(const char *data, ssize_t size);
+    // 解析 CBOR 编码的数据(见 json_cbor.h)，和文本一样在文档的 arena 中构建 json 树
+    int parse_cbor(const char *data, ssize_t size);
+    int parse_cbor(const ByteBuffer &data);
 
     // 非格式化输出 json
     virtual std::string to_string(void);
@@ -285,15 +477,50 @@ public:
     // 返回当前对象类型
     ValueType get_type(void) const {return JsonValue::type();}
 
-    // 构建成object
-    JsonObject& get_object(void);
-    // 构建成array
-    JsonArray& get_array(void);
+    // 当前文档使用的 arena，没有解析过时为空
+    const JsonArena* arena(void) const {return doc_arena_;}
+    // 之后解析的对象的 key 驻留在 table 中(例如 JsonKeyTable::global())，为空时不驻留(默认)
+    // table 需要比文档以及从文档拷贝出来的值活得更久
+    void set_key_table(JsonKeyTable *table) {key_table_ = table;}
+    JsonKeyTable* key_table(void) const {return key_table_;}
 
 private:
-    virtual ByteBuffer::iterator parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos);
+    // 释放 json 树和 arena
+    void destroy(void);
+    // 重新解析之前释放上一次的结果，准备好 arena
+    void prepare_arena(ssize_t size);
+
+private:
+    JsonArena *doc_arena_;
+    JsonKeyTable *key_table_;
 };
 
+template <typename... Args>
+JsonValue&
+JsonObject::emplace(const std::string &key, Args&&... args)
+{
+    ssize_t pos = this->find_pos(key.data(), key.size());
+    // 构造出来的值都在堆上(arena 中的值移动时会拷贝出来)
+    if (pos >= 0) {
+        value_[pos].second = JsonValue(std::forward<Args>(args)...);
+        return value_[pos].second;
+    }
+
+    this->reserve_one();
+    value_.emplace_back(std::piecewise_construct, std::forward_as_tuple(key.data(), key.size()), std::forward_as_tuple(std::forward<Args>(args)...));
+    this->insert_index(value_.size() - 1);
+    return value_.back().second;
+}
+
+template <typename... Args>
+JsonValue&
+JsonArray::emplace_back(Args&&... args)
+{
+    this->reserve_one();
+    value_.emplace_back(std::forward<Args>(args)...);
+    return value_.back();
+}
+
 }
 
 #endif
\ No newline at end of file
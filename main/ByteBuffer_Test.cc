@@ -432,6 +432,119 @@ TEST_F(ByteBuffer_Test, copy_test)
     }
 }
 
+TEST_F(ByteBuffer_Test, inline_buffer)
+{
+    // 小数据保存在对象内部，超过之后转移到堆上
+    ByteBuffer small;
+    std::string str = "hello, world";
+    small.write_string(str);
+    ASSERT_EQ(small.idle_size(), INLINE_BUFFER_SIZE - 1 - static_cast<ssize_t>(str.size()));
+
+    ByteBuffer small_copy(small);
+    ASSERT_EQ(small_copy, small);
+    ASSERT_NE(small_copy.get_read_buffer_ptr(), small.get_read_buffer_ptr());
+
+    std::string large_str(INLINE_BUFFER_SIZE * 4, 'x');
+    ByteBuffer large;
+    large.write_string(large_str);
+    ASSERT_GE(large.idle_size(), 0);
+
+    // 互相赋值时内部缓存和堆缓存之间需要正确切换
+    small_copy = large;
+    ASSERT_EQ(small_copy, large);
+    large = small;
+    ASSERT_EQ(large, small);
+    ASSERT_EQ(large.idle_size(), INLINE_BUFFER_SIZE - 1 - static_cast<ssize_t>(str.size()));
+
+    // 读写折返之后拷贝
+    ByteBuffer wrap;
+    for (int i = 0; i < 100; ++i) {
+        std::string read_str;
+        wrap.write_string(str);
+        ByteBuffer wrap_copy = wrap;
+        ASSERT_EQ(wrap_copy, wrap);
+        wrap.read_string(read_str);
+        ASSERT_EQ(read_str, str);
+    }
+}
+
+TEST_F(ByteBuffer_Test, stats)
+{
+    ByteBuffer::reset_global_stats();
+
+    ByteBuffer buff;
+    std::string str(INLINE_BUFFER_SIZE * 2, 'x'), read_str;
+    buff.write_string(str);
+    buff.read_string(read_str, INLINE_BUFFER_SIZE);
+    buff.write_string(str);
+    // 超过当前容量，再次扩容并释放之前的缓存
+    buff.write_string(std::string(INLINE_BUFFER_SIZE * 8, 'y'));
+
+    ByteBufferStats stats = buff.stats();
+    ByteBuffer::dump_stats(stats, "buff");
+    ByteBuffer::dump_stats(ByteBuffer::global_stats(), "global");
+#ifdef __BYTE_BUFFER_STATS__
+    ASSERT_EQ(stats.allocations, 2);
+    ASSERT_EQ(stats.frees, 1);
+    ASSERT_EQ(stats.resizes, 2);
+    ASSERT_GE(stats.bytes_copied_in, static_cast<int64_t>(str.size() * 2 + INLINE_BUFFER_SIZE * 8));
+    ASSERT_GE(stats.bytes_copied_out, INLINE_BUFFER_SIZE);
+    ASSERT_EQ(stats.peak_capacity, buff.data_size() + buff.idle_size() + 1);
+
+    ByteBufferStats global = ByteBuffer::global_stats();
+    ASSERT_GE(global.allocations, stats.allocations);
+    ASSERT_GE(global.peak_capacity, stats.peak_capacity);
+
+    // 数据跨过缓存末尾时记录折返
+    ByteBuffer ring(INLINE_BUFFER_SIZE);
+    for (int i = 0; i < INLINE_BUFFER_SIZE; ++i) {
+        ring.write_string(str.substr(0, INLINE_BUFFER_SIZE - 1));
+        ring.read_string(read_str);
+    }
+    ASSERT_GT(ring.stats().wrap_arounds, 0);
+    ASSERT_EQ(ring.stats().resizes, 0);
+#else
+    ASSERT_EQ(stats.allocations, 0);
+    ASSERT_EQ(ByteBuffer::global_stats().bytes_copied_in, 0);
+#endif
+}
+
+TEST_F(ByteBuffer_Test, linearize)
+{
+    std::string data, read_str;
+    for (int i = 0; i < 200; ++i) {
+        data += static_cast<char>('a' + i % 26);
+    }
+
+    // 不同的读位置和数据长度，覆盖数据连续和折返的情况
+    for (ssize_t offset = 0; offset < 100; offset += 7) {
+        for (ssize_t size = 0; size < 150; size += 11) {
+            ByteBuffer buff(100);
+            buff.write_string(data.substr(0, offset));
+            buff.read_string(read_str);
+            buff.write_string(data.substr(0, size));
+
+            buffptr ptr = buff.linearize();
+            ASSERT_EQ(ptr, buff.get_read_buffer_ptr());
+            ASSERT_EQ(buff.get_cont_read_size(), buff.data_size());
+            ASSERT_EQ(std::string(ptr, buff.data_size()), data.substr(0, size));
+            ASSERT_EQ(buff.str(), data.substr(0, size));
+        }
+    }
+
+    ByteBuffer buff(100);
+    buff.write_string(data.substr(0, 150));
+    buff.read_string(read_str, 120);
+    ASSERT_LT(buff.get_cont_write_size(), buff.idle_size());
+    ASSERT_EQ(buff.compact(), buff.idle_size());
+    ASSERT_EQ(buff.str(), data.substr(120, 30));
+
+    // 已经连续时 compact 不移动数据
+    buffptr ptr = buff.get_read_buffer_ptr();
+    ASSERT_EQ(buff.compact(), buff.idle_size());
+    ASSERT_EQ(ptr, buff.get_read_buffer_ptr());
+}
+
 TEST_F(ByteBuffer_Test, iterator)
 {
     ByteBuffer buff;
@@ -0,0 +1,204 @@
+#include "byte_codec.h"
+#include "gtest/gtest.h"
+
+using namespace basic;
+
+namespace my {
+namespace project {
+namespace {
+
+////////////////////////////测试工具函数//////////////////////////////////
+// 逐字节实现的参考编码，用来验证向量化的实现
+std::string
+simple_base64_encode(const std::string &src, const char *chars, bool padding)
+{
+    std::string result;
+    std::size_t i = 0;
+    for (; i + 3 <= src.size(); i += 3) {
+        uint32_t val = (static_cast<uint8_t>(src[i]) << 16) | (static_cast<uint8_t>(src[i + 1]) << 8) | static_cast<uint8_t>(src[i + 2]);
+        result += chars[(val >> 18) & 0x3F];
+        result += chars[(val >> 12) & 0x3F];
+        result += chars[(val >> 6) & 0x3F];
+        result += chars[val & 0x3F];
+    }
+
+    if (i < src.size()) {
+        uint32_t val = static_cast<uint8_t>(src[i]) << 16;
+        if (i + 1 < src.size()) {
+            val |= static_cast<uint8_t>(src[i + 1]) << 8;
+        }
+        result += chars[(val >> 18) & 0x3F];
+        result += chars[(val >> 12) & 0x3F];
+        if (i + 1 < src.size()) {
+            result += chars[(val >> 6) & 0x3F];
+        } else if (padding) {
+            result += '=';
+        }
+        if (padding) {
+            result += '=';
+        }
+    }
+
+    return result;
+}
+
+std::string
+simple_hex_encode(const std::string &src, bool upper)
+{
+    const char *chars = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    std::string result;
+    for (std::size_t i = 0; i < src.size(); ++i) {
+        result += chars[static_cast<uint8_t>(src[i]) >> 4];
+        result += chars[static_cast<uint8_t>(src[i]) & 0x0F];
+    }
+
+    return result;
+}
+
+std::string
+random_bytes(int size)
+{
+    std::string result;
+    for (int i = 0; i < size; ++i) {
+        result += static_cast<char>(rand() % 256);
+    }
+
+    return result;
+}
+
+// 构造数据在缓冲区末尾折返的 ByteBuffer
+ByteBuffer
+wrapped_buffer(const std::string &data, int offset)
+{
+    // 缓冲区容量只比数据多一两个字节，先写入再读出 offset 个字节移动读写位置
+    ByteBuffer buff((static_cast<ssize_t>(data.size()) + 1) / 2 + 1);
+    offset = offset % (static_cast<int>(data.size()) + 1);
+    std::string skip(offset, 'x');
+    buff.write_string(skip);
+    int8_t ch;
+    for (int i = 0; i < offset; ++i) {
+        buff.read_int8(ch);
+    }
+    buff.write_string(data);
+
+    return buff;
+}
+
+std::string
+buffer_to_string(ByteBuffer &buff)
+{
+    std::string str(buff.data_size(), '\0');
+    buff.read_bytes(&str[0], buff.data_size());
+    return str;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+class ByteCodec_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Code here will be called immediately after the constructor (right
+        // before each test).
+    }
+
+    void TearDown() override {
+        // Code here will be called immediately after each test (right
+        // before the destructor).
+    }
+};
+
+TEST_F(ByteCodec_Test, base64_known_value)
+{
+    const char *plain[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+    const char *encoded[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+
+    for (int i = 0; i < 7; ++i) {
+        ByteBuffer src(std::string(plain[i])), dst, back;
+        ASSERT_EQ(base64_encode(src, dst), static_cast<ssize_t>(strlen(encoded[i])));
+        ASSERT_EQ(base64_decode(dst, back), static_cast<ssize_t>(strlen(plain[i])));
+        ASSERT_EQ(buffer_to_string(dst), encoded[i]);
+        ASSERT_EQ(buffer_to_string(back), plain[i]);
+    }
+
+    ByteBuffer src(std::string("\xfb\xff\xfe")), dst, url_dst;
+    base64_encode(src, dst);
+    base64_encode(src, url_dst, BASE64_URL_SAFE);
+    ASSERT_EQ(buffer_to_string(dst), "+//+");
+    ASSERT_EQ(buffer_to_string(url_dst), "-__-");
+}
+
+TEST_F(ByteCodec_Test, base64_random)
+{
+    const char *standard = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const char *url_safe = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    for (int i = 0; i < 500; ++i) {
+        std::string data = random_bytes(rand() % 600);
+        int offset = rand() % 64;
+        Base64Alphabet alphabet = (i % 2 == 0 ? BASE64_STANDARD : BASE64_URL_SAFE);
+        bool padding = (i % 3 != 0);
+
+        ByteBuffer src = wrapped_buffer(data, offset), dst, back;
+        ASSERT_GE(base64_encode(src, dst, alphabet, padding), 0);
+        ASSERT_EQ(src.data_size(), static_cast<ssize_t>(data.size()));
+
+        std::string expect = simple_base64_encode(data, alphabet == BASE64_STANDARD ? standard : url_safe, padding);
+        ByteBuffer wrapped_dst = wrapped_buffer(expect, offset);
+        ASSERT_EQ(base64_decode(wrapped_dst, back, alphabet), static_cast<ssize_t>(data.size()));
+        ASSERT_EQ(buffer_to_string(dst), expect);
+        ASSERT_EQ(buffer_to_string(back), data);
+    }
+}
+
+TEST_F(ByteCodec_Test, base64_invalid)
+{
+    const char *invalid[] = {"Zg=", "Z", "Zm9v!mFy", "Zm9vYmFy\n", "Zm9-", "Zg===", "=Zg="};
+    for (int i = 0; i < 7; ++i) {
+        ByteBuffer src(std::string(invalid[i])), dst;
+        ASSERT_EQ(base64_decode(src, dst), -1);
+    }
+
+    std::string long_invalid = simple_base64_encode(random_bytes(300), "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/", true);
+    long_invalid[200] = '*';
+    ByteBuffer src(long_invalid), dst;
+    ASSERT_EQ(base64_decode(src, dst), -1);
+    ASSERT_EQ(base64_decode(src, src), -1);
+}
+
+TEST_F(ByteCodec_Test, hex_random)
+{
+    for (int i = 0; i < 500; ++i) {
+        std::string data = random_bytes(rand() % 600);
+        int offset = rand() % 64;
+        bool upper = (i % 2 == 0);
+
+        ByteBuffer src = wrapped_buffer(data, offset), dst, back;
+        ASSERT_EQ(hex_encode(src, dst, upper), static_cast<ssize_t>(data.size() * 2));
+
+        std::string expect = simple_hex_encode(data, upper);
+        ByteBuffer wrapped_dst = wrapped_buffer(expect, offset);
+        ASSERT_EQ(hex_decode(wrapped_dst, back), static_cast<ssize_t>(data.size()));
+        ASSERT_EQ(buffer_to_string(dst), expect);
+        ASSERT_EQ(buffer_to_string(back), data);
+    }
+
+    ByteBuffer src(std::string("00fFaB9c")), dst;
+    ASSERT_EQ(hex_decode(src, dst), 4);
+    ASSERT_EQ(buffer_to_string(dst), std::string("\x00\xff\xab\x9c", 4));
+
+    const char *invalid[] = {"0", "0g", "abcdefgh", "0123456789abcdef0123456789abcdef0123456789abcdeG"};
+    for (int i = 0; i < 4; ++i) {
+        ByteBuffer invalid_src(std::string(invalid[i])), invalid_dst;
+        ASSERT_EQ(hex_decode(invalid_src, invalid_dst), -1);
+    }
+}
+
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,215 @@
+#include "frame_decoder.h"
+#include "gtest/gtest.h"
+
+using namespace basic;
+
+namespace my {
+namespace project {
+namespace {
+
+////////////////////////////测试工具函数//////////////////////////////////
+std::string
+view_to_string(const FrameView &frame)
+{
+    std::string str(frame.first, frame.first_size);
+    if (frame.second_size > 0) {
+        str.append(frame.second, frame.second_size);
+    }
+
+    return str;
+}
+
+std::string
+random_payload(int max_size, char exclude = '\0')
+{
+    std::string str;
+    int size = rand() % max_size;
+    for (int i = 0; i < size; ++i) {
+        char ch = static_cast<char>(rand() % 256);
+        str += (exclude != '\0' && ch == exclude) ? 'a' : ch;
+    }
+
+    return str;
+}
+
+// 将 stream 随机切成小块写入 buff，每写入一块就解析出所有完整的帧
+std::vector<std::string>
+feed_in_chunks(FrameDecoder &decoder, const std::string &stream, ssize_t buff_size = 64)
+{
+    std::vector<std::string> frames;
+    ByteBuffer buff(buff_size);
+    std::size_t pos = 0;
+    while (pos < stream.size()) {
+        std::size_t size = rand() % 17 + 1;
+        if (pos + size > stream.size()) {
+            size = stream.size() - pos;
+        }
+        buff.write_bytes(stream.data() + pos, size);
+        pos += size;
+
+        FrameView frame;
+        FrameStatus ret;
+        while ((ret = decoder.decode(buff, frame)) == FRAME_COMPLETE) {
+            EXPECT_EQ(static_cast<ssize_t>(view_to_string(frame).size()), frame.size);
+            frames.push_back(view_to_string(frame));
+            decoder.consume(buff, frame);
+        }
+        EXPECT_EQ(ret, FRAME_NEED_MORE);
+    }
+    EXPECT_EQ(buff.data_size(), 0);
+
+    return frames;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+class FrameDecoder_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Code here will be called immediately after the constructor (right
+        // before each test).
+    }
+
+    void TearDown() override {
+        // Code here will be called immediately after each test (right
+        // before the destructor).
+    }
+};
+
+TEST_F(FrameDecoder_Test, delimiter)
+{
+    FrameDecoder decoder("\r\n");
+    std::vector<std::string> expect;
+    std::string stream;
+    for (int i = 0; i < 300; ++i) {
+        std::string payload = random_payload(100, '\r');
+        expect.push_back(payload);
+        stream += payload + "\r\n";
+    }
+
+    ASSERT_EQ(feed_in_chunks(decoder, stream), expect);
+
+    ByteBuffer buff(std::string("abc\r\ndef")), payload;
+    ASSERT_EQ(decoder.read_frame(buff, payload), FRAME_COMPLETE);
+    ASSERT_EQ(payload.str(), "abc");
+    ASSERT_EQ(decoder.read_frame(buff, payload), FRAME_NEED_MORE);
+    ASSERT_EQ(buff.str(), "def");
+
+    decoder.set_max_frame_size(2);
+    buff.write_string("g");
+    ASSERT_EQ(decoder.read_frame(buff, payload), FRAME_ERROR);
+    ASSERT_EQ(decoder.set_delimiter(""), -1);
+
+    // 分隔符为空时使用默认的 "\n"
+    FrameDecoder fallback("");
+    ByteBuffer lines(std::string("x\ny")), line;
+    ASSERT_EQ(fallback.read_frame(lines, line), FRAME_COMPLETE);
+    ASSERT_EQ(line.str(), "x");
+    ASSERT_EQ(fallback.read_frame(lines, line), FRAME_NEED_MORE);
+}
+
+TEST_F(FrameDecoder_Test, fixed_length)
+{
+    int field_sizes[] = {1, 2, 4, 8};
+    for (int k = 0; k < 8; ++k) {
+        int field_size = field_sizes[k % 4];
+        bool big_endian = (k < 4);
+        FrameDecoder decoder;
+        ASSERT_EQ(decoder.set_fixed_length(field_size, big_endian), 0);
+
+        std::vector<std::string> expect;
+        std::string stream;
+        for (int i = 0; i < 200; ++i) {
+            std::string payload = random_payload(field_size == 1 ? 255 : 600);
+            expect.push_back(payload);
+            for (int j = 0; j < field_size; ++j) {
+                int shift = big_endian ? 8 * (field_size - 1 - j) : 8 * j;
+                stream += static_cast<char>((static_cast<uint64_t>(payload.size()) >> shift) & 0xFF);
+            }
+            stream += payload;
+        }
+
+        ASSERT_EQ(feed_in_chunks(decoder, stream), expect);
+    }
+
+    FrameDecoder decoder;
+    ASSERT_EQ(decoder.set_fixed_length(3), -1);
+}
+
+TEST_F(FrameDecoder_Test, varint_length)
+{
+    FrameDecoder decoder;
+    decoder.set_varint_length();
+
+    std::vector<std::string> expect;
+    std::string stream;
+    for (int i = 0; i < 200; ++i) {
+        std::string payload = random_payload(i % 10 == 0 ? 20000 : 300);
+        expect.push_back(payload);
+        uint64_t size = payload.size();
+        do {
+            uint8_t byte = size & 0x7F;
+            size >>= 7;
+            stream += static_cast<char>(size > 0 ? (byte | 0x80) : byte);
+        } while (size > 0);
+        stream += payload;
+    }
+
+    ASSERT_EQ(feed_in_chunks(decoder, stream), expect);
+
+    ByteBuffer buff(std::string(11, '\xff')), payload;
+    ASSERT_EQ(decoder.read_frame(buff, payload), FRAME_ERROR);
+}
+
+TEST_F(FrameDecoder_Test, http_chunked)
+{
+    FrameDecoder decoder;
+    decoder.set_http_chunked();
+
+    std::vector<std::string> expect;
+    std::string stream;
+    for (int i = 0; i < 100; ++i) {
+        std::string payload = random_payload(500) + "x";
+        char size_line[32];
+        snprintf(size_line, sizeof(size_line), (i % 2 == 0 ? "%zx" : "%zX;ext=1"), payload.size());
+        expect.push_back(payload);
+        stream += std::string(size_line) + "\r\n" + payload + "\r\n";
+    }
+    expect.push_back("");
+    stream += "0\r\nTrailer: value\r\n\r\n";
+    expect.push_back("last");
+    stream += "4\r\nlast\r\n";
+    expect.push_back("");
+    stream += "0\r\n\r\n";
+
+    ASSERT_EQ(feed_in_chunks(decoder, stream), expect);
+
+    const char *invalid[] = {"zz\r\n", "3\r\nabcde\r\n", "\r\n"};
+    for (int i = 0; i < 3; ++i) {
+        decoder.reset();
+        ByteBuffer buff(std::string(invalid[i])), payload;
+        ASSERT_EQ(decoder.read_frame(buff, payload), FRAME_ERROR);
+    }
+
+    // 没有结束的 trailer 不能无限增长
+    decoder.reset();
+    decoder.set_max_frame_size(64);
+    ByteBuffer buff(std::string("0\r\n")), payload;
+    FrameStatus status = FRAME_NEED_MORE;
+    for (int i = 0; i < 100 && status == FRAME_NEED_MORE; ++i) {
+        std::string line = "X-Trailer: value\r\n";
+        buff.write_bytes(line.data(), line.size());
+        status = decoder.read_frame(buff, payload);
+    }
+    ASSERT_EQ(status, FRAME_ERROR);
+}
+
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
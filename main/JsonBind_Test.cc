@@ -0,0 +1,182 @@
+#include "json_bind.h"
+#include "gtest/gtest.h"
+
+using namespace basic;
+
+namespace my {
+namespace project {
+namespace {
+
+enum Side {
+    SIDE_BUY = 1,
+    SIDE_SELL = 2
+};
+
+struct Fill {
+    double price = 0;
+    uint32_t qty = 0;
+};
+JSON_BIND(Fill, JSON_FIELD(price), JSON_FIELD(qty))
+
+struct Order {
+    int64_t id = 0;
+    std::string symbol;
+    Side side = SIDE_BUY;
+    bool active = false;
+    std::vector<Fill> fills;
+    std::vector<std::string> tags;
+    std::map<std::string, int> counters;
+    JsonValue extra;
+    int untouched = 42;
+};
+JSON_BIND(Order, JSON_FIELD(id), JSON_FIELD(symbol), JSON_FIELD(side), JSON_FIELD(active),
+          JSON_FIELD(fills), JSON_FIELD(tags), JSON_FIELD(counters),
+          JSON_FIELD(extra))
+
+#if __cplusplus >= 201703L
+struct Quote {
+    int64_t id = 0;
+    std::optional<double> limit;
+};
+JSON_BIND(Quote, JSON_FIELD(id), JSON_FIELD_NAMED(limit, "limit_price"))
+#endif
+
+class JsonBind_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Code here will be called immediately after the constructor (right
+        // before each test).
+    }
+
+    void TearDown() override {
+        // Code here will be called immediately after each test (right
+        // before the destructor).
+    }
+};
+
+TEST_F(JsonBind_Test, DecodeTest)
+{
+    static_assert(JsonBound<Order>::value, "Order is bound");
+    static_assert(!JsonBound<int>::value, "int is not bound");
+
+    std::string text = "{\"id\": 12345678901234, \"symbol\": \"AB\\\"C\", // comment\n"
+                       " \"unknown\": {\"x\": [1, \"]}\", {\"y\": null}]}, \"side\": 2, \"active\": true,"
+                       " \"fills\": [{\"price\": 1.5, \"qty\": 10, \"skip\": [[]]}, {\"qty\": 3, \"price\": 2}],"
+                       " \"tags\": [\"a\", \"b\"], \"counters\": {\"x\": 1, \"y\": -2}, \"limit_price\": 9.25,"
+                       " \"extra\": {\"k\": [1, 2]}, \"untouched\": 7, \"more\": false}  ";
+    Order order;
+    ASSERT_EQ(json_decode(text, order), static_cast<ssize_t>(text.size()));
+    ASSERT_EQ(order.id, 12345678901234);
+    ASSERT_EQ(order.symbol, "AB\\\"C");
+    ASSERT_EQ(order.side, SIDE_SELL);
+    ASSERT_EQ(order.active, true);
+    ASSERT_EQ(order.fills.size(), 2);
+    ASSERT_EQ(order.fills[0].price, 1.5);
+    ASSERT_EQ(order.fills[0].qty, 10);
+    ASSERT_EQ(order.fills[1].price, 2);
+    ASSERT_EQ(order.fills[1].qty, 3);
+    ASSERT_EQ(order.tags, std::vector<std::string>({"a", "b"}));
+    ASSERT_EQ(order.counters["y"], -2);
+    ASSERT_EQ(order.extra["k"][1].to_string(), "2");
+    // 没有绑定的成员不会被修改
+    ASSERT_EQ(order.untouched, 42);
+
+    // 缺少的成员和 null 保持原值
+    Order partial;
+    partial.symbol = "keep";
+    json_decode(std::string("{\"id\": 1, \"symbol\": null}"), partial);
+    ASSERT_EQ(partial.id, 1);
+    ASSERT_EQ(partial.symbol, "keep");
+
+    // 顶层可以是数组
+    std::vector<Fill> fills;
+    json_decode(std::string("[{\"price\": 1}, {\"qty\": 4294967295}]"), fills);
+    ASSERT_EQ(fills.size(), 2);
+    ASSERT_EQ(fills[1].qty, 4294967295U);
+}
+
+TEST_F(JsonBind_Test, ErrorTest)
+{
+    Order order;
+    Fill fill;
+    ASSERT_THROW(json_decode(std::string("{\"qty\": -1}"), fill), std::runtime_error);
+    ASSERT_THROW(json_decode(std::string("{\"qty\": 4294967296}"), fill), std::runtime_error);
+    ASSERT_THROW(json_decode(std::string("{\"qty\": 1.5}"), fill), std::runtime_error);
+    ASSERT_THROW(json_decode(std::string("{\"price\": \"1\"}"), fill), std::runtime_error);
+    ASSERT_THROW(json_decode(std::string("{\"price\": 1 \"qty\": 2}"), fill), std::runtime_error);
+    ASSERT_THROW(json_decode(std::string("{\"price\": 1,}"), fill), std::runtime_error);
+    ASSERT_THROW(json_decode(std::string("{\"price\": 1"), fill), std::runtime_error);
+    ASSERT_THROW(json_decode(std::string("{\"price\": 1} x"), fill), std::runtime_error);
+    ASSERT_THROW(json_decode(std::string("[]"), fill), std::runtime_error);
+    ASSERT_THROW(json_decode(std::string("{\"active\": tru}"), order), std::runtime_error);
+    ASSERT_THROW(json_decode(std::string("{\"fills\": [1]}"), order), std::runtime_error);
+    ASSERT_THROW(json_decode(std::string("{\"unknown\": [1, {]}"), order), std::runtime_error);
+    ASSERT_THROW(json_decode(std::string(""), order), std::runtime_error);
+}
+
+TEST_F(JsonBind_Test, EncodeTest)
+{
+    Order order;
+    order.id = -5;
+    order.symbol = "XY";
+    order.side = SIDE_SELL;
+    Fill fill;
+    fill.price = 0.1;
+    fill.qty = 2;
+    order.fills.push_back(fill);
+    order.tags.push_back("t");
+    order.counters["b"] = 2;
+    order.counters["a"] = 1;
+    // 临时文档中的值移动出来之后拷贝到堆上，文档销毁后仍然可以使用
+    order.extra = WeJson("{\"k\": [true]}");
+
+    std::string text = json_encode(order);
+    ASSERT_EQ(text, "{\"id\":-5,\"symbol\":\"XY\",\"side\":2,\"active\":false,\"fills\":[{\"price\":0.1,\"qty\":2}],"
+                    "\"tags\":[\"t\"],\"counters\":{\"a\":1,\"b\":2},\"extra\":{\"k\":[true]}}");
+
+    // 编码后再解码得到相同的值，和 WeJson 解析的结果一致
+    order.fills[0].price = 1e21;
+    Order decoded;
+    json_decode(json_encode(order), decoded);
+    ASSERT_EQ(decoded.id, order.id);
+    ASSERT_EQ(decoded.fills[0].price, 1e21);
+    ASSERT_EQ(decoded.extra.to_string(), "{\"k\":[true]}");
+    ASSERT_EQ(decoded.extra == order.extra, true);
+    ASSERT_EQ(WeJson(json_encode(decoded)) == WeJson(json_encode(order)), true);
+    decoded.extra["k"][0] = JsonValue(false);
+    ASSERT_EQ(decoded.extra == order.extra, false);
+
+    std::string out = "prefix";
+    ASSERT_EQ(json_encode(std::vector<int>({1, -2}), out), 6);
+    ASSERT_EQ(out, "prefix[1,-2]");
+}
+
+#if __cplusplus >= 201703L
+TEST_F(JsonBind_Test, OptionalTest)
+{
+    // std::optional 需要 C++17：null 清空，没有值时不输出
+    Quote quote;
+    json_decode(std::string("{\"id\": 1, \"limit_price\": 9.25}"), quote);
+    ASSERT_EQ(quote.limit.value(), 9.25);
+    json_decode(std::string("{\"id\": 2}"), quote);
+    ASSERT_EQ(quote.limit.value(), 9.25);
+    json_decode(std::string("{\"limit_price\": null}"), quote);
+    ASSERT_EQ(quote.limit.has_value(), false);
+    ASSERT_EQ(json_encode(quote), "{\"id\":2}");
+
+    quote.limit = 1e21;
+    Quote decoded;
+    json_decode(json_encode(quote), decoded);
+    ASSERT_EQ(decoded.limit.value(), 1e21);
+}
+#endif
+
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,271 @@
+#include "json_cbor.h"
+#include "gtest/gtest.h"
+
+using namespace basic;
+
+namespace my {
+namespace project {
+namespace {
+
+std::string
+from_hex(const std::string &hex)
+{
+    std::string bytes;
+    for (std::size_t i = 0; i + 1 < hex.size(); i += 2) {
+        bytes += static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16));
+    }
+    return bytes;
+}
+
+std::string
+to_hex(const std::string &bytes)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        hex += digits[static_cast<uint8_t>(bytes[i]) >> 4];
+        hex += digits[static_cast<uint8_t>(bytes[i]) & 0xf];
+    }
+    return hex;
+}
+
+std::string
+encode_hex(const std::string &json)
+{
+    WeJson js("[" + json + "]");
+    std::string out;
+    cbor_encode(js.get_array()[0], out);
+    return to_hex(out);
+}
+
+std::string
+decode_json(const std::string &hex)
+{
+    std::string bytes = from_hex(hex);
+    JsonValue value;
+    EXPECT_EQ(cbor_decode(bytes.data(), bytes.size(), value), static_cast<ssize_t>(bytes.size()));
+    JsonArray array;
+    array.add(value);
+    std::string text = array.to_string();
+    return text.substr(1, text.size() - 2);
+}
+
+// 记录所有事件，用于比较分段解码的结果
+class EventRecorder : public JsonHandler {
+public:
+    virtual bool start_object(void) override {events += "{"; return true;}
+    virtual bool key(const char *str, ssize_t size) override {events += "k:" + std::string(str, size) + " "; return true;}
+    virtual bool end_object(void) override {events += "}"; return true;}
+    virtual bool start_array(void) override {events += "["; return true;}
+    virtual bool end_array(void) override {events += "]"; return true;}
+    virtual bool string(const char *str, ssize_t size) override {events += "s:" + std::string(str, size) + " "; return true;}
+    virtual bool number(double value) override {events += "d:" + std::to_string(value) + " "; return true;}
+    virtual bool integer(int64_t value) override {events += "i:" + std::to_string(value) + " "; return true;}
+    virtual bool unsigned_integer(uint64_t value) override {events += "u:" + std::to_string(value) + " "; return true;}
+    virtual bool boolean(bool value) override {events += value ? "true " : "false "; return true;}
+    virtual bool null(void) override {events += "null "; return true;}
+
+    std::string events;
+};
+
+class JsonCbor_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Code here will be called immediately after the constructor (right
+        // before each test).
+    }
+
+    void TearDown() override {
+        // Code here will be called immediately after each test (right
+        // before the destructor).
+    }
+};
+
+TEST_F(JsonCbor_Test, EncodeTest)
+{
+    // RFC 8949 附录 A 中的例子
+    ASSERT_EQ(encode_hex("0"), "00");
+    ASSERT_EQ(encode_hex("23"), "17");
+    ASSERT_EQ(encode_hex("24"), "1818");
+    ASSERT_EQ(encode_hex("1000"), "1903e8");
+    ASSERT_EQ(encode_hex("1000000"), "1a000f4240");
+    ASSERT_EQ(encode_hex("1000000000000"), "1b000000e8d4a51000");
+    ASSERT_EQ(encode_hex("18446744073709551615"), "1bffffffffffffffff");
+    ASSERT_EQ(encode_hex("-1"), "20");
+    ASSERT_EQ(encode_hex("-1000"), "3903e7");
+    ASSERT_EQ(encode_hex("-9223372036854775808"), "3b7fffffffffffffff");
+    ASSERT_EQ(encode_hex("1.1"), "fb3ff199999999999a");
+    ASSERT_EQ(encode_hex("1.5"), "fa3fc00000");
+    ASSERT_EQ(encode_hex("-4.1"), "fbc010666666666666");
+    ASSERT_EQ(encode_hex("1e300"), "fb7e37e43c8800759c");
+    ASSERT_EQ(encode_hex("true"), "f5");
+    ASSERT_EQ(encode_hex("false"), "f4");
+    ASSERT_EQ(encode_hex("null"), "f6");
+    ASSERT_EQ(encode_hex("\"\""), "60");
+    ASSERT_EQ(encode_hex("\"IETF\""), "6449455446");
+    ASSERT_EQ(encode_hex("\"\\\"\\\\\""), "62225c");
+    ASSERT_EQ(encode_hex("\"\\u00fc\""), "62c3bc");
+    ASSERT_EQ(encode_hex("\"\\u6c34\""), "63e6b0b4");
+    ASSERT_EQ(encode_hex("\"\\ud800\\udd51\""), "64f0908591");
+    ASSERT_EQ(encode_hex("[]"), "80");
+    ASSERT_EQ(encode_hex("[1, [2, 3], [4, 5]]"), "8301820203820405");
+    ASSERT_EQ(encode_hex("{}"), "a0");
+    ASSERT_EQ(encode_hex("{\"a\": 1, \"b\": [2, 3]}"), "a26161016162820203");
+
+    // 直接转码时容器使用不定长形式
+    std::string out;
+    std::string text = "// comment\n{\"a\": 1, \"b\": [2, 3]}";
+    ASSERT_EQ(json_to_cbor(text.data(), text.size(), out), 11);
+    ASSERT_EQ(to_hex(out), "bf61610161629f0203ffff");
+
+    ByteBuffer buff;
+    WeJson js("{\"a\": [1.5, \"x\"]}");
+    ASSERT_EQ(cbor_encode(js, buff), 11);
+    std::string bytes(buff.data_size(), '\0');
+    buff.read_only(0, &bytes[0], bytes.size());
+    ASSERT_EQ(to_hex(bytes), "a1616182fa3fc000006178");
+}
+
+TEST_F(JsonCbor_Test, DecodeTest)
+{
+    ASSERT_EQ(decode_json("00"), "0");
+    ASSERT_EQ(decode_json("1818"), "24");
+    ASSERT_EQ(decode_json("1bffffffffffffffff"), "18446744073709551615");
+    ASSERT_EQ(decode_json("3903e7"), "-1000");
+    ASSERT_EQ(decode_json("3bffffffffffffffff"), "-18446744073709552000");
+    ASSERT_EQ(decode_json("f90000"), "0");
+    ASSERT_EQ(decode_json("f93c00"), "1");
+    ASSERT_EQ(decode_json("f97bff"), "65504");
+    ASSERT_EQ(decode_json("f90001"), "5.960464477539063e-8");
+    ASSERT_EQ(decode_json("f9c400"), "-4");
+    ASSERT_EQ(decode_json("fa47c35000"), "100000");
+    ASSERT_EQ(decode_json("fb3ff199999999999a"), "1.1");
+    ASSERT_EQ(decode_json("f7"), "null");
+    ASSERT_EQ(decode_json("c074323031332d30332d32315432303a30343a30305a"), "\"2013-03-21T20:04:00Z\"");
+    ASSERT_EQ(decode_json("62225c"), "\"\\\"\\\\\"");
+    ASSERT_EQ(decode_json("620a01"), "\"\\n\\u0001\"");
+    ASSERT_EQ(decode_json("7f657374726561646d696e67ff"), "\"streaming\"");
+    ASSERT_EQ(decode_json("9f018202039f0405ffff"), "[1,[2,3],[4,5]]");
+    ASSERT_EQ(decode_json("83019f0203ff820405"), "[1,[2,3],[4,5]]");
+    ASSERT_EQ(decode_json("bf61610161629f0203ffff"), "{\"a\":1,\"b\":[2,3]}");
+    ASSERT_EQ(decode_json("a56161614161626142616361436164614461656145"), "{\"a\":\"A\",\"b\":\"B\",\"c\":\"C\",\"d\":\"D\",\"e\":\"E\"}");
+    ASSERT_EQ(decode_json("bf6346756ef563416d7421ff"), "{\"Fun\":true,\"Amt\":-2}");
+
+    // 数据项之后的数据不会被消耗
+    std::string bytes = from_hex("8201020304");
+    JsonValue value;
+    ASSERT_EQ(cbor_decode(bytes.data(), bytes.size(), value), 3);
+
+    const char *invalid[] = {
+        "",             // 数据不完整
+        "1a0000",
+        "8301",
+        "6361",
+        "bf6161ff",     // 映射中缺少值
+        "a10102",       // key 不是文本字符串
+        "4161",         // 字节字符串
+        "7f4161ff",     // 不定长文本字符串中的分块不是文本字符串
+        "ff",           // 没有对应的不定长容器
+        "1c",           // 保留的参数
+        "f0",           // 不支持的简单值
+    };
+    for (std::size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+        std::string data = from_hex(invalid[i]);
+        ASSERT_THROW(cbor_decode(data.data(), data.size(), value), std::runtime_error) << invalid[i];
+    }
+}
+
+TEST_F(JsonCbor_Test, RoundTripTest)
+{
+    std::string text = "{\"id\": 12345678901234, \"neg\": -42, \"big\": 18446744073709551615, \"pi\": 3.14159,"
+                       " \"half\": 0.5, \"s\": \"tab\\there \\\"quoted\\\" \\u4e2d\\u6587 /\", \"ok\": true, \"none\": null,"
+                       " \"list\": [1, [2, [3, {}]], [], {\"k\": \"v\"}], \"empty\": \"\"}";
+    WeJson js(text);
+
+    // 树编码、直接转码和 WeJson::parse_cbor 得到相同的 json 树
+    std::string tree_cbor, stream_cbor;
+    cbor_encode(js, tree_cbor);
+    json_to_cbor(text.data(), text.size(), stream_cbor);
+    ASSERT_LT(tree_cbor.size(), text.size());
+
+    JsonValue from_tree, from_stream;
+    cbor_decode(tree_cbor.data(), tree_cbor.size(), from_tree);
+    cbor_decode(stream_cbor.data(), stream_cbor.size(), from_stream);
+    ASSERT_EQ(from_tree == from_stream, true);
+
+    WeJson doc;
+    doc.parse_cbor(tree_cbor.data(), tree_cbor.size());
+    ASSERT_EQ(doc == from_tree, true);
+    ASSERT_EQ(static_cast<JsonNumber>(doc["big"]).to_uint(), 18446744073709551615ULL);
+    ASSERT_EQ(static_cast<JsonNumber>(doc["id"]).kind(), JSON_NUMBER_INT);
+    ASSERT_EQ(doc["s"].to_string(), "tab\\there \\\"quoted\\\" 中文 /");
+
+    // 没有 \u 转义时和原来的文本完全一致
+    WeJson plain("{\"a\": [1, -2.5, \"x\\\\y\\n\"], \"b\": {\"c\": false}}");
+    std::string cbor;
+    cbor_encode(plain, cbor);
+    doc.parse_cbor(ByteBuffer(cbor));
+    ASSERT_EQ(doc.to_string(), plain.to_string());
+}
+
+TEST_F(JsonCbor_Test, StreamTest)
+{
+    std::string text = "{\"name\": \"a fairly long string that is split across chunks\", \"values\": [1, 300, 70000, 5000000000, -1.25, 1.1],"
+                       " \"nested\": {\"deep\": [[[\"x\"]]]}, \"flags\": [true, false, null]}";
+    std::string cbor;
+    json_to_cbor(text.data(), text.size(), cbor);
+    cbor_encode(WeJson(text), cbor);
+
+    // 一次传入和逐字节传入产生相同的事件，两个数据项依次解码
+    EventRecorder whole;
+    CborStreamParser parser(whole);
+    ssize_t first_size = parser.feed(cbor.data(), cbor.size());
+    ASSERT_EQ(parser.is_complete(), true);
+    ASSERT_LT(first_size, static_cast<ssize_t>(cbor.size()));
+    std::string first_events = whole.events;
+    parser.reset();
+    ASSERT_EQ(parser.feed(cbor.data() + first_size, cbor.size() - first_size), static_cast<ssize_t>(cbor.size()) - first_size);
+    ASSERT_EQ(parser.is_complete(), true);
+
+    for (std::size_t step = 1; step <= 7; step += 3) {
+        EventRecorder pieces;
+        CborStreamParser stream(pieces);
+        std::size_t pos = 0;
+        while (stream.need_more()) {
+            std::size_t size = std::min(step, cbor.size() - pos);
+            ssize_t ret = stream.feed(cbor.data() + pos, size);
+            ASSERT_GT(ret, 0);
+            pos += ret;
+        }
+        ASSERT_EQ(stream.consumed(), first_size);
+        ASSERT_EQ(pieces.events, first_events);
+    }
+
+    // 从 ByteBuffer 中消耗数据
+    ByteBuffer buff(cbor);
+    EventRecorder from_buff;
+    CborStreamParser buff_parser(from_buff);
+    ASSERT_EQ(buff_parser.feed(buff), first_size);
+    ASSERT_EQ(buff.data_size(), static_cast<ssize_t>(cbor.size()) - first_size);
+
+    // 格式错误之后需要 reset
+    EventRecorder recorder;
+    CborStreamParser bad(recorder);
+    std::string data = from_hex("a10102");
+    ASSERT_THROW(bad.feed(data.data(), data.size()), std::runtime_error);
+    ASSERT_THROW(bad.feed(data.data(), data.size()), std::runtime_error);
+    bad.reset();
+    data = from_hex("f5");
+    ASSERT_EQ(bad.feed(data.data(), data.size()), 1);
+    ASSERT_EQ(bad.is_complete(), true);
+}
+
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
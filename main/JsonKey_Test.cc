@@ -0,0 +1,164 @@
+#include "json_key.h"
+#include "ndjson_reader.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace basic;
+
+namespace my {
+namespace project {
+namespace {
+
+class JsonKey_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Code here will be called immediately after the constructor (right
+        // before each test).
+    }
+
+    void TearDown() override {
+        // Code here will be called immediately after each test (right
+        // before the destructor).
+    }
+};
+
+TEST_F(JsonKey_Test, KeyTest)
+{
+    JsonArena arena;
+    JsonKey empty;
+    ASSERT_EQ(empty.size(), 0);
+    ASSERT_STREQ(empty.c_str(), "");
+
+    // 短的 key 保存在 JsonKey 中，长的在 arena 或堆上
+    const std::string names[] = {"name", "a long key stored outside of the object"};
+    for (std::size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        const std::string &name = names[i];
+        JsonKey heap_key(name);
+        JsonKey arena_key(name.data(), name.size(), &arena);
+        ASSERT_EQ(heap_key == arena_key, true);
+        ASSERT_EQ(arena_key, name);
+        ASSERT_STREQ(arena_key.c_str(), name.c_str());
+        ASSERT_EQ(heap_key.hash(), JsonKey::hash_string(name.data(), name.size()));
+
+        // 拷贝出来的 key 不在 arena 中
+        JsonKey copy(arena_key);
+        ASSERT_NE(copy.data(), arena_key.data());
+        ASSERT_EQ(copy, name);
+        JsonKey moved(std::move(copy));
+        ASSERT_EQ(moved, name);
+        ASSERT_EQ(copy.empty(), true);
+        copy = moved;
+        moved = JsonKey();
+        ASSERT_EQ(copy, name);
+        ASSERT_EQ(moved.empty(), true);
+    }
+    ASSERT_GT(arena.used(), names[1].size());
+
+    // 可以像原来的 std::string key 一样使用
+    JsonKey key(std::string("name"));
+    std::string str = key;
+    ASSERT_EQ(str, "name");
+    str = key;
+    ASSERT_EQ(str, key.to_string());
+    WeJson js("{\"id\":1}");
+    std::string first = js.get_object().begin()->first;
+    ASSERT_EQ(first, "id");
+
+    ASSERT_EQ(JsonKey(std::string("ab")) < JsonKey(std::string("abc")), true);
+    ASSERT_EQ(JsonKey(std::string("b")) < JsonKey(std::string("abc")), false);
+}
+
+TEST_F(JsonKey_Test, InternTest)
+{
+    JsonKeyTable table;
+    JsonKey a = table.intern("id");
+    JsonKey b = table.intern(std::string("id"));
+    ASSERT_EQ(a.is_interned(), true);
+    ASSERT_EQ(a.data(), b.data());
+    ASSERT_EQ(a == b, true);
+    ASSERT_EQ(a == table.intern("name"), false);
+    ASSERT_EQ(a == JsonKey(std::string("id")), true);
+    ASSERT_EQ(table.size(), 2);
+
+    // 拷贝驻留的 key 不复制字符串
+    JsonKey copy(a);
+    ASSERT_EQ(copy.data(), a.data());
+
+    // 多个线程同时驻留相同的 key
+    std::vector<std::thread> threads;
+    std::vector<std::vector<const char*>> results(8);
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&table, &results, t]() {
+            for (int i = 0; i < 5000; ++i) {
+                results[t].push_back(table.intern("key" + std::to_string(i % 1000)).data());
+            }
+        });
+    }
+    for (std::size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    ASSERT_EQ(table.size(), 1002);
+    for (int t = 1; t < 8; ++t) {
+        ASSERT_EQ(results[t], results[0]);
+    }
+}
+
+TEST_F(JsonKey_Test, DocumentTest)
+{
+    JsonKeyTable table;
+    std::string text = "{\"id\": 1, \"name\": \"a\", \"tags\": [{\"id\": 2}, {\"id\": 3}]}";
+
+    WeJson first;
+    first.set_key_table(&table);
+    first.parse(text);
+    WeJson second;
+    second.set_key_table(&table);
+    second.parse(text);
+    ASSERT_EQ(table.size(), 3);
+    ASSERT_EQ(first.to_string(), "{\"id\":1,\"name\":\"a\",\"tags\":[{\"id\":2},{\"id\":3}]}");
+    ASSERT_EQ(first == second, true);
+
+    // 不同文档中相同的 key 共享同一个字符串
+    JsonObject &object = first.get_object();
+    ASSERT_EQ(object.begin()->first.data(), second.get_object().begin()->first.data());
+    ASSERT_EQ(object.begin()->first.data(), table.intern("id").data());
+    ASSERT_EQ(object.find(table.intern("name")) != object.end(), true);
+    ASSERT_EQ(object.find(table.intern("missing")) == object.end(), true);
+    ASSERT_EQ(object.find(std::string("tags")) != object.end(), true);
+
+    // 拷贝和修改
+    WeJson copy(first);
+    ASSERT_EQ(copy.get_object().begin()->first.data(), table.intern("id").data());
+    copy.get_object().add("extra", JsonValue(true));
+    ASSERT_EQ(copy.get_object().begin()->first.is_interned(), true);
+    ASSERT_EQ((++copy.get_object().begin())->first.is_interned(), true);
+    ASSERT_EQ(copy == first, false);
+
+    // 重复的 key 仍然能检查出来
+    WeJson dup;
+    dup.set_key_table(&table);
+    ASSERT_THROW(dup.parse(std::string("{\"id\": 1, \"id\": 2}")), std::runtime_error);
+
+    // NdJsonReader 的所有记录共享驻留表
+    std::string lines;
+    for (int i = 0; i < 500; ++i) {
+        lines += "{\"id\": " + std::to_string(i) + ", \"name\": \"n\"}\n";
+    }
+    NdJsonReader reader(2);
+    reader.set_key_table(&table);
+    std::vector<WeJson> records;
+    ASSERT_EQ(reader.parse(lines.data(), lines.size(), records), 500);
+    ASSERT_EQ(table.size(), 4);
+    ASSERT_EQ(records[499].get_object().begin()->first.data(), table.intern("id").data());
+}
+
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
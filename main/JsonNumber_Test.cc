@@ -0,0 +1,179 @@
+#include "json_number.h"
+#include "wejson.h"
+#include "gtest/gtest.h"
+
+#include <random>
+
+using namespace basic;
+
+namespace my {
+namespace project {
+namespace {
+
+class JsonNumber_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Code here will be called immediately after the constructor (right
+        // before each test).
+    }
+
+    void TearDown() override {
+        // Code here will be called immediately after each test (right
+        // before the destructor).
+    }
+};
+
+// 解析结果转为 double 后和 strtod 的结果需要完全一致，整数保存为精确值
+void check_double(const std::string &text)
+{
+    JsonNumberLiteral number;
+    const char *end = parse_json_number(text.data(), text.data() + text.size(), number);
+    ASSERT_EQ(end, text.data() + text.size()) << text;
+    bool is_integer = (text.find_first_of(".eE") == std::string::npos);
+    if (!is_integer) {
+        ASSERT_EQ(number.kind, JSON_NUMBER_DOUBLE) << text;
+    }
+
+    double value = JsonNumber(number).to_double();
+    double expected = strtod(text.c_str(), nullptr);
+    ASSERT_EQ(memcmp(&value, &expected, sizeof(double)), 0) << text << " " << value << " " << expected;
+}
+
+TEST_F(JsonNumber_Test, IntegerTest)
+{
+    JsonNumberLiteral number;
+    std::string text = "9007199254740993";  // 2^53 + 1
+    parse_json_number(text.data(), text.data() + text.size(), number);
+    ASSERT_EQ(number.kind, JSON_NUMBER_INT);
+    ASSERT_EQ(number.i, 9007199254740993LL);
+
+    text = "-9223372036854775808";
+    parse_json_number(text.data(), text.data() + text.size(), number);
+    ASSERT_EQ(number.kind, JSON_NUMBER_INT);
+    ASSERT_EQ(number.i, INT64_MIN);
+
+    text = "18446744073709551615";
+    parse_json_number(text.data(), text.data() + text.size(), number);
+    ASSERT_EQ(number.kind, JSON_NUMBER_UINT);
+    ASSERT_EQ(number.u, UINT64_MAX);
+
+    // 超出 64 位整数范围时保存为 double
+    const char *overflow_texts[] = {"18446744073709551616", "-9223372036854775809", "-0"};
+    for (std::size_t i = 0; i < sizeof(overflow_texts) / sizeof(overflow_texts[0]); ++i) {
+        const char *end = parse_json_number(overflow_texts[i], overflow_texts[i] + strlen(overflow_texts[i]), number);
+        ASSERT_EQ(end, overflow_texts[i] + strlen(overflow_texts[i]));
+        ASSERT_EQ(number.kind, JSON_NUMBER_DOUBLE) << overflow_texts[i];
+        check_double(overflow_texts[i]);
+    }
+
+    // 通过 WeJson 解析和输出时保持精确值
+    WeJson js("{\"id\": 1234567890123456789, \"big\": 18446744073709551615, \"neg\": -42}");
+    JsonNumber id = js["id"];
+    ASSERT_EQ(id.is_integer(), true);
+    ASSERT_EQ(id.to_int(), 1234567890123456789LL);
+    ASSERT_EQ(static_cast<JsonNumber>(js["big"]).to_uint(), UINT64_MAX);
+    ASSERT_EQ(static_cast<JsonNumber>(js["neg"]).to_int(), -42);
+    ASSERT_EQ(js.to_string(), "{\"id\":1234567890123456789,\"big\":18446744073709551615,\"neg\":-42}");
+
+    WeJson copy(js);
+    ASSERT_EQ(copy == js, true);
+    ASSERT_EQ(JsonNumber(1) == JsonNumber(1.0), true);
+}
+
+TEST_F(JsonNumber_Test, DoubleTest)
+{
+    const char *texts[] = {
+        "0.1", "1.5", "-2.25e-3", "3.141592653589793", "1e23", "8.98846567431158e307",
+        "1.7976931348623157e308", "2.2250738585072014e-308", "4.9e-324", "1e-400", "1e400",
+        "0.000000000000000000000000000000000000000000001", "123456789012345678901234567890",
+        "9007199254740993.0", "2.00000000000000011102230246251565404236316680908203125",
+        "1.00000000000000011102230246251565404236316680908203125", "7.2057594037927933e16",
+        "+1E+2", "5e-324", "2.4703282292062327e-324"
+    };
+    for (std::size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i) {
+        check_double(texts[i]);
+    }
+
+    // 随机的 double 按最短和完整精度输出之后再解析
+    std::mt19937_64 rng(20240601);
+    char buf[64];
+    for (int i = 0; i < 200000; ++i) {
+        uint64_t bits = rng();
+        double value = 0;
+        memcpy(&value, &bits, sizeof(value));
+        if (value != value || value - value != 0) { // NaN 和无穷大
+            continue;
+        }
+        snprintf(buf, sizeof(buf), "%.17g", value);
+        check_double(buf);
+        snprintf(buf, sizeof(buf), "%.*e", static_cast<int>(rng() % 17), value);
+        check_double(buf);
+    }
+
+    // 随机的十进制数字
+    for (int i = 0; i < 100000; ++i) {
+        std::string text = std::to_string(rng() % 100000000000ULL) + "." + std::to_string(rng()) + "e" + std::to_string(static_cast<int>(rng() % 700) - 350);
+        check_double(text);
+    }
+}
+
+TEST_F(JsonNumber_Test, FormatTest)
+{
+    char buf[JSON_NUMBER_BUFFER_SIZE];
+    const double values[] = {0.0, -0.0, 1.0, 0.1, 0.3, 1.5e-7, 123.456, 1e21, 1e20, 5e-324, 1.7976931348623157e308, 2.2250738585072014e-308, -1234567.125};
+    const char *expected[] = {"0", "-0", "1", "0.1", "0.3", "1.5e-7", "123.456", "1e+21", "100000000000000000000", "5e-324", "1.7976931348623157e+308", "2.2250738585072014e-308", "-1234567.125"};
+    for (std::size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        ASSERT_EQ(std::string(buf, format_json_double(values[i], buf) - buf), expected[i]);
+    }
+    ASSERT_EQ(std::string(buf, format_json_double(0.0 / 0.0, buf) - buf), "null");
+
+    // 随机的 double 输出之后再解析需要得到原值
+    std::mt19937_64 rng(20240602);
+    for (int i = 0; i < 200000; ++i) {
+        uint64_t bits = rng();
+        double value = 0;
+        memcpy(&value, &bits, sizeof(value));
+        if (value != value || value - value != 0) {
+            continue;
+        }
+        std::string text(buf, format_json_double(value, buf) - buf);
+        double parsed = strtod(text.c_str(), nullptr);
+        ASSERT_EQ(memcmp(&parsed, &value, sizeof(double)), 0) << text;
+        ASSERT_LT(text.size(), JSON_NUMBER_BUFFER_SIZE) << text;
+    }
+
+    for (int i = 0; i < 100000; ++i) {
+        uint64_t value = rng() >> (rng() % 64);
+        ASSERT_EQ(std::string(buf, format_json_uint(value, buf) - buf), std::to_string(value));
+        int64_t signed_value = static_cast<int64_t>(value);
+        ASSERT_EQ(std::string(buf, format_json_int(signed_value, buf) - buf), std::to_string(signed_value));
+    }
+    ASSERT_EQ(std::string(buf, format_json_int(INT64_MIN, buf) - buf), "-9223372036854775808");
+}
+
+TEST_F(JsonNumber_Test, ErrorTest)
+{
+    const char *texts[] = {"-", "01", "1.", "1.e5", "1e", "1e+", ".5", "abc"};
+    for (std::size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i) {
+        JsonNumberLiteral number;
+        const char *error = nullptr;
+        ASSERT_EQ(parse_json_number(texts[i], texts[i] + strlen(texts[i]), number, &error), nullptr) << texts[i];
+        ASSERT_NE(error, nullptr);
+    }
+
+    // 数值之后的内容不属于数值
+    std::string text = "12,34";
+    JsonNumberLiteral number;
+    ASSERT_EQ(parse_json_number(text.data(), text.data() + text.size(), number), text.data() + 2);
+    ASSERT_EQ(number.i, 12);
+}
+
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
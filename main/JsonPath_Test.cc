@@ -0,0 +1,168 @@
+#include "json_path.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace basic;
+
+namespace my {
+namespace project {
+namespace {
+
+class JsonPath_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Code here will be called immediately after the constructor (right
+        // before each test).
+    }
+
+    void TearDown() override {
+        // Code here will be called immediately after each test (right
+        // before the destructor).
+    }
+};
+
+TEST_F(JsonPath_Test, PointerTest)
+{
+    WeJson js("{\"a\": {\"b\": [10, {\"c\": \"x\"}]}, \"a/b\": 1, \"m~n\": 2, \"0\": \"zero\", \"\": 3}");
+    const JsonValue &root = js;
+
+    ASSERT_EQ(JsonPath("").find(root), &root);
+    ASSERT_EQ(JsonPath().size(), 0);
+    ASSERT_EQ(JsonPath("/a/b/1/c").find(root)->to_string(), "x");
+    ASSERT_EQ(JsonPath("/a/b/0").find(root)->to_string(), "10");
+    ASSERT_EQ(JsonPath("/a~1b").find(root)->to_string(), "1");
+    ASSERT_EQ(JsonPath("/m~0n").find(root)->to_string(), "2");
+    ASSERT_EQ(JsonPath("/0").find(root)->to_string(), "zero");
+    ASSERT_EQ(JsonPath("/").find(root)->to_string(), "3");
+
+    // 找不到时返回空指针，不抛出异常
+    ASSERT_EQ(JsonPath("/a/b/2").find(root), nullptr);
+    ASSERT_EQ(JsonPath("/a/b/01").find(root), nullptr);
+    ASSERT_EQ(JsonPath("/a/b/-").find(root), nullptr);
+    ASSERT_EQ(JsonPath("/a/missing").find(root), nullptr);
+    ASSERT_EQ(JsonPath("/a/b/0/c").find(root), nullptr);
+
+    ASSERT_THROW(JsonPath::from_pointer("a/b"), std::runtime_error);
+    ASSERT_THROW(JsonPath("/a~2"), std::runtime_error);
+    ASSERT_EQ(JsonPath("/a~1b/m~0n").to_pointer(), "/a~1b/m~0n");
+    ASSERT_EQ(JsonPath("a.b[1].c") == JsonPath("/a/b/1/c"), false);
+    ASSERT_EQ(JsonPath("a.b[1].c").to_pointer(), "/a/b/1/c");
+    ASSERT_EQ(JsonPath("a.b.1.c") == JsonPath("/a/b/1/c"), true);
+
+    // 通过路径修改，只复制被共享的路径
+    WeJson copy(js);
+    JsonValue *value = JsonPath("/a/b/1/c").find(static_cast<JsonValue&>(copy));
+    ASSERT_NE(value, nullptr);
+    *value = JsonValue("y");
+    ASSERT_EQ(JsonPath("/a/b/1/c").find(root)->to_string(), "x");
+    ASSERT_EQ(JsonPath("/a/b/1/c").find(static_cast<const JsonValue&>(copy))->to_string(), "y");
+}
+
+TEST_F(JsonPath_Test, DottedTest)
+{
+    WeJson js("{\"user\": {\"name\": \"n\", \"tags\": [\"t0\", [1, 2]]}, \"a.b\": true, \"list\": [{\"0\": \"key\"}]}");
+    const JsonValue &root = js;
+
+    ASSERT_EQ(JsonPath("user.name").find(root)->to_string(), "n");
+    ASSERT_EQ(JsonPath("user.tags[0]").find(root)->to_string(), "t0");
+    ASSERT_EQ(JsonPath("user.tags[1][1]").find(root)->to_string(), "2");
+    ASSERT_EQ(JsonPath("user.tags.1.0").find(root)->to_string(), "1");
+    ASSERT_EQ(JsonPath("[\"a.b\"]").find(root)->to_string(), "true");
+    ASSERT_EQ(JsonPath("['a.b']").find(root)->to_string(), "true");
+    ASSERT_EQ(JsonPath("list[0].0").find(root)->to_string(), "key");
+    ASSERT_EQ(JsonPath("list.0[\"0\"]").find(root)->to_string(), "key");
+    // [n] 只匹配数组，["n"] 只匹配对象
+    ASSERT_EQ(JsonPath("list[0][0]").find(root), nullptr);
+    ASSERT_EQ(JsonPath("user[\"tags\"][\"0\"]").find(root), nullptr);
+    ASSERT_EQ(JsonPath("user.missing").find(root), nullptr);
+
+    ASSERT_THROW(JsonPath("a..b"), std::runtime_error);
+    ASSERT_THROW(JsonPath("a."), std::runtime_error);
+    ASSERT_THROW(JsonPath("a[x]"), std::runtime_error);
+    ASSERT_THROW(JsonPath("a[0"), std::runtime_error);
+    ASSERT_THROW(JsonPath("a[0]b"), std::runtime_error);
+    ASSERT_THROW(JsonPath("a[\"b]"), std::runtime_error);
+
+    // 在按需解析的文本中查找
+    std::string text = js.to_string();
+    LazyJson lazy(text.data(), text.size());
+    ASSERT_EQ(JsonPath("user.tags[1][1]").find(lazy.root()).to_int(), 2);
+    ASSERT_EQ(JsonPath("/user/name").find(lazy.root()).to_string(), "n");
+    ASSERT_EQ(JsonPath("user.missing").find(lazy.root()).valid(), false);
+    ASSERT_EQ(JsonPath("user.tags[5]").find(lazy.root()).valid(), false);
+}
+
+TEST_F(JsonPath_Test, ExtractTest)
+{
+    JsonPathExtractor extractor;
+    ASSERT_EQ(extractor.add("/header/id"), 0);
+    ASSERT_EQ(extractor.add("header.type"), 1);
+    ASSERT_EQ(extractor.add("body.items[1].price"), 2);
+    ASSERT_EQ(extractor.add("/body/items/0"), 3);
+    ASSERT_EQ(extractor.add("body.missing"), 4);
+    ASSERT_EQ(extractor.add("header"), 5);
+    ASSERT_EQ(extractor.add("/header/id"), 6);
+    ASSERT_EQ(extractor.size(), 7);
+
+    std::string text = "{\"header\": {\"type\": \"order\", \"skip\": [1, {\"x\": \"]}\"}], \"id\": 12345678901234},"
+                       " \"body\": {\"items\": [{\"price\": 1.5}, {\"name\": \"b\", \"price\": 2.5}, {\"price\": 3}]}}";
+    std::vector<LazyJsonValue> results;
+    ASSERT_EQ(extractor.extract(text, results), 6);
+    ASSERT_EQ(results.size(), 7);
+    ASSERT_EQ(results[0].to_int(), 12345678901234);
+    ASSERT_EQ(results[1].to_string(), "order");
+    ASSERT_EQ(results[2].to_double(), 2.5);
+    ASSERT_EQ(results[3].raw(), "{\"price\": 1.5}");
+    ASSERT_EQ(results[4].valid(), false);
+    ASSERT_EQ(results[5].type(), JSON_OBJECT_TYPE);
+    ASSERT_EQ(results[6].to_int(), 12345678901234);
+
+    // 所有路径都找到之后不再扫描剩余的文本
+    JsonPathExtractor router;
+    router.add("id");
+    router.add("type");
+    std::string truncated = "{\"type\": \"t\", \"id\": 7, \"payload\": [1, 2, ";
+    ASSERT_EQ(router.extract(truncated, results), 2);
+    ASSERT_EQ(results[0].to_int(), 7);
+    ASSERT_EQ(results[1].to_string(), "t");
+    ASSERT_THROW(router.extract(std::string("{\"payload\": [1, 2, "), results), std::runtime_error);
+
+    // 和逐个路径在 DOM 中查找的结果一致
+    WeJson js(text);
+    const char *paths[] = {"/header/id", "header.type", "body.items[1].price", "/body/items/0"};
+    extractor.extract(text, results);
+    for (std::size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); ++i) {
+        ASSERT_EQ(results[i].to_value() == *JsonPath(paths[i]).find(static_cast<const JsonValue&>(js)), true);
+    }
+
+    // 多个线程共用一个 extractor
+    std::vector<std::thread> threads;
+    std::vector<int64_t> ids(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&extractor, &ids, t]() {
+            std::string message = "{\"header\": {\"id\": " + std::to_string(t) + ", \"type\": \"x\"}, \"body\": {\"items\": []}}";
+            std::vector<LazyJsonValue> values;
+            for (int i = 0; i < 100; ++i) {
+                extractor.extract(message, values);
+                ids[t] += values[0].to_int();
+            }
+        });
+    }
+    for (std::size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    for (int t = 0; t < 4; ++t) {
+        ASSERT_EQ(ids[t], t * 100);
+    }
+}
+
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
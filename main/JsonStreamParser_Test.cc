@@ -0,0 +1,143 @@
+#include "json_stream_parser.h"
+#include "gtest/gtest.h"
+
+using namespace basic;
+
+namespace my {
+namespace project {
+namespace {
+
+class JsonStreamParser_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Code here will be called immediately after the constructor (right
+        // before each test).
+    }
+
+    void TearDown() override {
+        // Code here will be called immediately after each test (right
+        // before the destructor).
+    }
+};
+
+const char *g_json_text =
+    "HTTP body: {\n"
+    "    // 注释\n"
+    "    \"name\": \"Hello, \\\"World\\\" \\\\\",\n"
+    "    \"num\": -12.5e1, \"int\": 42,\n"
+    "    \"flags\": [true, false, null, [], {}],\n"
+    "    \"obj\": {\"url\": \"http://example.com\", \"list\": [1, 2, 3]}\n"
+    "}";
+
+// 文本被切成任意大小的片段时结果和一次解析相同
+TEST_F(JsonStreamParser_Test, ChunkTest)
+{
+    std::string text = g_json_text;
+    WeJson expect(text);
+
+    for (std::size_t chunk = 1; chunk <= text.size(); ++chunk) {
+        WeJson value;
+        JsonDomBuilder builder(value);
+        JsonStreamParser parser(builder);
+
+        for (std::size_t pos = 0; pos < text.size(); pos += chunk) {
+            ASSERT_EQ(parser.is_complete(), false);
+            ASSERT_EQ(parser.need_more(), true);
+            std::size_t size = std::min(chunk, text.size() - pos);
+            // 每一段数据都拷贝到单独的内存中，上一段数据在之后不可用
+            std::string piece = text.substr(pos, size);
+            ASSERT_EQ(parser.feed(piece.c_str(), piece.size()), static_cast<ssize_t>(piece.size()));
+        }
+        ASSERT_EQ(parser.is_complete(), true) << chunk;
+        ASSERT_EQ(parser.consumed(), static_cast<ssize_t>(text.size()));
+        ASSERT_EQ(value.to_string(), expect.to_string()) << chunk;
+    }
+}
+
+TEST_F(JsonStreamParser_Test, ConsumeTest)
+{
+    // 文档结束之后的数据不会被消耗
+    std::string text = "[1, {\"a\": \"b\"}] {\"next\": 1}";
+    WeJson value;
+    JsonDomBuilder builder(value);
+    JsonStreamParser parser(builder);
+    ASSERT_EQ(parser.feed(text.c_str(), 5), 5);
+    ASSERT_EQ(parser.feed(text.c_str() + 5, text.size() - 5), 10);
+    ASSERT_EQ(parser.is_complete(), true);
+    ASSERT_EQ(parser.consumed(), 15);
+    ASSERT_EQ(parser.feed(text.c_str() + 15, text.size() - 15), 0);
+
+    // reset 之后解析下一个文档
+    WeJson next;
+    JsonDomBuilder next_builder(next);
+    JsonStreamParser next_parser(next_builder);
+    ASSERT_EQ(next_parser.feed(text.c_str() + 15, text.size() - 15), static_cast<ssize_t>(text.size() - 15));
+    ASSERT_EQ(next_parser.is_complete(), true);
+    ASSERT_EQ(next.get_object()["next"], 1);
+
+    // 从 ByteBuffer 中消耗数据，数据折返时也能处理
+    ByteBuffer buff(32);
+    std::string read_str;
+    buff.write_string(std::string(40, ' '));
+    buff.read_string(read_str);
+    buff.write_string("{\"key\": [1, {\"value\": \"ok\"}]} tail");
+
+    WeJson from_buffer;
+    JsonDomBuilder buffer_builder(from_buffer);
+    JsonStreamParser buffer_parser(buffer_builder);
+    ASSERT_EQ(buffer_parser.feed(buff), 29);
+    ASSERT_EQ(buffer_parser.is_complete(), true);
+    ASSERT_EQ(buff.str(), " tail");
+    ASSERT_EQ(from_buffer.get_object()["key"][1]["value"], "ok");
+}
+
+TEST_F(JsonStreamParser_Test, ErrorTest)
+{
+    const char *error_texts[] = {"{\"a\":1 \"b\":2}", "{\"a\":\"abc\"]", "[01]", "{\"a\":1,\"a\":2}", "[tru]", "{1:2}", "[1 / 2]", "[1,]x"};
+    for (std::size_t i = 0; i < sizeof(error_texts) / sizeof(error_texts[0]); ++i) {
+        bool has_error = false;
+        WeJson value;
+        JsonDomBuilder builder(value);
+        JsonStreamParser parser(builder);
+        try {
+            // 逐个字节传入
+            for (const char *pos = error_texts[i]; *pos != '\0'; ++pos) {
+                parser.feed(pos, 1);
+            }
+        } catch (std::exception &e) {
+            has_error = true;
+        }
+        ASSERT_EQ(has_error, true) << error_texts[i];
+        ASSERT_EQ(parser.need_more(), false);
+    }
+
+    // 数据不完整时只是等待更多数据
+    WeJson value;
+    JsonDomBuilder builder(value);
+    JsonStreamParser parser(builder);
+    ASSERT_EQ(parser.feed("{\"a\": \"abc", 10), 10);
+    ASSERT_EQ(parser.need_more(), true);
+    ASSERT_EQ(parser.feed("\"}", 2), 2);
+    ASSERT_EQ(parser.is_complete(), true);
+
+    // handler 中止解析
+    class StopHandler : public JsonHandler {
+    public:
+        virtual bool number(double value) override {return value < 2;}
+    };
+    StopHandler stop;
+    JsonStreamParser stop_parser(stop);
+    ASSERT_EQ(stop_parser.feed("[1, 2, 3]", 9), -1);
+    ASSERT_EQ(stop_parser.consumed(), 5);
+    ASSERT_EQ(stop_parser.need_more(), false);
+}
+
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,179 @@
+#include "json_structural.h"
+#include "json_parser.h"
+#include "gtest/gtest.h"
+
+using namespace basic;
+
+namespace my {
+namespace project {
+namespace {
+
+class JsonStructural_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Code here will be called immediately after the constructor (right
+        // before each test).
+    }
+
+    void TearDown() override {
+        // Code here will be called immediately after each test (right
+        // before the destructor).
+    }
+};
+
+// 逐字符构建结构索引，用来检查 build_structural_index 的结果
+std::vector<uint32_t> reference_index(const std::string &text)
+{
+    std::vector<uint32_t> index;
+    bool in_scalar = false;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        char ch = text[i];
+        if (ch == '"') {
+            index.push_back(static_cast<uint32_t>(i));
+            for (++i; i < text.size() && text[i] != '"'; ++i) {
+                if (text[i] == '\\') {
+                    ++i;
+                }
+            }
+            if (i < text.size()) {
+                index.push_back(static_cast<uint32_t>(i));
+            }
+            in_scalar = false;
+        } else if (strchr("{}[]:,", ch) != nullptr) {
+            index.push_back(static_cast<uint32_t>(i));
+            in_scalar = false;
+        } else if (strchr(" \t\r\n", ch) != nullptr) {
+            in_scalar = false;
+        } else {
+            if (!in_scalar) {
+                index.push_back(static_cast<uint32_t>(i));
+            }
+            in_scalar = true;
+        }
+    }
+
+    return index;
+}
+
+std::string random_space(void)
+{
+    const char spaces[] = " \t\r\n";
+    std::string str;
+    for (int i = rand() % 3; i > 0; --i) {
+        str += spaces[rand() % 4];
+    }
+    return str;
+}
+
+std::string random_string(void)
+{
+    const char chars[] = "ab{}[]:,\" \\/";
+    std::string str = "\"";
+    for (int i = rand() % 20; i > 0; --i) {
+        char ch = chars[rand() % (sizeof(chars) - 1)];
+        if (ch == '"' || ch == '\\') {
+            str += '\\';
+        }
+        str += ch;
+    }
+    return str + "\"";
+}
+
+std::string random_json(int depth)
+{
+    int type = rand() % (depth > 0 ? 7 : 5);
+    switch (type)
+    {
+        case 0: return std::to_string(rand() % 100000 - 50000);
+        case 1: return "-12.5e3";
+        case 2: return random_string();
+        case 3: return (rand() % 2 == 0 ? "true" : "false");
+        case 4: return "null";
+        case 5:
+        {
+            std::string str = "[" + random_space();
+            for (int i = rand() % 6; i > 0; --i) {
+                str += random_json(depth - 1) + random_space() + (i > 1 ? "," : "") + random_space();
+            }
+            return str + "]";
+        }
+        default:
+        {
+            std::string str = "{" + random_space();
+            for (int i = rand() % 6; i > 0; --i) {
+                str += "\"key" + std::to_string(i) + "\"" + random_space() + ":" + random_space()
+                        + random_json(depth - 1) + random_space() + (i > 1 ? "," : "") + random_space();
+            }
+            return str + "}";
+        }
+    }
+}
+
+TEST_F(JsonStructural_Test, IndexTest)
+{
+    std::vector<uint32_t> index;
+    ASSERT_EQ(build_structural_index("", 0, index), true);
+    ASSERT_EQ(index.size(), 0);
+
+    // 跨越 64 字节边界的字符串和转义
+    std::string text = "{\"" + std::string(61, 'a') + "\\\\\\\"" + std::string(70, '\\') + "\":[true,1]}";
+    ASSERT_EQ(build_structural_index(text.c_str(), text.size(), index), true);
+    ASSERT_EQ(index, reference_index(text));
+
+    for (int i = 0; i < 500; ++i) {
+        text = "[" + random_json(4) + "," + random_json(5) + "]";
+        ASSERT_EQ(build_structural_index(text.c_str(), text.size(), index), true);
+        ASSERT_EQ(index, reference_index(text)) << text;
+    }
+
+    // 字符串外出现注释时需要逐字符解析
+    text = "{\"url\": \"http://a/b\"}";
+    ASSERT_EQ(build_structural_index(text.c_str(), text.size(), index), true);
+    text = "{\"url\": 1 // comment\n}";
+    ASSERT_EQ(build_structural_index(text.c_str(), text.size(), index), false);
+}
+
+TEST_F(JsonStructural_Test, ParseTest)
+{
+    for (int i = 0; i < 200; ++i) {
+        std::string text = "{\"a\":" + random_json(6) + ",\"b\":" + random_json(6) + "}";
+
+        WeJson with_index, without_index;
+        JsonParser index_parser(text.c_str(), text.size());
+        index_parser.set_use_index(true);
+        index_parser.parse_document(with_index);
+
+        JsonParser char_parser(text.c_str(), text.size());
+        char_parser.set_use_index(false);
+        char_parser.parse_document(without_index);
+
+        ASSERT_EQ(with_index.to_string(), without_index.to_string()) << text;
+    }
+
+    // 两种方式都能发现格式错误
+    const char *error_texts[] = {"{\"a\":1 \"b\":2}", "[1,2", "{\"a\":\"abc}", "[1x]", "[true false]", "{\"a\" 1}"};
+    for (std::size_t i = 0; i < sizeof(error_texts) / sizeof(error_texts[0]); ++i) {
+        for (int use_index = 0; use_index < 2; ++use_index) {
+            bool has_error = false;
+            try {
+                WeJson value;
+                JsonParser parser(error_texts[i], strlen(error_texts[i]));
+                parser.set_use_index(use_index == 1);
+                parser.parse_document(value);
+            } catch (std::exception &e) {
+                has_error = true;
+            }
+            ASSERT_EQ(has_error, true) << error_texts[i];
+        }
+    }
+}
+
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,229 @@
+#include "json_tape.h"
+#include "gtest/gtest.h"
+
+#include <fstream>
+
+using namespace basic;
+
+namespace my {
+namespace project {
+namespace {
+
+const std::string TAPE_JSON = "{\"name\":\"tape\",\"id\":-42,\"big\":18446744073709551615,\"ratio\":0.25,"
+                              "\"ok\":true,\"off\":false,\"none\":null,\"text\":\"a\\\"b\\n\","
+                              "\"list\":[1,[2,3],{\"x\":\"y\"},[],{}],\"empty\":\"\"}";
+
+void
+write_file(const std::string &path, const std::string &content)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+}
+
+class JsonTape_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Code here will be called immediately after the constructor (right
+        // before each test).
+    }
+
+    void TearDown() override {
+        // Code here will be called immediately after each test (right
+        // before the destructor).
+    }
+};
+
+TEST_F(JsonTape_Test, HashTest)
+{
+    // XXH64 的参考值
+    ASSERT_EQ(json_tape_hash("", 0), 0xef46db3751d8e999ULL);
+    ASSERT_EQ(json_tape_hash("abc", 3), 0x44bc2cf5ad770999ULL);
+
+    std::string data(100, 'x');
+    uint64_t hash = json_tape_hash(data.data(), data.size());
+    ASSERT_EQ(hash, json_tape_hash(data.data(), data.size()));
+    data[99] = 'y';
+    ASSERT_NE(hash, json_tape_hash(data.data(), data.size()));
+}
+
+TEST_F(JsonTape_Test, QueryTest)
+{
+    JsonTape tape;
+    ASSERT_EQ(tape.empty(), true);
+    ASSERT_EQ(tape.root().valid(), false);
+
+    tape.build(TAPE_JSON.data(), TAPE_JSON.size());
+    ASSERT_EQ(tape.empty(), false);
+    ASSERT_EQ(tape.is_mapped(), false);
+
+    JsonTapeValue root = tape.root();
+    ASSERT_EQ(root.type(), JSON_OBJECT_TYPE);
+    ASSERT_EQ(root.size(), 10);
+    ASSERT_EQ(tape["name"].to_string(), "tape");
+    ASSERT_EQ(tape["id"].to_int(), -42);
+    ASSERT_EQ(tape["big"].to_double(), 18446744073709551615.0);
+    ASSERT_EQ(tape["ratio"].to_double(), 0.25);
+    ASSERT_EQ(tape["ok"].to_bool(), true);
+    ASSERT_EQ(tape["off"].to_bool(), false);
+    ASSERT_EQ(tape["none"].is_null(), true);
+    ASSERT_EQ(tape["text"].to_string(), "a\\\"b\\n");
+    ASSERT_EQ(tape["empty"].string_size(), 0);
+    ASSERT_EQ(tape["empty"].string_data()[0], '\0');
+
+    JsonTapeValue list = tape["list"];
+    ASSERT_EQ(list.type(), JSON_ARRAY_TYPE);
+    ASSERT_EQ(list.size(), 5);
+    ASSERT_EQ(list[0].to_int(), 1);
+    ASSERT_EQ(list[1][1].to_int(), 3);
+    ASSERT_EQ(list[2]["x"].to_string(), "y");
+    ASSERT_EQ(list[3].size(), 0);
+    ASSERT_EQ(list[3].begin() == list[3].end(), true);
+    ASSERT_EQ(list[4].size(), 0);
+
+    std::string keys;
+    for (JsonTapeValue::iterator iter = root.begin(); iter != root.end(); ++iter) {
+        keys += iter.key() + ",";
+    }
+    ASSERT_EQ(keys, "name,id,big,ratio,ok,off,none,text,list,empty,");
+
+    JsonTapeValue value;
+    ASSERT_EQ(root.find("missing", value), false);
+    ASSERT_EQ(root.find("ok", value), true);
+    ASSERT_EQ(value.to_bool(), true);
+
+    ASSERT_THROW(tape["missing"], std::runtime_error);
+    ASSERT_THROW(list[5], std::runtime_error);
+    ASSERT_THROW(list[-1], std::runtime_error);
+    ASSERT_THROW(tape["name"].to_int(), std::runtime_error);
+    ASSERT_THROW(tape["id"].to_string(), std::runtime_error);
+    ASSERT_THROW(list["x"], std::runtime_error);
+}
+
+TEST_F(JsonTape_Test, BuildTest)
+{
+    // 从文本和从 json 树构建的 tape 相同，还原的 json 树和直接解析的一致
+    WeJson js(TAPE_JSON);
+    JsonTape from_text;
+    JsonTape from_tree;
+    from_text.build(TAPE_JSON.data(), TAPE_JSON.size());
+    from_tree.build(js.get_object());
+
+    std::string text_data;
+    std::string tree_data;
+    ssize_t written = from_text.serialize(text_data, 1, 2);
+    ASSERT_EQ(written, static_cast<ssize_t>(text_data.size()));
+    from_tree.serialize(tree_data, 1, 2);
+    ASSERT_EQ(text_data, tree_data);
+    ASSERT_EQ(text_data.size(), sizeof(JsonTapeHeader) + from_text.tape_size() * 8 + from_text.string_size());
+
+    ASSERT_EQ(from_text.root().to_value().to_string(), js.to_string());
+    ASSERT_EQ(from_text["list"].to_value().to_string(), js["list"].to_string());
+
+    // 顶层是标量和数组
+    JsonTape scalar;
+    scalar.build(js["id"]);
+    ASSERT_EQ(scalar.root().to_int(), -42);
+    scalar.build("xx [\"a\",null]", 13);
+    ASSERT_EQ(scalar.root().size(), 2);
+    ASSERT_EQ(scalar[1].is_null(), true);
+
+    ASSERT_THROW(scalar.build("{\"a\":", 5), std::runtime_error);
+    ASSERT_EQ(scalar.empty(), true);
+}
+
+TEST_F(JsonTape_Test, LoadTest)
+{
+    JsonTape tape;
+    tape.build(TAPE_JSON.data(), TAPE_JSON.size());
+    uint64_t hash = json_tape_hash(TAPE_JSON.data(), TAPE_JSON.size());
+
+    std::string data;
+    tape.serialize(data, hash, TAPE_JSON.size());
+    // std::string 的内容是按 8 字节对齐分配的
+    std::vector<uint64_t> aligned((data.size() + 7) / 8);
+    memcpy(aligned.data(), data.data(), data.size());
+    const char *buffer = reinterpret_cast<const char*>(aligned.data());
+
+    JsonTape loaded;
+    ASSERT_EQ(loaded.load(buffer, data.size(), hash, TAPE_JSON.size()), true);
+    ASSERT_EQ(loaded["list"][2]["x"].to_string(), "y");
+    ASSERT_EQ(loaded.root().to_value().to_string(), tape.root().to_value().to_string());
+
+    // 源文件不匹配、长度不一致、头部被破坏或是没有对齐
+    ASSERT_EQ(loaded.load(buffer, data.size(), hash + 1, TAPE_JSON.size()), false);
+    ASSERT_EQ(loaded.empty(), true);
+    ASSERT_EQ(loaded.load(buffer, data.size(), hash, TAPE_JSON.size() + 1), false);
+    ASSERT_EQ(loaded.load(buffer, data.size() - 1, hash, TAPE_JSON.size()), false);
+    ASSERT_EQ(loaded.load(buffer, 10, hash, TAPE_JSON.size()), false);
+    ASSERT_EQ(loaded.load(buffer + 8, data.size() - 8, hash, TAPE_JSON.size()), false);
+
+    char *bytes = reinterpret_cast<char*>(aligned.data());
+    bytes[offsetof(JsonTapeHeader, tape_size)] ^= 1;
+    ASSERT_EQ(loaded.load(buffer, data.size(), hash, TAPE_JSON.size()), false);
+    bytes[offsetof(JsonTapeHeader, tape_size)] ^= 1;
+    bytes[offsetof(JsonTapeHeader, version)] = JSON_TAPE_VERSION + 1;
+    ASSERT_EQ(loaded.load(buffer, data.size(), hash, TAPE_JSON.size()), false);
+}
+
+TEST_F(JsonTape_Test, FileTest)
+{
+    char dir_template[] = "/tmp/json_tape_XXXXXX";
+    ASSERT_NE(mkdtemp(dir_template), nullptr);
+    std::string dir = dir_template;
+    std::string source_path = dir + "/config.json";
+    std::string tape_path = dir + "/config.tape";
+
+    write_file(source_path, TAPE_JSON);
+    {
+        JsonTape tape;
+        ASSERT_EQ(tape.load_file(tape_path, 0, 0), false);
+        // 第一次打开时解析源文件并生成 tape 文件
+        ASSERT_EQ(tape.open(source_path, tape_path), false);
+        ASSERT_EQ(tape.is_mapped(), false);
+        ASSERT_EQ(tape["id"].to_int(), -42);
+        ASSERT_EQ(access(tape_path.c_str(), F_OK), 0);
+    }
+    {
+        // 源文件没有变化，直接映射
+        JsonTape tape;
+        ASSERT_EQ(tape.open(source_path, tape_path), true);
+        ASSERT_EQ(tape.is_mapped(), true);
+        ASSERT_EQ(tape["list"][1][0].to_int(), 2);
+        ASSERT_EQ(tape.root().to_value().to_string(), WeJson(TAPE_JSON).to_string());
+    }
+
+    // 源文件变化之后重新生成
+    write_file(source_path, "{\"id\":7}");
+    {
+        JsonTape tape;
+        ASSERT_EQ(tape.open(source_path, tape_path), false);
+        ASSERT_EQ(tape["id"].to_int(), 7);
+        ASSERT_EQ(tape.open(source_path, tape_path), true);
+        ASSERT_EQ(tape["id"].to_int(), 7);
+    }
+
+    // 损坏的 tape 文件被当作无效
+    write_file(tape_path, "not a tape");
+    {
+        JsonTape tape;
+        ASSERT_EQ(tape.open(source_path, tape_path), false);
+        ASSERT_EQ(tape.open(source_path, tape_path), true);
+    }
+
+    JsonTape tape;
+    ASSERT_THROW(tape.open(dir + "/missing.json", tape_path), std::runtime_error);
+
+    unlink(source_path.c_str());
+    unlink(tape_path.c_str());
+    rmdir(dir.c_str());
+}
+
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
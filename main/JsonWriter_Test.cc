@@ -0,0 +1,179 @@
+#include "json_writer.h"
+#include "gtest/gtest.h"
+
+using namespace basic;
+
+namespace my {
+namespace project {
+namespace {
+
+class JsonWriter_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Code here will be called immediately after the constructor (right
+        // before each test).
+    }
+
+    void TearDown() override {
+        // Code here will be called immediately after each test (right
+        // before the destructor).
+    }
+};
+
+const char *test_json = "{\"arr\":[1,-2.5,\"x\",[true,false,null],{}],\"big\":18446744073709551615,\"name\":\"a \\\"quoted\\\" value\",\"obj\":{\"a\":{\"b\":[]}}}";
+
+TEST_F(JsonWriter_Test, StringTest)
+{
+    WeJson js(test_json);
+    ASSERT_EQ(js.to_string(), test_json);
+
+    // 追加到已有的内容之后
+    for (int estimate = 0; estimate < 2; ++estimate) {
+        std::string out = "prefix:";
+        JsonWriter writer(out);
+        writer.set_estimate_size(estimate == 1);
+        ssize_t size = writer.write(js);
+        ASSERT_EQ(out, std::string("prefix:") + test_json);
+        ASSERT_EQ(size, static_cast<ssize_t>(strlen(test_json)));
+    }
+    ASSERT_GE(JsonWriter::estimate_size(js), strlen(test_json));
+
+    // 单独的值和容器
+    std::string out;
+    JsonWriter writer(out);
+    writer.write(JsonValue("str"));
+    writer.write(JsonValue(42));
+    writer.write(js.get_object()["obj"]);
+    writer.write(JsonArray());
+    ASSERT_EQ(out, "\"str\"42{\"a\":{\"b\":[]}}[]");
+}
+
+TEST_F(JsonWriter_Test, ByteBufferTest)
+{
+    WeJson js(test_json);
+    for (int estimate = 0; estimate < 2; ++estimate) {
+        ByteBuffer buff;
+        JsonWriter writer(buff);
+        writer.set_estimate_size(estimate == 1);
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_EQ(writer.write(js), static_cast<ssize_t>(strlen(test_json)));
+        }
+        ASSERT_EQ(buff.data_size(), static_cast<ssize_t>(strlen(test_json) * 100));
+
+        std::string text;
+        buff.read_string(text, strlen(test_json));
+        ASSERT_EQ(text, test_json);
+    }
+
+    // 空闲空间折返时也能写入连续的一段
+    ByteBuffer buff(256);
+    std::string filler(200, 'x');
+    buff.write_string(filler);
+    std::string tmp;
+    buff.read_string(tmp, 180);
+    JsonWriter writer(buff);
+    writer.write(js);
+    std::string text;
+    buff.read_string(text, 20);
+    ASSERT_EQ(text, filler.substr(180));
+    text.clear();
+    buff.read_string(text);
+    ASSERT_EQ(text, test_json);
+}
+
+TEST_F(JsonWriter_Test, PrettyTest)
+{
+    WeJson js(test_json);
+    const char *expected =
+        "{\n"
+        "  \"arr\": [\n"
+        "    1,\n"
+        "    -2.5,\n"
+        "    \"x\",\n"
+        "    [\n"
+        "      true,\n"
+        "      false,\n"
+        "      null\n"
+        "    ],\n"
+        "    {}\n"
+        "  ],\n"
+        "  \"big\": 18446744073709551615,\n"
+        "  \"name\": \"a \\\"quoted\\\" value\",\n"
+        "  \"obj\": {\n"
+        "    \"a\": {\n"
+        "      \"b\": []\n"
+        "    }\n"
+        "  }\n"
+        "}";
+    for (int estimate = 0; estimate < 2; ++estimate) {
+        std::string out;
+        JsonWriter writer(out);
+        writer.set_estimate_size(estimate == 1);
+        writer.set_indent(2);
+        writer.write(js);
+        ASSERT_EQ(out, expected);
+
+        ByteBuffer buff;
+        JsonWriter buff_writer(buff);
+        buff_writer.set_estimate_size(estimate == 1);
+        buff_writer.set_indent(2);
+        ASSERT_EQ(buff_writer.write(js), static_cast<ssize_t>(strlen(expected)));
+        std::string text;
+        buff.read_string(text);
+        ASSERT_EQ(text, expected);
+    }
+
+    // 短的容器合并到一行
+    std::string out;
+    JsonWriter writer(out);
+    writer.set_indent(1, '\t');
+    writer.set_max_inline_width(20);
+    writer.write(js);
+    ASSERT_EQ(out,
+        "{\n"
+        "\t\"arr\": [\n\t\t1,\n\t\t-2.5,\n\t\t\"x\",\n\t\t[true,false,null],\n\t\t{}\n\t],\n"
+        "\t\"big\": 18446744073709551615,\n"
+        "\t\"name\": \"a \\\"quoted\\\" value\",\n"
+        "\t\"obj\": {\"a\":{\"b\":[]}}\n"
+        "}");
+    ASSERT_EQ(js.format_json(),
+        "{\n"
+        "\t\"arr\": [\n\t\t1,\n\t\t-2.5,\n\t\t\"x\",\n\t\t[\n\t\t\ttrue,\n\t\t\tfalse,\n\t\t\tnull\n\t\t],\n\t\t{}\n\t],\n"
+        "\t\"big\": 18446744073709551615,\n"
+        "\t\"name\": \"a \\\"quoted\\\" value\",\n"
+        "\t\"obj\": {\n\t\t\"a\": {\n\t\t\t\"b\": []\n\t\t}\n\t}\n"
+        "}");
+
+    // 格式化的结果再解析得到相同的值
+    WeJson parsed(js.format_json());
+    ASSERT_EQ(parsed.to_string(), test_json);
+}
+
+TEST_F(JsonWriter_Test, SortKeysTest)
+{
+    JsonObject obj;
+    obj.add("b", JsonValue(2));
+    obj.add("a", JsonValue(1));
+    obj.add("c", JsonValue("3"));
+
+    std::string out;
+    JsonWriter writer(out);
+    writer.set_sort_keys(true);
+    writer.write(obj);
+    ASSERT_EQ(out, "{\"a\":1,\"b\":2,\"c\":\"3\"}");
+
+    out.clear();
+    writer.set_indent(1);
+    writer.write(obj);
+    ASSERT_EQ(out, "{\n \"a\": 1,\n \"b\": 2,\n \"c\": \"3\"\n}");
+}
+
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
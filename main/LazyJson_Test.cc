@@ -0,0 +1,141 @@
+#include "lazy_json.h"
+#include "gtest/gtest.h"
+
+using namespace basic;
+
+namespace my {
+namespace project {
+namespace {
+
+class LazyJson_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Code here will be called immediately after the constructor (right
+        // before each test).
+    }
+
+    void TearDown() override {
+        // Code here will be called immediately after each test (right
+        // before the destructor).
+    }
+};
+
+const char *g_json_text =
+    "// 开头的注释\n"
+    "{\n"
+    "    \"skip\": {\"a\": [1, 2, {\"b\": \"}]\\\"{[\"}], \"c\": \"// not comment\"}, // 注释中的 ]}\n"
+    "    \"name\": \"Hello, \\\"World\\\"\",\n"
+    "    \"num\": -12.5e1,\n"
+    "    \"int\": 42,\n"
+    "    \"ok\": true,\n"
+    "    \"none\": null,\n"
+    "    \"arr\": [\"x\", [1, 2], {\"k\": false}, 7],\n"
+    "    \"empty_obj\": {},\n"
+    "    \"empty_arr\": [ ]\n"
+    "}";
+
+TEST_F(LazyJson_Test, AccessTest)
+{
+    LazyJson js(g_json_text, strlen(g_json_text));
+    ASSERT_EQ(js.root().type(), JSON_OBJECT_TYPE);
+    ASSERT_EQ(js.root().size(), 9);
+
+    ASSERT_EQ(js["name"].type(), JSON_STRING_TYPE);
+    ASSERT_EQ(js["name"].to_string(), "Hello, \\\"World\\\"");
+    ASSERT_EQ(js["num"].to_double(), -125);
+    ASSERT_EQ(js["int"].to_int(), 42);
+    ASSERT_EQ(js["ok"].to_bool(), true);
+    ASSERT_EQ(js["none"].is_null(), true);
+    ASSERT_EQ(js["skip"]["c"].to_string(), "// not comment");
+    ASSERT_EQ(js["skip"]["a"][2]["b"].to_string(), "}]\\\"{[");
+
+    LazyJsonValue arr = js["arr"];
+    ASSERT_EQ(arr.size(), 4);
+    ASSERT_EQ(arr[0].to_string(), "x");
+    ASSERT_EQ(arr[1][1].to_int(), 2);
+    ASSERT_EQ(arr[2]["k"].to_bool(), false);
+    ASSERT_EQ(arr[3].to_int(), 7);
+    ASSERT_EQ(arr[1].raw(), "[1, 2]");
+
+    ASSERT_EQ(js["empty_obj"].size(), 0);
+    ASSERT_EQ(js["empty_obj"].begin() == js["empty_obj"].end(), true);
+    ASSERT_EQ(js["empty_arr"].size(), 0);
+
+    LazyJsonValue value;
+    ASSERT_EQ(js.root().find("not_exists", value), false);
+    ASSERT_EQ(value.valid(), false);
+    ASSERT_EQ(js.root().find("int", value), true);
+    ASSERT_EQ(value.to_int(), 42);
+
+    // 遍历
+    std::vector<std::string> keys;
+    for (auto iter = js.root().begin(); iter != js.root().end(); ++iter) {
+        keys.push_back(iter.key());
+    }
+    ASSERT_EQ(keys.size(), static_cast<std::size_t>(9));
+    ASSERT_EQ(keys[0], "skip");
+    ASSERT_EQ(keys[8], "empty_arr");
+
+    // 和完整解析的结果一致
+    WeJson full(g_json_text);
+    JsonValue skip = js["skip"].to_value();
+    ASSERT_EQ(skip.to_string(), full.get_object()["skip"].to_string());
+}
+
+TEST_F(LazyJson_Test, ErrorTest)
+{
+    LazyJson js(std::string("{\"a\": 1, \"b\": [1, 2}"));
+    ASSERT_EQ(js["a"].to_int(), 1);
+
+    // 类型不一致、越界以及格式错误在访问时抛出异常
+    bool has_error = false;
+    try {
+        js["a"].to_string();
+    } catch (std::exception &e) {
+        has_error = true;
+    }
+    ASSERT_EQ(has_error, true);
+
+    has_error = false;
+    try {
+        js["b"][5];
+    } catch (std::exception &e) {
+        has_error = true;
+    }
+    ASSERT_EQ(has_error, true);
+
+    has_error = false;
+    try {
+        js["c"];
+    } catch (std::exception &e) {
+        has_error = true;
+    }
+    ASSERT_EQ(has_error, true);
+
+    has_error = false;
+    try {
+        LazyJson empty("");
+    } catch (std::exception &e) {
+        has_error = true;
+    }
+    ASSERT_EQ(has_error, true);
+
+    // ByteBuffer 中数据折返
+    ByteBuffer buff(32);
+    std::string read_str;
+    buff.write_string(std::string(40, ' '));
+    buff.read_string(read_str);
+    buff.write_string("{\"key\": [1, {\"value\": \"ok\"}]}");
+    LazyJson from_buffer(buff);
+    ASSERT_EQ(from_buffer["key"][1]["value"].to_string(), "ok");
+}
+
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,131 @@
+#include "ndjson_reader.h"
+#include "gtest/gtest.h"
+
+using namespace basic;
+
+namespace my {
+namespace project {
+namespace {
+
+class NdJsonReader_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Code here will be called immediately after the constructor (right
+        // before each test).
+    }
+
+    void TearDown() override {
+        // Code here will be called immediately after each test (right
+        // before the destructor).
+    }
+};
+
+std::string make_records(int count)
+{
+    std::string text;
+    for (int i = 0; i < count; ++i) {
+        text += "{\"id\": " + std::to_string(i) + ", \"name\": \"user" + std::to_string(i) + "\", \"tags\": [1, 2, true]}";
+        // 混入空行和 \r\n
+        text += (i % 7 == 0 ? "\r\n\n" : "\n");
+    }
+    return text;
+}
+
+TEST_F(NdJsonReader_Test, OrderTest)
+{
+    std::string text = make_records(5000);
+
+    for (int thread_num = 0; thread_num < 4; thread_num += 3) {
+        NdJsonReader reader(thread_num);
+        ASSERT_EQ(reader.thread_num(), thread_num);
+
+        std::vector<WeJson> records;
+        ASSERT_EQ(reader.parse(text.c_str(), text.size(), records), 5000);
+        ASSERT_EQ(records.size(), static_cast<std::size_t>(5000));
+        for (int i = 0; i < 5000; ++i) {
+            ASSERT_EQ(records[i].get_object()["id"], i);
+            ASSERT_EQ(records[i].get_object()["name"], "user" + std::to_string(i));
+        }
+
+        // 同一个 reader 可以多次使用
+        std::string small_text = "[1]\n  \n2\n\"s\"";
+        ASSERT_EQ(reader.parse(small_text.c_str(), small_text.size(), records), 3);
+        ASSERT_EQ(records[0].get_type(), JSON_ARRAY_TYPE);
+        ASSERT_EQ(records[1].get_type(), JSON_NUMBER_TYPE);
+        ASSERT_EQ(records[2].get_type(), JSON_STRING_TYPE);
+    }
+
+    // 回调在多个线程中调用
+    NdJsonReader reader(3);
+    std::mutex mutex;
+    std::vector<int> ids(5000, -1);
+    ASSERT_EQ(reader.parse(text.c_str(), text.size(), [&](std::size_t index, WeJson &record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        JsonNumber id = record.get_object()["id"];
+        ids[index] = static_cast<int>(id.to_int());
+    }), 5000);
+    for (int i = 0; i < 5000; ++i) {
+        ASSERT_EQ(ids[i], i);
+    }
+
+    // 文件
+    char path[] = "/tmp/ndjson_test_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_EQ(write(fd, text.c_str(), text.size()), static_cast<ssize_t>(text.size()));
+    close(fd);
+    std::vector<WeJson> records;
+    ASSERT_EQ(reader.parse_file(path, records), 5000);
+    ASSERT_EQ(records[4999].get_object()["id"], 4999);
+    unlink(path);
+
+    // ByteBuffer 中数据折返
+    ByteBuffer buff(32);
+    std::string read_str;
+    buff.write_string(std::string(40, ' '));
+    buff.read_string(read_str);
+    buff.write_string("{\"a\": 1}\n{\"a\": 2}\n");
+    ASSERT_EQ(reader.parse(buff, records), 2);
+    ASSERT_EQ(records[1].get_object()["a"], 2);
+}
+
+TEST_F(NdJsonReader_Test, ErrorTest)
+{
+    std::string text = make_records(1000);
+    const char *error_lines[] = {"{\"a\": 1", "{\"a\": 1} x", "[1, 2]]"};
+
+    NdJsonReader reader(2);
+    for (std::size_t i = 0; i < sizeof(error_lines) / sizeof(error_lines[0]); ++i) {
+        std::string error_text = text + error_lines[i] + "\n" + text;
+        bool has_error = false;
+        try {
+            std::vector<WeJson> records;
+            reader.parse(error_text.c_str(), error_text.size(), records);
+        } catch (std::exception &e) {
+            has_error = true;
+            ASSERT_NE(std::string(e.what()).find("record 1000 "), std::string::npos) << e.what();
+        }
+        ASSERT_EQ(has_error, true) << error_lines[i];
+    }
+
+    // 出错之后仍然可以继续使用
+    std::vector<WeJson> records;
+    ASSERT_EQ(reader.parse(text.c_str(), text.size(), records), 1000);
+
+    bool has_error = false;
+    try {
+        reader.parse_file("/not/exists/file", records);
+    } catch (std::exception &e) {
+        has_error = true;
+    }
+    ASSERT_EQ(has_error, true);
+}
+
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,6 +1,9 @@
 #include "wejson.h"
+#include "json_parser.h"
 #include "gtest/gtest.h"
 
+#include <thread>
+
 using namespace basic;
 //////////////////////////////////////////////////
 void random_str(int setlen, ByteBuffer &buff1, ByteBuffer &buff2)
@@ -170,12 +173,14 @@ TEST_F(WeJson_Test, NUMBER_TEST)
     ASSERT_EQ(test_number(+0000., "0"), true);
     ASSERT_EQ(test_number(+0000.00000000, "0"), true);
 
-    // double 小数点后默认保留6位，最后一位会以第七位进一
-    ASSERT_EQ(test_number(-0.123456789, "-0.123457"), true);
-    ASSERT_EQ(test_number(+000.123456778, "+0.123457"), true);
-    ASSERT_EQ(test_number(+0000.1234567890000, "+0.123457"), true);
-
-    ASSERT_EQ(test_number(-0.123456789, "-0.123457"), true);
+    // double 输出能还原出原值的最短形式，不会丢失精度
+    ASSERT_EQ(test_number(-0.123456789, "-0.123456789"), true);
+    ASSERT_EQ(test_number(+000.123456778, "+0.123456778"), true);
+    ASSERT_EQ(test_number(+0000.1234567890000, "+0.123456789"), true);
+    ASSERT_EQ(JsonNumber(0.1).to_string(), "0.1");
+    ASSERT_EQ(JsonNumber(-0.123456789).to_string(), "-0.123456789");
+    ASSERT_EQ(JsonNumber(1e21).to_string(), "1e+21");
+    ASSERT_EQ(JsonNumber(1.5e-7).to_string(), "1.5e-7");
     try {
         ASSERT_EQ(test_parse_number(0, "03"), true);
     }catch (std::exception &e) {
@@ -356,6 +361,457 @@ TEST_F(WeJson_Test, ObjectArrayTest)
     std::cout << data.format_json();
 }
 
+
+TEST_F(WeJson_Test, PointerParseTest)
+{
+    // 空白和注释在解析时直接跳过
+    std::string text = "// head comment\n"
+                       "{\r\n"
+                       "\t\"name\" : \"a \\\" b\", // tail comment\n"
+                       "\t\"arr\" : [ 1 , -2.5 , 3e2 , true , false , null , { } , [ ] ],\n"
+                       "\t\"obj\" : {\"url\": \"http://example.com\"}\n"
+                       "}";
+    WeJson js(text);
+    ASSERT_EQ(js.get_type(), JSON_OBJECT_TYPE);
+    ASSERT_EQ(js.get_object()["name"], "a \\\" b");
+    ASSERT_EQ(js.get_object()["arr"][0], 1);
+    ASSERT_EQ(js.get_object()["arr"][1], -2.5);
+    ASSERT_EQ(js.get_object()["arr"][2], 300);
+    ASSERT_EQ(js.get_object()["arr"][3], true);
+    ASSERT_EQ(js.get_object()["arr"][4], false);
+    ASSERT_EQ(js.get_object()["arr"][5], JsonNull());
+    ASSERT_EQ(js.get_object()["obj"]["url"], "http://example.com");
+
+    // 输入不需要以 '\0' 结尾
+    std::string array_text = "[1,2,3]456";
+    WeJson arr;
+    arr.parse(array_text.c_str(), 7);
+    ASSERT_EQ(arr.get_array().size(), 3);
+    ASSERT_EQ(arr.get_array()[2], 3);
+
+    // ByteBuffer 中数据折返时结果一致
+    for (int offset = 1; offset < static_cast<int>(text.size()); offset += 13) {
+        ByteBuffer buff(static_cast<ssize_t>(text.size()));
+        std::string read_str;
+        buff.write_string(std::string(offset, ' '));
+        buff.read_string(read_str);
+        buff.write_string(text);
+
+        WeJson wrapped(buff);
+        ASSERT_EQ(wrapped, js);
+        ASSERT_EQ(wrapped.to_string(), js.to_string());
+    }
+
+    const char *error_texts[] = {"", "{\"a\":1 \"b\":2}", "[1,2", "{\"a\":\"abc}", "[01]", "{\"a\":1,\"a\":2}", "[tru]", "{1:2}"};
+    for (std::size_t i = 0; i < sizeof(error_texts) / sizeof(error_texts[0]); ++i) {
+        bool has_error = false;
+        try {
+            WeJson err(error_texts[i]);
+        } catch (std::exception &e) {
+            has_error = true;
+        }
+        ASSERT_EQ(has_error, true) << error_texts[i];
+    }
+}
+
+
+// 把解析事件记录成字符串
+class RecordHandler : public JsonHandler {
+public:
+    RecordHandler(void) : stop_at_(-1), count_(0) {}
+
+    virtual bool start_object(void) override {return this->record("{");}
+    virtual bool key(const char *str, ssize_t size) override {return this->record("k:" + std::string(str, size));}
+    virtual bool end_object(void) override {return this->record("}");}
+    virtual bool start_array(void) override {return this->record("[");}
+    virtual bool end_array(void) override {return this->record("]");}
+    virtual bool string(const char *str, ssize_t size) override {return this->record("s:" + std::string(str, size));}
+    virtual bool number(double value) override {return this->record("n:" + std::to_string(static_cast<int>(value)));}
+    virtual bool boolean(bool value) override {return this->record(value ? "true" : "false");}
+    virtual bool null(void) override {return this->record("null");}
+
+    bool record(const std::string &event) {
+        events_ += event + " ";
+        return ++count_ != stop_at_;
+    }
+
+    int stop_at_;
+    int count_;
+    std::string events_;
+};
+
+TEST_F(WeJson_Test, HandlerTest)
+{
+    std::string text = "{\"a\": [1, \"x\\\"y\", true, null, {}], \"b\": {\"c\": false}, \"d\": []}";
+    const char *expect = "{ k:a [ n:1 s:x\\\"y true null { } ] k:b { k:c false } k:d [ ] } ";
+
+    // 使用索引和逐字符解析产生的事件一致
+    for (int use_index = 0; use_index < 2; ++use_index) {
+        RecordHandler handler;
+        JsonParser parser(text.c_str(), text.size());
+        parser.set_use_index(use_index == 1);
+        ASSERT_EQ(parser.parse_document(handler), static_cast<ssize_t>(text.size()));
+        ASSERT_EQ(handler.events_, expect);
+    }
+
+    // 回调返回 false 时停止解析
+    RecordHandler stop_handler;
+    stop_handler.stop_at_ = 4;
+    JsonParser stop_parser(text.c_str(), text.size());
+    ASSERT_EQ(stop_parser.parse_document(stop_handler), -1);
+    ASSERT_EQ(stop_handler.events_, "{ k:a [ n:1 ");
+
+    // 默认实现忽略所有事件，只检查格式
+    JsonHandler ignore;
+    JsonParser check_parser(text.c_str(), text.size());
+    ASSERT_EQ(check_parser.parse_document(ignore), static_cast<ssize_t>(text.size()));
+
+    // JsonDomBuilder 和 WeJson 的解析结果一致
+    JsonValue value;
+    JsonDomBuilder builder(value);
+    JsonParser dom_parser(text.c_str(), text.size());
+    dom_parser.parse_document(builder);
+    ASSERT_EQ(value.to_string(), WeJson(text).to_string());
+}
+
+
+TEST_F(WeJson_Test, ArenaTest)
+{
+    ASSERT_EQ(sizeof(JsonValue), 16);
+
+    JsonArena arena(64);
+    void *small = arena.allocate(10, 1);
+    void *aligned = arena.allocate(8, 8);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(aligned) % 8, 0);
+    ASSERT_NE(small, aligned);
+    // 较大的分配使用单独的内存块
+    void *large = arena.allocate(1000, 16);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(large) % 16, 0);
+    ASSERT_GE(arena.capacity(), static_cast<std::size_t>(1000 + 64));
+    arena.reset();
+    ASSERT_EQ(arena.used(), 0);
+
+    std::string text = "{\"name\": \"a long string value that does not fit in sso\", \"arr\": [1, \"x\", [true, null], {\"k\": 2}], \"obj\": {\"a\": {}}}";
+    JsonValue copy;
+    JsonObject object_copy;
+    {
+        WeJson js(text);
+        ASSERT_NE(js.arena(), nullptr);
+        ASSERT_GT(js.arena()->used(), 0);
+
+        // 拷贝出来的值不在 arena 中，文档销毁之后仍然可以使用
+        copy = js.get_object()["arr"];
+        object_copy = js.get_object();
+        JsonValue value_copy(js.get_object()["obj"]);
+        ASSERT_EQ(value_copy.to_string(), "{\"a\":{}}");
+
+        // 修改文档中的值
+        js.get_object()["name"] = JsonString("changed");
+        js.get_object()["obj"] = js.get_object()["obj"]["a"];
+        js.get_object().add("new", JsonArray());
+        js.get_object().erase("arr");
+        ASSERT_EQ(js.to_string(), "{\"name\":\"changed\",\"obj\":{},\"new\":[]}");
+
+        // 重新解析时内存块合并成一个，之后重用这个内存块
+        js.parse(text);
+        std::size_t capacity = js.arena()->capacity();
+        js.parse(text);
+        ASSERT_EQ(js.arena()->capacity(), capacity);
+        ASSERT_EQ(js.to_string(), WeJson(text).to_string());
+
+        // 拷贝文档时共享 arena
+        WeJson js_copy(js);
+        ASSERT_EQ(js_copy.arena(), js.arena());
+        ASSERT_EQ(js_copy.to_string(), js.to_string());
+    }
+    ASSERT_EQ(copy.to_string(), "[1,\"x\",[true,null],{\"k\":2}]");
+    ASSERT_EQ(object_copy["name"], "a long string value that does not fit in sso");
+}
+
+TEST_F(WeJson_Test, ObjectOrderTest)
+{
+    // 成员按照插入的顺序保存和输出
+    WeJson js("{\"z\": 1, \"a\": 2, \"m\": {\"y\": true, \"b\": null}}");
+    ASSERT_EQ(js.to_string(), "{\"z\":1,\"a\":2,\"m\":{\"y\":true,\"b\":null}}");
+    ASSERT_EQ(js == WeJson("{\"a\": 2, \"m\": {\"b\": null, \"y\": true}, \"z\": 1}"), true);
+    // 数组逐个比较元素
+    ASSERT_EQ(WeJson("[1]") == WeJson("[2]"), false);
+    ASSERT_EQ(WeJson("{\"a\": [1, [true]]}") == WeJson("{\"a\": [1, [false]]}"), false);
+    ASSERT_EQ(WeJson("[1, [true]]") == WeJson("[1, [true]]"), true);
+    ASSERT_THROW(WeJson("{\"a\": 1, \"b\": 2, \"a\": 3}"), std::runtime_error);
+
+    // 成员超过 JSON_OBJECT_INDEX_THRESHOLD 时通过哈希索引查找
+    for (int count = JSON_OBJECT_INDEX_THRESHOLD - 1; count <= JSON_OBJECT_INDEX_THRESHOLD * 10; count += JSON_OBJECT_INDEX_THRESHOLD + 1) {
+        std::string text = "{";
+        for (int i = count - 1; i >= 0; --i) {
+            text += "\"key" + std::to_string(i) + "\":" + std::to_string(i) + (i == 0 ? "}" : ",");
+        }
+        WeJson big(text);
+        JsonObject &object = big.get_object();
+        ASSERT_EQ(object.size(), count);
+        ASSERT_EQ(object.begin()->first, "key" + std::to_string(count - 1));
+        for (int i = 0; i < count; ++i) {
+            ASSERT_EQ(static_cast<JsonNumber>(object["key" + std::to_string(i)]).to_int(), i);
+        }
+        ASSERT_EQ(object.find("missing") == object.end(), true);
+        ASSERT_THROW(WeJson(text.substr(0, text.size() - 1) + ",\"key3\":0}"), std::runtime_error);
+
+        // 删除和添加之后索引保持正确
+        for (int i = 0; i < count; i += 2) {
+            ASSERT_EQ(object.erase("key" + std::to_string(i)), 1);
+        }
+        object.add("added", JsonValue(-1));
+        object.add("key1", JsonValue(100));
+        ASSERT_EQ(object.size(), count / 2 + 1);
+        ASSERT_EQ(static_cast<JsonNumber>(object["added"]).to_int(), -1);
+        ASSERT_EQ(static_cast<JsonNumber>(object["key1"]).to_int(), 100);
+        ASSERT_EQ(object.find("key0") == object.end(), true);
+
+        JsonObject copy = object;
+        ASSERT_EQ(copy == object, true);
+        ASSERT_EQ(static_cast<JsonNumber>(copy["added"]).to_int(), -1);
+    }
+}
+
+TEST_F(WeJson_Test, MoveTest)
+{
+    // 堆上的值移动时直接接管，不拷贝
+    JsonValue value = WeJson("{\"a\": [1, 2, {\"b\": \"text\"}]}").get_object();
+    JsonArray *array = &value["a"].get_array();
+    JsonValue moved(std::move(value));
+    ASSERT_EQ(value.type(), JSON_NULL_TYPE);
+    ASSERT_EQ(&moved["a"].get_array(), array);
+    value = std::move(moved);
+    ASSERT_EQ(&value["a"].get_array(), array);
+    ASSERT_EQ(value.to_string(), "{\"a\":[1,2,{\"b\":\"text\"}]}");
+
+    // 移动子节点到父节点
+    value = std::move(value["a"]);
+    ASSERT_EQ(value.to_string(), "[1,2,{\"b\":\"text\"}]");
+    value = std::move(value[2]);
+    ASSERT_EQ(value.to_string(), "{\"b\":\"text\"}");
+
+    // 对象和数组移动到 JsonValue 中
+    JsonObject object;
+    object.add("k", JsonValue("v"));
+    JsonValue object_value(std::move(object));
+    ASSERT_EQ(object.size(), 0);
+    ASSERT_EQ(object_value.to_string(), "{\"k\":\"v\"}");
+    JsonObject taken = std::move(object_value);
+    ASSERT_EQ(taken.to_string(), "{\"k\":\"v\"}");
+    ASSERT_EQ(object_value.get_object().size(), 0);
+
+    // 原地构造元素
+    JsonObject root;
+    JsonValue &items = root.emplace("items", JsonArray());
+    JsonArray &list = items.get_array();
+    list.emplace_back(1);
+    list.emplace_back("two");
+    list.emplace_back(JsonObject()).get_object().emplace("three", 3.5);
+    root.emplace("items", std::move(items));
+    root.add("flag", JsonValue(true));
+    ASSERT_EQ(root.to_string(), "{\"items\":[1,\"two\",{\"three\":3.5}],\"flag\":true}");
+
+    // 文档内部移动 arena 中的值时直接接管；拷贝或是放入堆上的对象和数组时拷贝出来，文档销毁后仍然可以使用
+    JsonValue from_doc;
+    JsonArray array_from_doc;
+    JsonObject added;
+    WeJson doc_moved;
+    {
+        WeJson js("{\"name\": \"a long string value that does not fit in sso\", \"arr\": [1, [true]], \"obj\": {\"k\": \"v\"}, \"list\": [[1], {\"a\": 2}]}");
+        JsonArray &list = js.get_object()["list"].get_array();
+        const JsonArray *first = &list[0].get_array();
+        const JsonObject *second = &list[1].get_object();
+        for (int i = 0; i < 100; ++i) {
+            list.add(JsonValue(i));
+        }
+        ASSERT_EQ(&list[0].get_array(), first);
+        ASSERT_EQ(&list[1].get_object(), second);
+        // 同一个文档中的对象之间移动
+        const JsonObject *moved_object = &list[1].get_object();
+        js.get_object()["obj"].get_object().add("moved", std::move(list[1]));
+        ASSERT_EQ(&js.get_object()["obj"]["moved"].get_object(), moved_object);
+        list.erase(1);
+
+        from_doc = js.get_object()["name"];
+        added.add("inner", std::move(js.get_object()["obj"]["moved"]));
+        added.emplace("name", std::move(js.get_object()["name"]));
+        ASSERT_EQ(js.get_object()["name"].type(), JSON_NULL_TYPE);
+        js.get_object()["name"] = from_doc;
+        array_from_doc = std::move(js.get_object()["arr"].get_array());
+        js.get_object()["obj"] = std::move(js.get_object()["obj"]["k"]);
+        ASSERT_EQ(js.get_object()["list"].get_array().size(), 101);
+        js.get_object().erase("list");
+        ASSERT_EQ(js.to_string(), "{\"name\":\"a long string value that does not fit in sso\",\"arr\":[],\"obj\":\"v\"}");
+
+        // 文档连同 arena 一起移动
+        const JsonArena *arena = js.arena();
+        doc_moved = std::move(js);
+        ASSERT_EQ(doc_moved.arena(), arena);
+        ASSERT_EQ(js.arena(), nullptr);
+        WeJson doc_other(std::move(doc_moved));
+        ASSERT_EQ(doc_other.arena(), arena);
+        doc_moved = std::move(doc_other);
+    }
+    ASSERT_EQ(from_doc.to_string(), "a long string value that does not fit in sso");
+    ASSERT_EQ(array_from_doc.to_string(), "[1,[true]]");
+    ASSERT_EQ(added.to_string(), "{\"inner\":{\"a\":2},\"name\":\"a long string value that does not fit in sso\"}");
+    ASSERT_EQ(doc_moved.get_object()["obj"].to_string(), "v");
+
+    // 旧的解析接口移动解析出的子树
+    std::string nested;
+    for (int i = 0; i < 200; ++i) {
+        nested += "{\"a\":[";
+    }
+    nested += "1";
+    for (int i = 0; i < 200; ++i) {
+        nested += "]}";
+    }
+    ByteBuffer buff;
+    buff.write_string(nested);
+    ByteBuffer::iterator begin = buff.begin();
+    ByteBuffer::iterator end = buff.end();
+    JsonObject legacy;
+    legacy.parse(begin, end);
+    ASSERT_EQ(legacy.to_string(), nested);
+
+    // std::vector 扩容时移动文档
+    std::vector<WeJson> docs;
+    for (int i = 0; i < 100; ++i) {
+        docs.emplace_back("{\"i\": " + std::to_string(i) + "}");
+    }
+    ASSERT_EQ(docs[99].to_string(), "{\"i\":99}");
+    ASSERT_NE(docs[0].arena(), nullptr);
+}
+
+TEST_F(WeJson_Test, MoveOutTest)
+{
+    // 从临时文档中移动出来的值拷贝到堆上，文档销毁之后仍然可以使用
+    const std::string text = "{\"name\": \"a long string value that does not fit in sso\", \"list\": [1, {\"k\": [true]}]}";
+    JsonValue value = WeJson(text);
+    ASSERT_EQ(value["list"][1]["k"].to_string(), "[true]");
+    JsonObject object = WeJson(text);
+    ASSERT_EQ(object["name"].to_string(), "a long string value that does not fit in sso");
+    JsonArray array = WeJson("[[1], \"a long string value that does not fit in sso\"]");
+    ASSERT_EQ(array.to_string(), "[[1],\"a long string value that does not fit in sso\"]");
+
+    std::vector<JsonValue> values;
+    {
+        WeJson doc(text);
+        value = std::move(doc);
+        ASSERT_EQ(doc.type(), JSON_NULL_TYPE);
+    }
+    {
+        WeJson doc(text);
+        values.push_back(std::move(doc.get_object()["name"]));
+        values.push_back(std::move(doc.get_object()["list"]));
+        ASSERT_EQ(doc.get_object()["list"].type(), JSON_NULL_TYPE);
+    }
+    ASSERT_EQ(value.to_string(), "{\"name\":\"a long string value that does not fit in sso\",\"list\":[1,{\"k\":[true]}]}");
+    ASSERT_EQ(values[0].to_string(), "a long string value that does not fit in sso");
+    ASSERT_EQ(values[1].to_string(), "[1,{\"k\":[true]}]");
+
+    // 写时复制出来的对象在堆上，成员仍然在文档的 arena 中，移动时同样拷贝出来
+    JsonObject from_copy;
+    {
+        WeJson doc(text);
+        WeJson copy(doc);
+        copy["name"] = JsonValue("changed");
+        from_copy = std::move(copy.get_object());
+    }
+    ASSERT_EQ(from_copy.to_string(), "{\"name\":\"changed\",\"list\":[1,{\"k\":[true]}]}");
+
+    // 重新解析时重用 arena，之前移动出来的值不受影响
+    WeJson doc(text);
+    JsonValue name = std::move(doc["name"]);
+    JsonValue list = std::move(doc["list"]);
+    doc.parse("{\"other\": \"another long string value that reuses the arena\", \"x\": [2, 3, 4]}");
+    ASSERT_EQ(name.to_string(), "a long string value that does not fit in sso");
+    ASSERT_EQ(list.to_string(), "[1,{\"k\":[true]}]");
+}
+
+TEST_F(WeJson_Test, CopyOnWriteTest)
+{
+    // 堆上的值拷贝时共享对象和数组
+    JsonValue value;
+    value = JsonObject();
+    value.get_object().emplace("a", JsonObject()).get_object().emplace("x", 1);
+    value.get_object().emplace("b", JsonArray()).get_array().emplace_back("text");
+
+    const JsonValue shared = value;
+    ASSERT_EQ(&shared.get_object(), &static_cast<const JsonValue&>(value).get_object());
+    ASSERT_EQ(shared == value, true);
+
+    // 修改时只复制被修改的路径，其余的子树继续共享
+    value["a"]["x"] = JsonValue(2);
+    ASSERT_EQ(shared.to_string(), "{\"a\":{\"x\":1},\"b\":[\"text\"]}");
+    ASSERT_EQ(value.to_string(), "{\"a\":{\"x\":2},\"b\":[\"text\"]}");
+    const JsonValue &const_value = value;
+    ASSERT_NE(&const_value.get_object(), &shared.get_object());
+    ASSERT_NE(&const_value["a"].get_object(), &shared["a"].get_object());
+    ASSERT_EQ(&const_value["b"].get_array(), &shared["b"].get_array());
+
+    // 转换成 JsonObject 时子节点继续共享
+    JsonObject converted = value;
+    ASSERT_EQ(&static_cast<const JsonObject&>(converted)["b"].get_array(), &shared["b"].get_array());
+    converted["b"].get_array().add(JsonValue(true));
+    ASSERT_EQ(shared["b"].to_string(), "[\"text\"]");
+
+    // 文档的拷贝共享 arena 和 json 树
+    std::string text = "{\"name\": \"a long string value that does not fit in sso\", \"list\": [1, {\"k\": \"v\"}], \"obj\": {\"a\": {}}}";
+    JsonValue out;
+    WeJson copy;
+    {
+        WeJson origin(text);
+        copy = origin;
+        ASSERT_EQ(copy.arena(), origin.arena());
+        const WeJson &const_origin = origin;
+        const WeJson &const_copy = copy;
+        ASSERT_EQ(&const_copy.get_object(), &const_origin.get_object());
+
+        copy.get_object()["obj"]["a"] = JsonValue("changed");
+        ASSERT_EQ(origin.to_string(), WeJson(text).to_string());
+        ASSERT_EQ(copy.to_string(), "{\"name\":\"a long string value that does not fit in sso\",\"list\":[1,{\"k\":\"v\"}],\"obj\":{\"a\":\"changed\"}}");
+        ASSERT_EQ(&const_copy["list"].get_array(), &const_origin["list"].get_array());
+
+        // 从文档拷贝到普通的值时仍然拷贝到堆上
+        out = copy.get_object()["list"];
+        ASSERT_NE(&static_cast<const JsonValue&>(out).get_array(), &const_origin["list"].get_array());
+
+        // 被共享时重新解析使用新的 arena
+        WeJson other(origin);
+        origin.parse(std::string("[true]"));
+        ASSERT_NE(origin.arena(), other.arena());
+        ASSERT_EQ(other.to_string(), WeJson(text).to_string());
+    }
+    ASSERT_EQ(copy.get_object()["name"].to_string(), "a long string value that does not fit in sso");
+    ASSERT_EQ(copy.get_object()["list"].to_string(), "[1,{\"k\":\"v\"}]");
+    ASSERT_EQ(out.to_string(), "[1,{\"k\":\"v\"}]");
+
+    // 多个线程同时拷贝和修改同一个缓存的文档
+    const WeJson cache(text);
+    std::vector<std::thread> threads;
+    std::vector<std::string> results(8);
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&cache, &results, t]() {
+            for (int i = 0; i < 200; ++i) {
+                WeJson request(cache);
+                ASSERT_EQ(request["list"][0], JsonValue(1));
+                request["list"][1]["k"] = JsonValue(t);
+                request.get_object().add("t", JsonValue(i));
+                results[t] = request["list"].to_string();
+            }
+        });
+    }
+    for (std::size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    for (int t = 0; t < 8; ++t) {
+        ASSERT_EQ(results[t], "[1,{\"k\":" + std::to_string(t) + "}]");
+    }
+    ASSERT_EQ(cache == WeJson(text), true);
+}
+
 }
 }
 }
@@ -2,23 +2,55 @@
 #include "logger.h"
 #include "debug.h"
 
+#ifdef __BYTE_BUFFER_STATS__
+#include <atomic>
+#endif
+
 namespace basic {
 
+#ifdef __BYTE_BUFFER_STATS__
+namespace {
+
+// 所有对象共享的统计信息，可能被多个线程同时修改
+struct GlobalStats {
+    std::atomic<int64_t> allocations;
+    std::atomic<int64_t> frees;
+    std::atomic<int64_t> resizes;
+    std::atomic<int64_t> bytes_copied_in;
+    std::atomic<int64_t> bytes_copied_out;
+    std::atomic<int64_t> peak_capacity;
+    std::atomic<int64_t> wrap_arounds;
+};
+
+GlobalStats g_stats;
+
+void update_peak(std::atomic<int64_t> &peak, int64_t value)
+{
+    int64_t old_value = peak.load(std::memory_order_relaxed);
+    while (old_value < value && !peak.compare_exchange_weak(old_value, value, std::memory_order_relaxed)) {}
+}
+
+}
+
+#define BUFFER_STATS_ADD(field, value) \
+    do { \
+        stats_.field += (value); \
+        g_stats.field.fetch_add((value), std::memory_order_relaxed); \
+    } while (0)
+#else
+#define BUFFER_STATS_ADD(field, value)
+#endif
+
 ByteBuffer::ByteBuffer(ssize_t size)
-: buffer_(nullptr),
+: buffer_(inline_buffer_),
   start_read_pos_(0), 
   start_write_pos_(0), 
   used_data_size_(0),
-  free_data_size_(0),
-  max_buffer_size_(0)
+  free_data_size_(INLINE_BUFFER_SIZE - 1),
+  max_buffer_size_(INLINE_BUFFER_SIZE)
 {
-    if (size <= 0)
-    {
-        max_buffer_size_ = 0;
-        free_data_size_ = 0;
-        buffer_ = nullptr;
-    }
-    else
+    // 需要的空间内部缓存放得下时不分配内存
+    if (size > 0 && 2 * size > INLINE_BUFFER_SIZE)
     {
         max_buffer_size_ = 2 * size;
         if (max_buffer_size_ >= MAX_BUFFER_SIZE) {
@@ -27,49 +59,39 @@ ByteBuffer::ByteBuffer(ssize_t size)
 
         free_data_size_ = max_buffer_size_ - 1;
         buffer_ = new bufftype[max_buffer_size_];
+        this->record_alloc();
     }
 }
 
 ByteBuffer::ByteBuffer(const ByteBuffer &buff)
-: buffer_(nullptr),
+: buffer_(inline_buffer_),
   start_read_pos_(0), 
   start_write_pos_(0), 
   used_data_size_(0),
-  free_data_size_(0),
-  max_buffer_size_(0)
-{
-    start_read_pos_ = buff.start_read_pos_;
-    start_write_pos_ = buff.start_write_pos_;
-    used_data_size_ = buff.used_data_size_;
-    free_data_size_ = buff.free_data_size_;
-    max_buffer_size_ = buff.max_buffer_size_;
-
-    if (buff.buffer_ != nullptr && buff.max_buffer_size_ > 0) {
-        buffer_ = new bufftype[buff.max_buffer_size_];
-        memmove(buffer_, buff.buffer_, buff.max_buffer_size_);
-    } else {
-        this->clear();
-    }
+  free_data_size_(INLINE_BUFFER_SIZE - 1),
+  max_buffer_size_(INLINE_BUFFER_SIZE)
+{
+    this->copy_from(buff);
 }
 
 ByteBuffer::ByteBuffer(const std::string &str)
-: buffer_(nullptr),
+: buffer_(inline_buffer_),
   start_read_pos_(0), 
   start_write_pos_(0), 
   used_data_size_(0),
-  free_data_size_(0),
-  max_buffer_size_(0)
+  free_data_size_(INLINE_BUFFER_SIZE - 1),
+  max_buffer_size_(INLINE_BUFFER_SIZE)
 {
     this->write_string(str);
 }
 
 ByteBuffer::ByteBuffer(const buffptr data, ssize_t size)
-: buffer_(nullptr),
+: buffer_(inline_buffer_),
   start_read_pos_(0), 
   start_write_pos_(0), 
   used_data_size_(0),
-  free_data_size_(0),
-  max_buffer_size_(0)
+  free_data_size_(INLINE_BUFFER_SIZE - 1),
+  max_buffer_size_(INLINE_BUFFER_SIZE)
 {
     this->write_bytes(data, size);
 }
@@ -81,20 +103,116 @@ ByteBuffer::~ByteBuffer()
 
 ssize_t ByteBuffer::clear(void)
 {
-    if (buffer_ != nullptr) {
+    if (buffer_ != nullptr && buffer_ != inline_buffer_) {
         delete[] buffer_;
-        buffer_ = nullptr;
+        this->record_free();
     }
 
+    // 清空后回到内部缓存
+    buffer_ = inline_buffer_;
     used_data_size_ = 0;
-    free_data_size_ = 0;
+    free_data_size_ = INLINE_BUFFER_SIZE - 1;
     start_read_pos_ = 0;
     start_write_pos_ = 0;
-    max_buffer_size_ = 0;
+    max_buffer_size_ = INLINE_BUFFER_SIZE;
 
     return 0;
 }
 
+void ByteBuffer::copy_from(const ByteBuffer &src)
+{
+    // 只拷贝数据部分，数据从缓冲区的开始位置存放
+    buffptr first = nullptr, second = nullptr;
+    ssize_t first_size = 0, second_size = 0;
+    src.get_read_segments(first, first_size, second, second_size);
+
+    if (src.used_data_size_ >= INLINE_BUFFER_SIZE) {
+        buffer_ = new bufftype[src.max_buffer_size_];
+        max_buffer_size_ = src.max_buffer_size_;
+        this->record_alloc();
+    }
+
+    if (first_size > 0) {
+        memcpy(buffer_, first, first_size);
+    }
+    if (second_size > 0) {
+        memcpy(buffer_ + first_size, second, second_size);
+    }
+
+    start_read_pos_ = 0;
+    start_write_pos_ = src.used_data_size_;
+    used_data_size_ = src.used_data_size_;
+    free_data_size_ = max_buffer_size_ - 1 - used_data_size_;
+}
+
+void ByteBuffer::record_alloc(void)
+{
+#ifdef __BYTE_BUFFER_STATS__
+    BUFFER_STATS_ADD(allocations, 1);
+    if (stats_.peak_capacity < max_buffer_size_) {
+        stats_.peak_capacity = max_buffer_size_;
+    }
+    update_peak(g_stats.peak_capacity, max_buffer_size_);
+#endif
+}
+
+void ByteBuffer::record_free(void)
+{
+    BUFFER_STATS_ADD(frees, 1);
+}
+
+ByteBufferStats ByteBuffer::stats(void) const
+{
+#ifdef __BYTE_BUFFER_STATS__
+    return stats_;
+#else
+    return ByteBufferStats();
+#endif
+}
+
+ByteBufferStats ByteBuffer::global_stats(void)
+{
+    ByteBufferStats stats = ByteBufferStats();
+#ifdef __BYTE_BUFFER_STATS__
+    stats.allocations = g_stats.allocations.load(std::memory_order_relaxed);
+    stats.frees = g_stats.frees.load(std::memory_order_relaxed);
+    stats.resizes = g_stats.resizes.load(std::memory_order_relaxed);
+    stats.bytes_copied_in = g_stats.bytes_copied_in.load(std::memory_order_relaxed);
+    stats.bytes_copied_out = g_stats.bytes_copied_out.load(std::memory_order_relaxed);
+    stats.peak_capacity = g_stats.peak_capacity.load(std::memory_order_relaxed);
+    stats.wrap_arounds = g_stats.wrap_arounds.load(std::memory_order_relaxed);
+#endif
+    return stats;
+}
+
+void ByteBuffer::reset_global_stats(void)
+{
+#ifdef __BYTE_BUFFER_STATS__
+    g_stats.allocations = 0;
+    g_stats.frees = 0;
+    g_stats.resizes = 0;
+    g_stats.bytes_copied_in = 0;
+    g_stats.bytes_copied_out = 0;
+    g_stats.peak_capacity = 0;
+    g_stats.wrap_arounds = 0;
+#endif
+}
+
+void ByteBuffer::dump_stats(const ByteBufferStats &stats, const std::string &name, InfoLevel level)
+{
+    Logger::g_log_msg.print_msg(level, __LINE__, __FILE__, __FUNCTION__,
+            "ByteBuffer stats[%s]: allocations: %lld, frees: %lld, resizes: %lld, "
+            "bytes_copied_in: %lld, bytes_copied_out: %lld, peak_capacity: %lld, wrap_arounds: %lld",
+            name.c_str(),
+            static_cast<long long>(stats.allocations),
+            static_cast<long long>(stats.frees),
+            static_cast<long long>(stats.resizes),
+            static_cast<long long>(stats.bytes_copied_in),
+            static_cast<long long>(stats.bytes_copied_out),
+            static_cast<long long>(stats.peak_capacity),
+            static_cast<long long>(stats.wrap_arounds));
+}
+
 ssize_t ByteBuffer::set_extern_buffer(buffptr exbuf, ssize_t buff_size)
 {
     if (exbuf == nullptr || buff_size <= 0) {
@@ -155,6 +273,8 @@ ByteBuffer::resize(ssize_t size)
 
     buffptr new_buffer = new bufftype[new_size];
     this->set_extern_buffer(new_buffer, new_size);
+    this->record_alloc();
+    BUFFER_STATS_ADD(resizes, 1);
     if (tmp_buffer_size > 0) {
         this->write_bytes(tmp_buffer, tmp_buffer_size);
         delete[] tmp_buffer;
@@ -250,7 +370,7 @@ ssize_t ByteBuffer::copy_data_to_buffer(const void *data, ssize_t size)
             break;
         }
     }
-    
+    BUFFER_STATS_ADD(bytes_copied_in, size - copy_size);
 
     return size - copy_size;
 }
@@ -277,6 +397,7 @@ ssize_t ByteBuffer::copy_data_from_buffer(void *data, ssize_t size)
             break;
         }
     }
+    BUFFER_STATS_ADD(bytes_copied_out, size - copy_size);
 
     return size - copy_size;
 }
@@ -363,11 +484,25 @@ ByteBuffer::read_only(ssize_t start_pos, void *buf, ssize_t buf_size)
 std::string 
 ByteBuffer::str()
 {
-    bufftype *buffer = new bufftype[data_size() + 1];
-    memset(buffer, 0, data_size() + 1);
-    read_only(0, buffer, data_size());
-    std::string str = buffer;
-    delete[] buffer;
+    // 直接从两段内存构造字符串，和之前一样遇到 '\0' 时结束
+    buffptr first = nullptr, second = nullptr;
+    ssize_t first_size = 0, second_size = 0;
+    this->get_read_segments(first, first_size, second, second_size);
+
+    std::string str(first != nullptr ? first : "", first_size);
+    std::string::size_type end_pos = str.find('\0');
+    if (end_pos != std::string::npos) {
+        str.resize(end_pos);
+        return str;
+    }
+    if (second_size > 0) {
+        str.append(second, second_size);
+        end_pos = str.find('\0', first_size);
+        if (end_pos != std::string::npos) {
+            str.resize(end_pos);
+        }
+    }
+
     return str;
 }
 
@@ -506,23 +641,12 @@ ByteBuffer::operator!=(const ByteBuffer &rhs) const
 ByteBuffer& 
 ByteBuffer::operator=(const ByteBuffer& src)
 {
-    if (src == *this) { // 当赋值对象是自己时，直接返回
+    if (&src == this) { // 当赋值对象是自己时，直接返回
         return *this;
     }
     this->clear();
+    this->copy_from(src);
 
-    start_read_pos_ = src.start_read_pos_;
-    start_write_pos_ = src.start_write_pos_;
-    used_data_size_ = src.used_data_size_;
-    free_data_size_ = src.free_data_size_;
-    max_buffer_size_ = src.max_buffer_size_;
-
-    if (src.buffer_ != nullptr && src.max_buffer_size_ > 0) {
-        buffer_ = new bufftype[src.max_buffer_size_];
-        memmove(buffer_, src.buffer_, src.max_buffer_size_);
-    } else {
-        this->clear();
-    }
     return *this;
 }
 
@@ -624,6 +748,19 @@ ByteBuffer::get_cont_read_size(void) const
     return 0;
 }
 
+void
+ByteBuffer::get_read_segments(buffptr &first, ssize_t &first_size, buffptr &second, ssize_t &second_size) const
+{
+    first = this->get_read_buffer_ptr();
+    first_size = this->get_cont_read_size();
+    second = buffer_;
+    second_size = used_data_size_ - first_size;
+    if (second_size <= 0) {
+        second = nullptr;
+        second_size = 0;
+    }
+}
+
 ssize_t 
 ByteBuffer::update_write_pos(ssize_t offset)
 {
@@ -631,6 +768,9 @@ ByteBuffer::update_write_pos(ssize_t offset)
         return -1;
     }
 
+    if (offset > 0 && start_write_pos_ + offset >= max_buffer_size_) {
+        BUFFER_STATS_ADD(wrap_arounds, 1);
+    }
     used_data_size_ += offset;
     free_data_size_ -= offset;
     start_write_pos_ = (start_write_pos_ + offset) % max_buffer_size_;
@@ -645,6 +785,9 @@ ByteBuffer::update_read_pos(ssize_t offset)
         return -1;
     }
 
+    if (offset > 0 && start_read_pos_ + offset >= max_buffer_size_) {
+        BUFFER_STATS_ADD(wrap_arounds, 1);
+    }
     used_data_size_ -= offset;
     free_data_size_ += offset;
     start_read_pos_ = (start_read_pos_ + offset) % max_buffer_size_;
@@ -652,6 +795,55 @@ ByteBuffer::update_read_pos(ssize_t offset)
     return 0;
 }
 
+buffptr
+ByteBuffer::linearize(void)
+{
+    if (used_data_size_ == 0) {
+        start_read_pos_ = 0;
+        start_write_pos_ = 0;
+        return buffer_;
+    }
+
+    buffptr first = nullptr, second = nullptr;
+    ssize_t first_size = 0, second_size = 0;
+    this->get_read_segments(first, first_size, second, second_size);
+
+    if (second_size == 0) {
+        if (start_read_pos_ != 0) {
+            memmove(buffer_, first, first_size);
+        }
+    } else if (first_size <= second_size) {
+        // 先保存末尾的一段，再把开头的一段后移
+        buffptr tmp = new bufftype[first_size];
+        memcpy(tmp, first, first_size);
+        memmove(buffer_ + first_size, second, second_size);
+        memcpy(buffer_, tmp, first_size);
+        delete[] tmp;
+    } else {
+        // 先保存开头的一段，再把末尾的一段前移
+        buffptr tmp = new bufftype[second_size];
+        memcpy(tmp, second, second_size);
+        memmove(buffer_, first, first_size);
+        memcpy(buffer_ + first_size, tmp, second_size);
+        delete[] tmp;
+    }
+
+    start_read_pos_ = 0;
+    start_write_pos_ = used_data_size_;
+
+    return buffer_;
+}
+
+ssize_t
+ByteBuffer::compact(void)
+{
+    if (this->get_cont_write_size() < free_data_size_) {
+        this->linearize();
+    }
+
+    return this->get_cont_write_size();
+}
+
 ///////////////////////////// 操作 ByteBuffer /////////////////////////////
 std::vector<ByteBufferIterator>
 ByteBuffer::find(const ByteBuffer &patten)
@@ -926,7 +1118,8 @@ ByteBufferIterator::operator-(ByteBufferIterator &rhs)
 
     ssize_t diff = right_postion - left_postion;
 
-    if (left_postion < start) {
+    // 只有一个位置折返到了缓存开头时，距离需要跨过缓存末尾
+    if (left_postion < start && right_postion >= start) {
         return max_size - diff;
     }
     
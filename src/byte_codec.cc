@@ -0,0 +1,639 @@
+#include "byte_codec.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define __BASIC_CODEC_X86__
+#endif
+
+namespace basic {
+
+namespace {
+
+const char base64_standard_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+const char base64_url_safe_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+const char hex_lower_chars[] = "0123456789abcdef";
+const char hex_upper_chars[] = "0123456789ABCDEF";
+
+enum SimdLevel {
+    SIMD_LEVEL_NONE,
+    SIMD_LEVEL_SSSE3,
+    SIMD_LEVEL_AVX2
+};
+
+SimdLevel
+simd_level(void)
+{
+    static SimdLevel level = []() {
+#if defined(__BASIC_CODEC_X86__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return SIMD_LEVEL_AVX2;
+        }
+        if (__builtin_cpu_supports("ssse3")) {
+            return SIMD_LEVEL_SSSE3;
+        }
+#endif
+        return SIMD_LEVEL_NONE;
+    }();
+
+    return level;
+}
+
+// 字符到数值的反查表，非法字符为 -1
+struct DecodeTable {
+    int8_t value[256];
+
+    explicit DecodeTable(const char *chars, bool ignore_case = false) {
+        memset(value, -1, sizeof(value));
+        for (int i = 0; chars[i] != '\0'; ++i) {
+            value[static_cast<uint8_t>(chars[i])] = static_cast<int8_t>(i);
+            if (ignore_case) {
+                value[static_cast<uint8_t>(toupper(chars[i]))] = static_cast<int8_t>(i);
+            }
+        }
+    }
+};
+
+const DecodeTable&
+base64_decode_table(Base64Alphabet alphabet)
+{
+    static const DecodeTable standard_table(base64_standard_chars);
+    static const DecodeTable url_safe_table(base64_url_safe_chars);
+
+    return alphabet == BASE64_URL_SAFE ? url_safe_table : standard_table;
+}
+
+const DecodeTable&
+hex_decode_table(void)
+{
+    static const DecodeTable table(hex_lower_chars, true);
+    return table;
+}
+
+// 一次转换的参数：每 in_unit 个输入字节转换为 out_unit 个输出字节
+struct Transcoder {
+    ssize_t in_unit;
+    ssize_t out_unit;
+    Base64Alphabet alphabet;
+    const char *chars;
+    // in_size 是 in_unit 的整数倍，返回写入 out 的字节数，输入不合法时返回 -1
+    ssize_t (*convert)(const uint8_t *in, ssize_t in_size, uint8_t *out, const Transcoder &tc);
+};
+
+#if defined(__BASIC_CODEC_X86__)
+///////////////////////////////// SSSE3 ///////////////////////////////////
+// base64 编解码的向量算法参考 Wojciech Muła 和 Daniel Lemire 的论文
+// "Faster Base64 Encoding and Decoding Using AVX2 Instructions"
+
+__attribute__((target("ssse3")))
+inline __m128i
+in_range_ssse3(__m128i v, char low, char high)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(low - 1))),
+                         _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(high + 1)), v));
+}
+
+__attribute__((target("ssse3")))
+ssize_t
+base64_encode_ssse3(const uint8_t *in, ssize_t in_size, char *out, const char *chars)
+{
+    const __m128i lut = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4,
+                            static_cast<char>(chars[62] - 62), static_cast<char>(chars[63] - 63), 0, 0);
+    ssize_t done = 0;
+    // 每次读取 16 字节但只用前 12 字节
+    for (; in_size - done >= 16; done += 12) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done));
+        v = _mm_shuffle_epi8(v, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+        const __m128i t0 = _mm_and_si128(v, _mm_set1_epi32(0x0FC0FC00));
+        const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        const __m128i t2 = _mm_and_si128(v, _mm_set1_epi32(0x003F03F0));
+        const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        const __m128i indices = _mm_or_si128(t1, t3);
+
+        // 0..25 查表下标为 0, 26..51 为 1, 52..61 为 2..11, 62 为 12, 63 为 13
+        __m128i lut_index = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        lut_index = _mm_sub_epi8(lut_index, _mm_cmpgt_epi8(indices, _mm_set1_epi8(25)));
+        const __m128i result = _mm_add_epi8(indices, _mm_shuffle_epi8(lut, lut_index));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + done / 3 * 4), result);
+    }
+
+    return done;
+}
+
+__attribute__((target("ssse3")))
+ssize_t
+base64_decode_ssse3(const char *in, ssize_t in_size, uint8_t *out, const char *chars)
+{
+    const char ch62 = chars[62], ch63 = chars[63];
+    ssize_t done = 0;
+    // 每次写出 16 字节但只有前 12 字节有效，需要保证输出缓冲区不会越界
+    for (; in_size - done >= 24; done += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done));
+
+        const __m128i upper = in_range_ssse3(v, 'A', 'Z');
+        const __m128i lower = in_range_ssse3(v, 'a', 'z');
+        const __m128i digit = in_range_ssse3(v, '0', '9');
+        const __m128i is_62 = _mm_cmpeq_epi8(v, _mm_set1_epi8(ch62));
+        const __m128i is_63 = _mm_cmpeq_epi8(v, _mm_set1_epi8(ch63));
+        const __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(is_62, is_63)));
+        if (_mm_movemask_epi8(valid) != 0xFFFF) { // 交给标量实现处理并报错
+            break;
+        }
+
+        __m128i delta = _mm_and_si128(upper, _mm_set1_epi8(-65));
+        delta = _mm_or_si128(delta, _mm_and_si128(lower, _mm_set1_epi8(-71)));
+        delta = _mm_or_si128(delta, _mm_and_si128(digit, _mm_set1_epi8(4)));
+        delta = _mm_or_si128(delta, _mm_and_si128(is_62, _mm_set1_epi8(static_cast<char>(62 - ch62))));
+        delta = _mm_or_si128(delta, _mm_and_si128(is_63, _mm_set1_epi8(static_cast<char>(63 - ch63))));
+        v = _mm_add_epi8(v, delta);
+
+        // 每 4 个 6 位的值合并成 3 个字节
+        v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+        v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+        v = _mm_shuffle_epi8(v, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + done / 4 * 3), v);
+    }
+
+    return done;
+}
+
+__attribute__((target("ssse3")))
+ssize_t
+hex_encode_ssse3(const uint8_t *in, ssize_t in_size, char *out, const char *chars)
+{
+    const __m128i lut = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars));
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    ssize_t done = 0;
+    for (; in_size - done >= 16; done += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done));
+        const __m128i high = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        const __m128i low = _mm_shuffle_epi8(lut, _mm_and_si128(v, mask));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + done * 2), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + done * 2 + 16), _mm_unpackhi_epi8(high, low));
+    }
+
+    return done;
+}
+
+__attribute__((target("ssse3")))
+ssize_t
+hex_decode_ssse3(const char *in, ssize_t in_size, uint8_t *out)
+{
+    ssize_t done = 0;
+    for (; in_size - done >= 16; done += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done));
+        const __m128i lower_case = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        const __m128i digit = in_range_ssse3(v, '0', '9');
+        const __m128i alpha = in_range_ssse3(lower_case, 'a', 'f');
+        if (_mm_movemask_epi8(_mm_or_si128(digit, alpha)) != 0xFFFF) {
+            break;
+        }
+
+        const __m128i value = _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(v, _mm_set1_epi8('0'))),
+                                           _mm_and_si128(alpha, _mm_sub_epi8(lower_case, _mm_set1_epi8('a' - 10))));
+        // 相邻两个字符合并为一个字节: high * 16 + low
+        const __m128i pairs = _mm_maddubs_epi16(value, _mm_set1_epi16(0x0110));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + done / 2), _mm_packus_epi16(pairs, pairs));
+    }
+
+    return done;
+}
+
+///////////////////////////////// AVX2 ///////////////////////////////////
+
+__attribute__((target("avx2")))
+inline __m256i
+in_range_avx2(__m256i v, char low, char high)
+{
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(low - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(high + 1)), v));
+}
+
+__attribute__((target("avx2")))
+ssize_t
+base64_encode_avx2(const uint8_t *in, ssize_t in_size, char *out, const char *chars)
+{
+    const char off62 = static_cast<char>(chars[62] - 62), off63 = static_cast<char>(chars[63] - 63);
+    const __m256i lut = _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, off62, off63, 0, 0,
+                                         65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, off62, off63, 0, 0);
+    ssize_t done = 0;
+    // 每次读取 32 字节但只用前 24 字节，两个 128 位通道各处理 12 字节
+    for (; in_size - done >= 32; done += 24) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + done));
+        v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6));
+        v = _mm256_shuffle_epi8(v, _mm256_set_epi8(
+                10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                14, 15, 13, 14, 11, 12, 10, 11, 8, 9, 7, 8, 5, 6, 4, 5));
+
+        const __m256i t0 = _mm256_and_si256(v, _mm256_set1_epi32(0x0FC0FC00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(v, _mm256_set1_epi32(0x003F03F0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        const __m256i indices = _mm256_or_si256(t1, t3);
+
+        __m256i lut_index = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        lut_index = _mm256_sub_epi8(lut_index, _mm256_cmpgt_epi8(indices, _mm256_set1_epi8(25)));
+        const __m256i result = _mm256_add_epi8(indices, _mm256_shuffle_epi8(lut, lut_index));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + done / 3 * 4), result);
+    }
+
+    return done;
+}
+
+__attribute__((target("avx2")))
+ssize_t
+base64_decode_avx2(const char *in, ssize_t in_size, uint8_t *out, const char *chars)
+{
+    const char ch62 = chars[62], ch63 = chars[63];
+    ssize_t done = 0;
+    // 每次写出 32 字节但只有前 24 字节有效，需要保证输出缓冲区不会越界
+    for (; in_size - done >= 44; done += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + done));
+
+        const __m256i upper = in_range_avx2(v, 'A', 'Z');
+        const __m256i lower = in_range_avx2(v, 'a', 'z');
+        const __m256i digit = in_range_avx2(v, '0', '9');
+        const __m256i is_62 = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(ch62));
+        const __m256i is_63 = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(ch63));
+        const __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, _mm256_or_si256(is_62, is_63)));
+        if (_mm256_movemask_epi8(valid) != -1) {
+            break;
+        }
+
+        __m256i delta = _mm256_and_si256(upper, _mm256_set1_epi8(-65));
+        delta = _mm256_or_si256(delta, _mm256_and_si256(lower, _mm256_set1_epi8(-71)));
+        delta = _mm256_or_si256(delta, _mm256_and_si256(digit, _mm256_set1_epi8(4)));
+        delta = _mm256_or_si256(delta, _mm256_and_si256(is_62, _mm256_set1_epi8(static_cast<char>(62 - ch62))));
+        delta = _mm256_or_si256(delta, _mm256_and_si256(is_63, _mm256_set1_epi8(static_cast<char>(63 - ch63))));
+        v = _mm256_add_epi8(v, delta);
+
+        v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+        v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + done / 4 * 3), v);
+    }
+
+    return done;
+}
+
+__attribute__((target("avx2")))
+ssize_t
+hex_encode_avx2(const uint8_t *in, ssize_t in_size, char *out, const char *chars)
+{
+    const __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(chars)));
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    ssize_t done = 0;
+    for (; in_size - done >= 32; done += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + done));
+        const __m256i high = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+        const __m256i low = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, mask));
+
+        // unpack 只在 128 位通道内交错，需要重新排列两个通道
+        const __m256i first = _mm256_unpacklo_epi8(high, low);
+        const __m256i second = _mm256_unpackhi_epi8(high, low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + done * 2), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + done * 2 + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+
+    return done;
+}
+
+__attribute__((target("avx2")))
+ssize_t
+hex_decode_avx2(const char *in, ssize_t in_size, uint8_t *out)
+{
+    ssize_t done = 0;
+    for (; in_size - done >= 32; done += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + done));
+        const __m256i lower_case = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        const __m256i digit = in_range_avx2(v, '0', '9');
+        const __m256i alpha = in_range_avx2(lower_case, 'a', 'f');
+        if (_mm256_movemask_epi8(_mm256_or_si256(digit, alpha)) != -1) {
+            break;
+        }
+
+        const __m256i value = _mm256_or_si256(_mm256_and_si256(digit, _mm256_sub_epi8(v, _mm256_set1_epi8('0'))),
+                                              _mm256_and_si256(alpha, _mm256_sub_epi8(lower_case, _mm256_set1_epi8('a' - 10))));
+        const __m256i pairs = _mm256_maddubs_epi16(value, _mm256_set1_epi16(0x0110));
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(pairs, pairs), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + done / 2), _mm256_castsi256_si128(packed));
+    }
+
+    return done;
+}
+#endif
+
+/////////////////////////////// 标量实现和分发 /////////////////////////////////
+
+ssize_t
+base64_encode_block(const uint8_t *in, ssize_t in_size, uint8_t *out, const Transcoder &tc)
+{
+    char *out_chars = reinterpret_cast<char*>(out);
+    ssize_t done = 0;
+#if defined(__BASIC_CODEC_X86__)
+    if (simd_level() == SIMD_LEVEL_AVX2) {
+        done = base64_encode_avx2(in, in_size, out_chars, tc.chars);
+    } else if (simd_level() == SIMD_LEVEL_SSSE3) {
+        done = base64_encode_ssse3(in, in_size, out_chars, tc.chars);
+    }
+#endif
+
+    for (ssize_t i = done; i < in_size; i += 3) {
+        uint32_t val = (static_cast<uint32_t>(in[i]) << 16) | (static_cast<uint32_t>(in[i + 1]) << 8) | in[i + 2];
+        char *dst = out_chars + i / 3 * 4;
+        dst[0] = tc.chars[(val >> 18) & 0x3F];
+        dst[1] = tc.chars[(val >> 12) & 0x3F];
+        dst[2] = tc.chars[(val >> 6) & 0x3F];
+        dst[3] = tc.chars[val & 0x3F];
+    }
+
+    return in_size / 3 * 4;
+}
+
+ssize_t
+base64_decode_block(const uint8_t *in, ssize_t in_size, uint8_t *out, const Transcoder &tc)
+{
+    const char *in_chars = reinterpret_cast<const char*>(in);
+    ssize_t done = 0;
+#if defined(__BASIC_CODEC_X86__)
+    if (simd_level() == SIMD_LEVEL_AVX2) {
+        done = base64_decode_avx2(in_chars, in_size, out, tc.chars);
+    } else if (simd_level() == SIMD_LEVEL_SSSE3) {
+        done = base64_decode_ssse3(in_chars, in_size, out, tc.chars);
+    }
+#endif
+
+    const int8_t *table = base64_decode_table(tc.alphabet).value;
+    for (ssize_t i = done; i < in_size; i += 4) {
+        int8_t a = table[in[i]], b = table[in[i + 1]], c = table[in[i + 2]], d = table[in[i + 3]];
+        if ((a | b | c | d) < 0) {
+            return -1;
+        }
+
+        uint32_t val = (static_cast<uint32_t>(a) << 18) | (static_cast<uint32_t>(b) << 12) | (static_cast<uint32_t>(c) << 6) | d;
+        uint8_t *dst = out + i / 4 * 3;
+        dst[0] = static_cast<uint8_t>(val >> 16);
+        dst[1] = static_cast<uint8_t>(val >> 8);
+        dst[2] = static_cast<uint8_t>(val);
+    }
+
+    return in_size / 4 * 3;
+}
+
+ssize_t
+hex_encode_block(const uint8_t *in, ssize_t in_size, uint8_t *out, const Transcoder &tc)
+{
+    char *out_chars = reinterpret_cast<char*>(out);
+    ssize_t done = 0;
+#if defined(__BASIC_CODEC_X86__)
+    if (simd_level() == SIMD_LEVEL_AVX2) {
+        done = hex_encode_avx2(in, in_size, out_chars, tc.chars);
+    } else if (simd_level() == SIMD_LEVEL_SSSE3) {
+        done = hex_encode_ssse3(in, in_size, out_chars, tc.chars);
+    }
+#endif
+
+    for (ssize_t i = done; i < in_size; ++i) {
+        out_chars[2 * i] = tc.chars[in[i] >> 4];
+        out_chars[2 * i + 1] = tc.chars[in[i] & 0x0F];
+    }
+
+    return in_size * 2;
+}
+
+ssize_t
+hex_decode_block(const uint8_t *in, ssize_t in_size, uint8_t *out, const Transcoder &tc)
+{
+    const char *in_chars = reinterpret_cast<const char*>(in);
+    ssize_t done = 0;
+#if defined(__BASIC_CODEC_X86__)
+    if (simd_level() == SIMD_LEVEL_AVX2) {
+        done = hex_decode_avx2(in_chars, in_size, out);
+    } else if (simd_level() == SIMD_LEVEL_SSSE3) {
+        done = hex_decode_ssse3(in_chars, in_size, out);
+    }
+#endif
+
+    const int8_t *table = hex_decode_table().value;
+    for (ssize_t i = done; i < in_size; i += 2) {
+        int8_t high = table[in[i]], low = table[in[i + 1]];
+        if ((high | low) < 0) {
+            return -1;
+        }
+        out[i / 2] = static_cast<uint8_t>((high << 4) | low);
+    }
+
+    return in_size / 2;
+}
+
+// 保证 dst 有足够的空闲空间，避免转换过程中重新分配
+void
+reserve_idle_size(ByteBuffer &dst, ssize_t size)
+{
+    if (dst.idle_size() <= size) {
+        dst.resize(dst.data_size() + size + 1);
+    }
+}
+
+// 转换一段连续的输入(in_unit 的整数倍)，结果直接写到 dst 的可写内存中
+ssize_t
+convert_to_buffer(const uint8_t *in, ssize_t in_size, ByteBuffer &dst, const Transcoder &tc)
+{
+    ssize_t written = 0;
+    while (in_size > 0) {
+        ssize_t units = dst.get_cont_write_size() / tc.out_unit;
+        if (units > in_size / tc.in_unit) {
+            units = in_size / tc.in_unit;
+        }
+
+        ssize_t ret = 0;
+        if (units > 0) {
+            ret = tc.convert(in, units * tc.in_unit, reinterpret_cast<uint8_t*>(dst.get_write_buffer_ptr()), tc);
+            if (ret < 0) {
+                return -1;
+            }
+            dst.update_write_pos(ret);
+        } else {
+            // 写位置在缓冲区末尾，剩余的连续空间放不下一个单元，先转换到临时空间
+            uint8_t tmp[4];
+            units = 1;
+            ret = tc.convert(in, tc.in_unit, tmp, tc);
+            if (ret < 0) {
+                return -1;
+            }
+            dst.write_bytes(tmp, ret);
+        }
+
+        in += units * tc.in_unit;
+        in_size -= units * tc.in_unit;
+        written += ret;
+    }
+
+    return written;
+}
+
+// 转换 src 中前 in_size 个字节(in_unit 的整数倍)，处理数据在循环缓冲区中折返的情况
+ssize_t
+transcode(const ByteBuffer &src, ssize_t in_size, ByteBuffer &dst, const Transcoder &tc)
+{
+    buffptr segment[2];
+    ssize_t segment_size[2];
+    src.get_read_segments(segment[0], segment_size[0], segment[1], segment_size[1]);
+
+    uint8_t carry[4];
+    ssize_t carry_size = 0;
+    ssize_t written = 0;
+    for (int i = 0; i < 2 && in_size > 0; ++i) {
+        const uint8_t *in = reinterpret_cast<const uint8_t*>(segment[i]);
+        ssize_t size = segment_size[i] < in_size ? segment_size[i] : in_size;
+        in_size -= size;
+
+        // 补齐上一段末尾不足一个单元的数据
+        while (carry_size > 0 && carry_size < tc.in_unit && size > 0) {
+            carry[carry_size++] = *in++;
+            --size;
+        }
+        if (carry_size == tc.in_unit) {
+            ssize_t ret = convert_to_buffer(carry, carry_size, dst, tc);
+            if (ret < 0) {
+                return -1;
+            }
+            written += ret;
+            carry_size = 0;
+        }
+
+        ssize_t body_size = size / tc.in_unit * tc.in_unit;
+        ssize_t ret = convert_to_buffer(in, body_size, dst, tc);
+        if (ret < 0) {
+            return -1;
+        }
+        written += ret;
+
+        for (ssize_t j = body_size; j < size; ++j) {
+            carry[carry_size++] = in[j];
+        }
+    }
+
+    return written;
+}
+
+}
+
+ssize_t
+base64_encode(const ByteBuffer &src, ByteBuffer &dst, Base64Alphabet alphabet, bool padding)
+{
+    if (&src == &dst) {
+        return -1;
+    }
+
+    const char *chars = (alphabet == BASE64_URL_SAFE ? base64_url_safe_chars : base64_standard_chars);
+    Transcoder tc = {3, 4, alphabet, chars, base64_encode_block};
+
+    ssize_t in_size = src.data_size();
+    ssize_t tail_size = in_size % 3;
+    reserve_idle_size(dst, (in_size + 2) / 3 * 4);
+
+    ssize_t written = transcode(src, in_size - tail_size, dst, tc);
+    if (tail_size > 0) {
+        uint32_t val = static_cast<uint32_t>(static_cast<uint8_t>(src[in_size - tail_size])) << 16;
+        if (tail_size == 2) {
+            val |= static_cast<uint32_t>(static_cast<uint8_t>(src[in_size - 1])) << 8;
+        }
+
+        char tail[4] = {chars[(val >> 18) & 0x3F], chars[(val >> 12) & 0x3F], chars[(val >> 6) & 0x3F], '='};
+        if (tail_size == 1) {
+            tail[2] = '=';
+        }
+
+        ssize_t tail_chars = (padding ? 4 : tail_size + 1);
+        written += dst.write_bytes(tail, tail_chars);
+    }
+
+    return written;
+}
+
+ssize_t
+base64_decode(const ByteBuffer &src, ByteBuffer &dst, Base64Alphabet alphabet)
+{
+    if (&src == &dst) {
+        return -1;
+    }
+
+    const char *chars = (alphabet == BASE64_URL_SAFE ? base64_url_safe_chars : base64_standard_chars);
+    Transcoder tc = {4, 3, alphabet, chars, base64_decode_block};
+
+    ssize_t in_size = src.data_size();
+    ssize_t pad_size = 0;
+    while (pad_size < 2 && in_size - pad_size > 0 && src[in_size - pad_size - 1] == '=') {
+        ++pad_size;
+    }
+    if (pad_size > 0 && in_size % 4 != 0) {
+        return -1;
+    }
+
+    in_size -= pad_size;
+    ssize_t tail_size = in_size % 4;
+    if (tail_size == 1) {
+        return -1;
+    }
+    reserve_idle_size(dst, in_size / 4 * 3 + 2);
+
+    ssize_t written = transcode(src, in_size - tail_size, dst, tc);
+    if (written < 0) {
+        return -1;
+    }
+
+    if (tail_size > 0) {
+        const int8_t *table = base64_decode_table(alphabet).value;
+        uint32_t val = 0;
+        for (ssize_t i = 0; i < tail_size; ++i) {
+            int8_t ch = table[static_cast<uint8_t>(src[in_size - tail_size + i])];
+            if (ch < 0) {
+                return -1;
+            }
+            val |= static_cast<uint32_t>(ch) << (18 - 6 * i);
+        }
+
+        uint8_t tail[2] = {static_cast<uint8_t>(val >> 16), static_cast<uint8_t>(val >> 8)};
+        written += dst.write_bytes(tail, tail_size - 1);
+    }
+
+    return written;
+}
+
+ssize_t
+hex_encode(const ByteBuffer &src, ByteBuffer &dst, bool upper)
+{
+    if (&src == &dst) {
+        return -1;
+    }
+
+    Transcoder tc = {1, 2, BASE64_STANDARD, (upper ? hex_upper_chars : hex_lower_chars), hex_encode_block};
+    reserve_idle_size(dst, src.data_size() * 2);
+
+    return transcode(src, src.data_size(), dst, tc);
+}
+
+ssize_t
+hex_decode(const ByteBuffer &src, ByteBuffer &dst)
+{
+    if (&src == &dst || src.data_size() % 2 != 0) {
+        return -1;
+    }
+
+    Transcoder tc = {2, 1, BASE64_STANDARD, hex_lower_chars, hex_decode_block};
+    reserve_idle_size(dst, src.data_size() / 2);
+
+    return transcode(src, src.data_size(), dst, tc);
+}
+
+}
@@ -0,0 +1,419 @@
+#include "frame_decoder.h"
+
+namespace basic {
+
+namespace {
+
+enum ChunkState {
+    CHUNK_SIZE_LINE = 0,    // 等待 chunk 大小所在的行
+    CHUNK_DATA = 1,         // 等待 chunk 数据和结尾的 "\r\n"
+    CHUNK_TRAILER = 2       // 大小为 0 的 chunk 之后，等待 trailer 和空行
+};
+
+// chunk 大小所在行的最大长度(包括扩展字段)
+const ssize_t MAX_CHUNK_LINE_SIZE = 4096;
+
+// ByteBuffer 中数据所在的两段连续内存
+struct Segments {
+    buffptr first;
+    ssize_t first_size;
+    buffptr second;
+    ssize_t second_size;
+    ssize_t size;
+
+    explicit Segments(const ByteBuffer &buff) {
+        buff.get_read_segments(first, first_size, second, second_size);
+        size = first_size + second_size;
+    }
+
+    char at(ssize_t pos) const {
+        return pos < first_size ? first[pos] : second[pos - first_size];
+    }
+};
+
+// 从 start 开始查找 pattern，找到时返回相对于读位置的偏移，否则返回 -1
+ssize_t
+find_bytes(const Segments &seg, ssize_t start, const std::string &pattern)
+{
+    const ssize_t pattern_size = static_cast<ssize_t>(pattern.size());
+    const buffptr ptrs[2] = {seg.first, seg.second};
+    const ssize_t sizes[2] = {seg.first_size, seg.second_size};
+
+    ssize_t base = 0;
+    for (int i = 0; i < 2; ++i) {
+        ssize_t pos = start > base ? start - base : 0;
+        while (pos < sizes[i]) {
+            const char *hit = static_cast<const char*>(memchr(ptrs[i] + pos, pattern[0], sizes[i] - pos));
+            if (hit == nullptr) {
+                break;
+            }
+
+            ssize_t offset = base + (hit - ptrs[i]);
+            if (offset + pattern_size > seg.size) {
+                return -1;
+            }
+
+            ssize_t j = 1;
+            for (; j < pattern_size && seg.at(offset + j) == pattern[j]; ++j) {}
+            if (j == pattern_size) {
+                return offset;
+            }
+            pos = hit - ptrs[i] + 1;
+        }
+        base += sizes[i];
+    }
+
+    return -1;
+}
+
+// 没有找到 pattern 时，下次从可能的匹配开始位置继续扫描
+ssize_t
+next_scan_pos(ssize_t scan_pos, ssize_t data_size, ssize_t pattern_size)
+{
+    ssize_t pos = data_size - (pattern_size - 1);
+    return pos > scan_pos ? pos : scan_pos;
+}
+
+int
+hex_value(char ch)
+{
+    if (ch >= '0' && ch <= '9') {
+        return ch - '0';
+    } else if (ch >= 'a' && ch <= 'f') {
+        return ch - 'a' + 10;
+    } else if (ch >= 'A' && ch <= 'F') {
+        return ch - 'A' + 10;
+    }
+
+    return -1;
+}
+
+}
+
+FrameDecoder::FrameDecoder(void)
+: type_(FRAME_DELIMITER),
+  delimiter_("\n"),
+  field_size_(0),
+  big_endian_(true),
+  max_frame_size_(MAX_DATA_SIZE)
+{
+    this->reset();
+}
+
+FrameDecoder::FrameDecoder(const std::string &delimiter)
+: type_(FRAME_DELIMITER),
+  delimiter_("\n"),
+  field_size_(0),
+  big_endian_(true),
+  max_frame_size_(MAX_DATA_SIZE)
+{
+    // 分隔符为空时 set_delimiter 直接返回，保持默认的 "\n"
+    this->reset();
+    this->set_delimiter(delimiter);
+}
+
+FrameDecoder::~FrameDecoder(void)
+{
+
+}
+
+int
+FrameDecoder::set_delimiter(const std::string &delimiter)
+{
+    if (delimiter.empty()) {
+        return -1;
+    }
+
+    type_ = FRAME_DELIMITER;
+    delimiter_ = delimiter;
+    this->reset();
+
+    return 0;
+}
+
+int
+FrameDecoder::set_fixed_length(int field_size, bool big_endian)
+{
+    if (field_size != 1 && field_size != 2 && field_size != 4 && field_size != 8) {
+        return -1;
+    }
+
+    type_ = FRAME_FIXED_LENGTH;
+    field_size_ = field_size;
+    big_endian_ = big_endian;
+    this->reset();
+
+    return 0;
+}
+
+int
+FrameDecoder::set_varint_length(void)
+{
+    type_ = FRAME_VARINT_LENGTH;
+    this->reset();
+
+    return 0;
+}
+
+int
+FrameDecoder::set_http_chunked(void)
+{
+    type_ = FRAME_HTTP_CHUNKED;
+    this->reset();
+
+    return 0;
+}
+
+void
+FrameDecoder::reset(void)
+{
+    state_ = CHUNK_SIZE_LINE;
+    scan_pos_ = 0;
+    header_size_ = -1;
+    payload_size_ = 0;
+    line_start_ = 0;
+}
+
+FrameStatus
+FrameDecoder::decode(const ByteBuffer &buff, FrameView &frame)
+{
+    switch (type_)
+    {
+        case FRAME_DELIMITER:
+            return this->decode_delimiter(buff, frame);
+        case FRAME_FIXED_LENGTH:
+            return this->decode_fixed_length(buff, frame);
+        case FRAME_VARINT_LENGTH:
+            return this->decode_varint_length(buff, frame);
+        case FRAME_HTTP_CHUNKED:
+            return this->decode_http_chunked(buff, frame);
+        default:
+            break;
+    }
+
+    return FRAME_ERROR;
+}
+
+ssize_t
+FrameDecoder::consume(ByteBuffer &buff, const FrameView &frame)
+{
+    if (buff.update_read_pos(frame.frame_size) == -1) {
+        return -1;
+    }
+    this->reset();
+
+    return frame.frame_size;
+}
+
+FrameStatus
+FrameDecoder::read_frame(ByteBuffer &buff, ByteBuffer &payload)
+{
+    FrameView frame;
+    FrameStatus ret = this->decode(buff, frame);
+    if (ret != FRAME_COMPLETE) {
+        return ret;
+    }
+
+    payload.write_bytes(frame.first, frame.first_size);
+    payload.write_bytes(frame.second, frame.second_size);
+    this->consume(buff, frame);
+
+    return FRAME_COMPLETE;
+}
+
+FrameStatus
+FrameDecoder::decode_delimiter(const ByteBuffer &buff, FrameView &frame)
+{
+    Segments seg(buff);
+    ssize_t pos = find_bytes(seg, scan_pos_, delimiter_);
+    if (pos < 0) {
+        scan_pos_ = next_scan_pos(scan_pos_, seg.size, static_cast<ssize_t>(delimiter_.size()));
+        return scan_pos_ > max_frame_size_ ? FRAME_ERROR : FRAME_NEED_MORE;
+    }
+
+    if (pos > max_frame_size_) {
+        return FRAME_ERROR;
+    }
+    this->make_view(buff, 0, pos, pos + static_cast<ssize_t>(delimiter_.size()), frame);
+
+    return FRAME_COMPLETE;
+}
+
+FrameStatus
+FrameDecoder::decode_fixed_length(const ByteBuffer &buff, FrameView &frame)
+{
+    if (header_size_ < 0) {
+        Segments seg(buff);
+        if (seg.size < field_size_) {
+            return FRAME_NEED_MORE;
+        }
+
+        uint64_t size = 0;
+        for (int i = 0; i < field_size_; ++i) {
+            uint64_t byte = static_cast<uint8_t>(seg.at(i));
+            if (big_endian_) {
+                size = (size << 8) | byte;
+            } else {
+                size |= byte << (8 * i);
+            }
+        }
+
+        if (size > static_cast<uint64_t>(max_frame_size_)) {
+            return FRAME_ERROR;
+        }
+        header_size_ = field_size_;
+        payload_size_ = static_cast<ssize_t>(size);
+    }
+
+    return this->check_payload(buff, frame);
+}
+
+FrameStatus
+FrameDecoder::decode_varint_length(const ByteBuffer &buff, FrameView &frame)
+{
+    if (header_size_ < 0) {
+        Segments seg(buff);
+        uint64_t size = 0;
+        int i = 0;
+        for (; i < 10; ++i) {
+            if (i >= seg.size) {
+                return FRAME_NEED_MORE;
+            }
+
+            uint8_t byte = static_cast<uint8_t>(seg.at(i));
+            size |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+
+        if (i == 10 || size > static_cast<uint64_t>(max_frame_size_)) {
+            return FRAME_ERROR;
+        }
+        header_size_ = i + 1;
+        payload_size_ = static_cast<ssize_t>(size);
+    }
+
+    return this->check_payload(buff, frame);
+}
+
+FrameStatus
+FrameDecoder::decode_http_chunked(const ByteBuffer &buff, FrameView &frame)
+{
+    static const std::string crlf = "\r\n";
+    Segments seg(buff);
+
+    if (state_ == CHUNK_SIZE_LINE) {
+        ssize_t pos = find_bytes(seg, scan_pos_, crlf);
+        if (pos < 0) {
+            scan_pos_ = next_scan_pos(scan_pos_, seg.size, 2);
+            return scan_pos_ > MAX_CHUNK_LINE_SIZE ? FRAME_ERROR : FRAME_NEED_MORE;
+        }
+
+        // chunk 大小是十六进制，后面可能跟着 ";" 开始的扩展字段
+        ssize_t size = 0, i = 0;
+        for (; i < pos; ++i) {
+            int val = hex_value(seg.at(i));
+            if (val < 0) {
+                break;
+            }
+            size = size * 16 + val;
+            if (size > max_frame_size_) {
+                return FRAME_ERROR;
+            }
+        }
+
+        char ch = (i < pos ? seg.at(i) : ';');
+        if (i == 0 || (ch != ';' && ch != ' ' && ch != '\t')) {
+            return FRAME_ERROR;
+        }
+
+        header_size_ = pos + 2;
+        payload_size_ = size;
+        if (size == 0) {
+            state_ = CHUNK_TRAILER;
+            line_start_ = header_size_;
+            scan_pos_ = header_size_;
+        } else {
+            state_ = CHUNK_DATA;
+        }
+    }
+
+    if (state_ == CHUNK_DATA) {
+        ssize_t frame_size = header_size_ + payload_size_ + 2;
+        if (seg.size < frame_size) {
+            return FRAME_NEED_MORE;
+        }
+
+        if (seg.at(frame_size - 2) != '\r' || seg.at(frame_size - 1) != '\n') {
+            return FRAME_ERROR;
+        }
+        this->make_view(buff, header_size_, payload_size_, frame_size, frame);
+
+        return FRAME_COMPLETE;
+    }
+
+    // 跳过 trailer，直到遇到空行，trailer 的长度也受 max_frame_size_ 限制
+    while (true) {
+        ssize_t pos = find_bytes(seg, scan_pos_, crlf);
+        if (pos < 0) {
+            scan_pos_ = next_scan_pos(scan_pos_, seg.size, 2);
+            return scan_pos_ > max_frame_size_ ? FRAME_ERROR : FRAME_NEED_MORE;
+        }
+        if (pos > max_frame_size_) {
+            return FRAME_ERROR;
+        }
+
+        if (pos == line_start_) {
+            this->make_view(buff, header_size_, 0, pos + 2, frame);
+            return FRAME_COMPLETE;
+        }
+        line_start_ = pos + 2;
+        scan_pos_ = line_start_;
+    }
+
+    return FRAME_ERROR;
+}
+
+FrameStatus
+FrameDecoder::check_payload(const ByteBuffer &buff, FrameView &frame)
+{
+    ssize_t frame_size = header_size_ + payload_size_;
+    if (buff.data_size() < frame_size) {
+        return FRAME_NEED_MORE;
+    }
+    this->make_view(buff, header_size_, payload_size_, frame_size, frame);
+
+    return FRAME_COMPLETE;
+}
+
+void
+FrameDecoder::make_view(const ByteBuffer &buff, ssize_t offset, ssize_t size, ssize_t frame_size, FrameView &frame)
+{
+    Segments seg(buff);
+
+    frame.offset = offset;
+    frame.size = size;
+    frame.frame_size = frame_size;
+    frame.first = nullptr;
+    frame.first_size = 0;
+    frame.second = nullptr;
+    frame.second_size = 0;
+    if (size <= 0) {
+        return;
+    }
+
+    if (offset < seg.first_size) {
+        frame.first = seg.first + offset;
+        frame.first_size = (seg.first_size - offset < size ? seg.first_size - offset : size);
+        if (frame.first_size < size) {
+            frame.second = seg.second;
+            frame.second_size = size - frame.first_size;
+        }
+    } else {
+        frame.first = seg.second + (offset - seg.first_size);
+        frame.first_size = size;
+    }
+}
+
+}
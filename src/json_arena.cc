@@ -0,0 +1,120 @@
+#include "json_arena.h"
+
+namespace basic {
+
+JsonArena::JsonArena(std::size_t block_size)
+: head_(nullptr),
+  pos_(nullptr),
+  end_(nullptr),
+  block_size_(block_size > 0 ? block_size : JSON_ARENA_BLOCK_SIZE),
+  used_(0),
+  capacity_(0),
+  refs_(1)
+{
+}
+
+JsonArena::~JsonArena(void)
+{
+    while (head_ != nullptr) {
+        Block *next = head_->next;
+        ::operator delete(head_);
+        head_ = next;
+    }
+}
+
+void*
+JsonArena::allocate(std::size_t size, std::size_t align)
+{
+    // align 是 2 的幂
+    char *ptr = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(pos_) + align - 1) & ~(static_cast<uintptr_t>(align) - 1));
+    if (pos_ == nullptr || ptr + size > end_) {
+        return this->allocate_block(size, align);
+    }
+
+    pos_ = ptr + size;
+    used_ += size;
+    return ptr;
+}
+
+void
+JsonArena::reset(void)
+{
+    used_ = 0;
+    if (head_ == nullptr) {
+        return ;
+    }
+
+    if (head_->next == nullptr) {
+        pos_ = reinterpret_cast<char*>(head_ + 1);
+        end_ = pos_ + head_->size;
+        return ;
+    }
+
+    // 有多个内存块时全部释放，下次分配一个能容纳所有内容的内存块
+    if (block_size_ < capacity_) {
+        block_size_ = capacity_;
+    }
+    while (head_ != nullptr) {
+        Block *next = head_->next;
+        ::operator delete(head_);
+        head_ = next;
+    }
+    pos_ = nullptr;
+    end_ = nullptr;
+    capacity_ = 0;
+}
+
+bool
+JsonArena::owns(const void *ptr) const
+{
+    const char *pos = static_cast<const char*>(ptr);
+    for (const Block *block = head_; block != nullptr; block = block->next) {
+        const char *start = reinterpret_cast<const char*>(block + 1);
+        if (pos >= start && pos < start + block->size) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void*
+JsonArena::allocate_block(std::size_t size, std::size_t align)
+{
+    std::size_t need = size + align;
+    if (need > block_size_ / 4) {
+        // 较大的分配单独使用一个内存块，当前内存块剩余的空间继续使用
+        Block *block = static_cast<Block*>(::operator new(sizeof(Block) + need));
+        block->size = need;
+        capacity_ += need;
+        if (head_ == nullptr) {
+            block->next = nullptr;
+            head_ = block;
+            pos_ = end_ = reinterpret_cast<char*>(block + 1) + need;
+        } else {
+            block->next = head_->next;
+            head_->next = block;
+        }
+
+        char *ptr = reinterpret_cast<char*>(block + 1);
+        ptr = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(ptr) + align - 1) & ~(static_cast<uintptr_t>(align) - 1));
+        used_ += size;
+        return ptr;
+    }
+
+    Block *block = static_cast<Block*>(::operator new(sizeof(Block) + block_size_));
+    block->size = block_size_;
+    block->next = head_;
+    head_ = block;
+    capacity_ += block_size_;
+    pos_ = reinterpret_cast<char*>(block + 1);
+    end_ = pos_ + block_size_;
+
+    if (block_size_ < JSON_ARENA_MAX_BLOCK_SIZE) {
+        block_size_ *= 2;
+    }
+
+    return this->allocate(size, align);
+}
+
+}
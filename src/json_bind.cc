@@ -0,0 +1,210 @@
+#include "json_bind.h"
+#include "json_parser.h"
+#include "json_writer.h"
+#include "lazy_json.h"
+#include "debug.h"
+
+namespace basic {
+
+JsonBindReader::JsonBindReader(const char *data, ssize_t size)
+: begin_(data),
+  pos_(data),
+  end_(data + (size > 0 ? size : 0))
+{
+}
+
+JsonBindReader::~JsonBindReader(void)
+{
+}
+
+char
+JsonBindReader::peek(void)
+{
+    while (pos_ < end_) {
+        char ch = *pos_;
+        if (ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t') {
+            ++pos_;
+        } else if (ch == '/' && pos_ + 1 < end_ && pos_[1] == '/') {
+            const char *line_end = static_cast<const char*>(memchr(pos_, '\n', end_ - pos_));
+            pos_ = (line_end == nullptr ? end_ : line_end + 1);
+        } else {
+            return ch;
+        }
+    }
+
+    return '\0';
+}
+
+bool
+JsonBindReader::read_null(void)
+{
+    if (this->peek() != 'n') {
+        return false;
+    }
+    if (end_ - pos_ < 4 || memcmp(pos_, "null", 4) != 0) {
+        this->throw_error("Expected null");
+    }
+    pos_ += 4;
+
+    return true;
+}
+
+bool
+JsonBindReader::read_bool(void)
+{
+    char ch = this->peek();
+    if (ch == 't' && end_ - pos_ >= 4 && memcmp(pos_, "true", 4) == 0) {
+        pos_ += 4;
+        return true;
+    }
+    if (ch == 'f' && end_ - pos_ >= 5 && memcmp(pos_, "false", 5) == 0) {
+        pos_ += 5;
+        return false;
+    }
+    this->throw_error("Expected true or false");
+}
+
+void
+JsonBindReader::read_number(JsonNumberLiteral &number)
+{
+    char ch = this->peek();
+    if (!((ch >= '0' && ch <= '9') || ch == '-' || ch == '+')) {
+        this->throw_error("Expected number");
+    }
+
+    const char *error = nullptr;
+    const char *next = parse_json_number(pos_, end_, number, &error);
+    if (next == nullptr) {
+        this->throw_error(error);
+    }
+    pos_ = next;
+}
+
+void
+JsonBindReader::read_string(const char *&str, ssize_t &size)
+{
+    if (this->peek() != '"') {
+        this->throw_error("Expected string");
+    }
+
+    const char *next = LazyJsonValue(pos_, end_).skip();
+    str = pos_ + 1;
+    size = next - pos_ - 2;
+    pos_ = next;
+}
+
+void
+JsonBindReader::read_value(JsonValue &value)
+{
+    if (this->peek() == '\0') {
+        this->throw_error("Unexpected end of json text");
+    }
+
+    // 先找到值的结尾，只解析这一段文本
+    const char *start = pos_;
+    this->skip_value();
+    JsonParser parser(start, pos_ - start);
+    parser.parse(value);
+}
+
+void
+JsonBindReader::skip_value(void)
+{
+    if (this->peek() == '\0') {
+        this->throw_error("Unexpected end of json text");
+    }
+
+    pos_ = LazyJsonValue(pos_, end_).skip();
+}
+
+void
+JsonBindReader::begin_object(void)
+{
+    if (this->peek() != '{') {
+        this->throw_error("Expected object");
+    }
+    ++pos_;
+}
+
+bool
+JsonBindReader::next_member(bool &first, const char *&key, ssize_t &key_size)
+{
+    char ch = this->peek();
+    if (ch == '}') {
+        ++pos_;
+        return false;
+    }
+    if (!first) {
+        if (ch != ',') {
+            this->throw_error("Expected ',' or '}' in object");
+        }
+        ++pos_;
+        ch = this->peek();
+    }
+    first = false;
+
+    if (ch != '"') {
+        this->throw_error("Object key must be a string");
+    }
+    this->read_string(key, key_size);
+    this->expect(':');
+
+    return true;
+}
+
+void
+JsonBindReader::begin_array(void)
+{
+    if (this->peek() != '[') {
+        this->throw_error("Expected array");
+    }
+    ++pos_;
+}
+
+bool
+JsonBindReader::next_element(bool &first)
+{
+    char ch = this->peek();
+    if (ch == ']') {
+        ++pos_;
+        return false;
+    }
+    if (!first) {
+        if (ch != ',') {
+            this->throw_error("Expected ',' or ']' in array");
+        }
+        ++pos_;
+    }
+    first = false;
+
+    return true;
+}
+
+void
+JsonBindReader::expect(char ch)
+{
+    if (this->peek() != ch) {
+        std::string what = std::string("Expected '") + ch + "'";
+        this->throw_error(what.c_str());
+    }
+    ++pos_;
+}
+
+void
+JsonBindReader::throw_error(const char *what) const
+{
+    char ch = (pos_ < end_ ? *pos_ : ' ');
+    throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonBind: %s at offset %ld: %c\n%s\n", what, static_cast<long>(pos_ - begin_), ch, dump_stack().c_str()));
+}
+
+//////////////////////////////////////////////////////////////
+
+void
+JsonCodec<JsonValue>::encode(const JsonValue &value, std::string &out)
+{
+    JsonWriter writer(out);
+    writer.set_estimate_size(false);
+    writer.write(value);
+}
+
+}
@@ -0,0 +1,795 @@
+#include "json_cbor.h"
+#include "debug.h"
+
+#include <cmath>
+#include <cfloat>
+
+namespace basic {
+
+namespace {
+
+enum CborMajor {
+    CBOR_UNSIGNED = 0,
+    CBOR_NEGATIVE = 1,
+    CBOR_BYTES = 2,
+    CBOR_TEXT = 3,
+    CBOR_ARRAY = 4,
+    CBOR_MAP = 5,
+    CBOR_TAG = 6,
+    CBOR_SIMPLE = 7
+};
+
+const uint8_t CBOR_INDEFINITE = 31;
+const uint8_t CBOR_BREAK = 0xff;
+
+inline void
+store_big_endian(uint64_t value, int size, char *buf)
+{
+    for (int i = size - 1; i >= 0; --i) {
+        buf[i] = static_cast<char>(value & 0xff);
+        value >>= 8;
+    }
+}
+
+inline uint64_t
+load_big_endian(const uint8_t *buf, int size)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < size; ++i) {
+        value = (value << 8) | buf[i];
+    }
+    return value;
+}
+
+// 数据项开头(类型和参数)的字节数，保留的参数返回 0
+inline int
+head_length(uint8_t info)
+{
+    if (info < 24 || info == CBOR_INDEFINITE) {
+        return 1;
+    }
+    switch (info)
+    {
+        case 24: return 2;
+        case 25: return 3;
+        case 26: return 5;
+        case 27: return 9;
+        default: break;
+    }
+    return 0;
+}
+
+inline uint64_t
+head_argument(const uint8_t *head)
+{
+    uint8_t info = head[0] & 0x1f;
+    if (info < 24) {
+        return info;
+    }
+    if (info == CBOR_INDEFINITE) {
+        return 0;
+    }
+    return load_big_endian(head + 1, head_length(info) - 1);
+}
+
+double
+half_to_double(uint16_t half)
+{
+    int exponent = (half >> 10) & 0x1f;
+    int mantissa = half & 0x3ff;
+    double value = 0;
+    if (exponent == 0) {
+        value = std::ldexp(mantissa, -24);
+    } else if (exponent != 31) {
+        value = std::ldexp(mantissa + 1024, exponent - 25);
+    } else {
+        value = (mantissa == 0 ? INFINITY : NAN);
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+inline bool
+read_hex4(const char *pos, const char *end, uint32_t &code)
+{
+    if (end - pos < 4) {
+        return false;
+    }
+    code = 0;
+    for (int i = 0; i < 4; ++i) {
+        char ch = pos[i];
+        code <<= 4;
+        if (ch >= '0' && ch <= '9') {
+            code |= ch - '0';
+        } else if (ch >= 'a' && ch <= 'f') {
+            code |= ch - 'a' + 10;
+        } else if (ch >= 'A' && ch <= 'F') {
+            code |= ch - 'A' + 10;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+append_utf8(uint32_t code, std::string &out)
+{
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xc0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xe0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (code & 0x3f));
+    } else {
+        out += static_cast<char>(0xf0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (code & 0x3f));
+    }
+}
+
+// 去掉 json 字符串中的转义，不合法的转义按原样保留
+void
+unescape_text(const char *str, const char *end, std::string &out)
+{
+    out.clear();
+    while (str < end) {
+        const char *slash = static_cast<const char*>(memchr(str, '\\', end - str));
+        if (slash == nullptr || slash + 1 >= end) {
+            out.append(str, end - str);
+            return ;
+        }
+        out.append(str, slash - str);
+        str = slash + 2;
+
+        switch (slash[1])
+        {
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case '"': case '\\': case '/':
+                out += slash[1];
+                break;
+            case 'u': {
+                uint32_t code = 0;
+                if (!read_hex4(str, end, code)) {
+                    out.append(slash, 2);
+                    break;
+                }
+                str += 4;
+                // 代理对合并为一个字符
+                uint32_t low = 0;
+                if (code >= 0xd800 && code < 0xdc00 && end - str >= 6 && str[0] == '\\' && str[1] == 'u'
+                        && read_hex4(str + 2, end, low) && low >= 0xdc00 && low < 0xe000) {
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    str += 6;
+                }
+                append_utf8(code, out);
+            } break;
+            default:
+                out.append(slash, 2);
+                break;
+        }
+    }
+}
+
+// 对 '"'、'\' 和控制字符转义，不需要转义时返回 false
+bool
+escape_text(const char *str, ssize_t size, std::string &out)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    ssize_t i = 0;
+    for (; i < size; ++i) {
+        uint8_t ch = static_cast<uint8_t>(str[i]);
+        if (ch < 0x20 || ch == '"' || ch == '\\') {
+            break;
+        }
+    }
+    if (i == size) {
+        return false;
+    }
+
+    out.assign(str, i);
+    for (; i < size; ++i) {
+        uint8_t ch = static_cast<uint8_t>(str[i]);
+        switch (ch)
+        {
+            case '"': out.append("\\\"", 2); break;
+            case '\\': out.append("\\\\", 2); break;
+            case '\b': out.append("\\b", 2); break;
+            case '\f': out.append("\\f", 2); break;
+            case '\n': out.append("\\n", 2); break;
+            case '\r': out.append("\\r", 2); break;
+            case '\t': out.append("\\t", 2); break;
+            default:
+                if (ch < 0x20) {
+                    char buf[6] = {'\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 0xf]};
+                    out.append(buf, 6);
+                } else {
+                    out += static_cast<char>(ch);
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+}
+
+CborEncoder::CborEncoder(std::string &out)
+: out_(out)
+{
+}
+
+CborEncoder::~CborEncoder(void)
+{
+}
+
+void
+CborEncoder::encode(const JsonValue &value)
+{
+    switch (value.type_)
+    {
+        case JSON_OBJECT_TYPE: {
+            const JsonObject &object = *value.object_;
+            this->write_head(CBOR_MAP, object.value_.size());
+            for (auto iter = object.value_.begin(); iter != object.value_.end(); ++iter) {
+                this->write_text(iter->first.data(), iter->first.size());
+                this->encode(iter->second);
+            }
+        } break;
+        case JSON_ARRAY_TYPE: {
+            const JsonArray &array = *value.array_;
+            this->write_head(CBOR_ARRAY, array.value_.size());
+            for (auto iter = array.value_.begin(); iter != array.value_.end(); ++iter) {
+                this->encode(*iter);
+            }
+        } break;
+        case JSON_STRING_TYPE:
+            this->write_text(value.string_, value.size_);
+            break;
+        case JSON_NUMBER_TYPE: {
+            if (value.kind_ == JSON_NUMBER_INT) {
+                this->integer(value.int_);
+            } else if (value.kind_ == JSON_NUMBER_UINT) {
+                this->unsigned_integer(value.uint_);
+            } else {
+                this->write_double(value.number_);
+            }
+        } break;
+        case JSON_BOOL_TYPE:
+            this->boolean(value.bool_);
+            break;
+        default:
+            this->null();
+            break;
+    }
+}
+
+bool
+CborEncoder::start_object(void)
+{
+    out_ += static_cast<char>((CBOR_MAP << 5) | CBOR_INDEFINITE);
+    return true;
+}
+
+bool
+CborEncoder::key(const char *str, ssize_t size)
+{
+    this->write_text(str, size);
+    return true;
+}
+
+bool
+CborEncoder::end_object(void)
+{
+    out_ += static_cast<char>(CBOR_BREAK);
+    return true;
+}
+
+bool
+CborEncoder::start_array(void)
+{
+    out_ += static_cast<char>((CBOR_ARRAY << 5) | CBOR_INDEFINITE);
+    return true;
+}
+
+bool
+CborEncoder::end_array(void)
+{
+    out_ += static_cast<char>(CBOR_BREAK);
+    return true;
+}
+
+bool
+CborEncoder::string(const char *str, ssize_t size)
+{
+    this->write_text(str, size);
+    return true;
+}
+
+bool
+CborEncoder::number(double value)
+{
+    this->write_double(value);
+    return true;
+}
+
+bool
+CborEncoder::integer(int64_t value)
+{
+    if (value >= 0) {
+        this->write_head(CBOR_UNSIGNED, static_cast<uint64_t>(value));
+    } else {
+        // 负数保存 -1 - value
+        this->write_head(CBOR_NEGATIVE, static_cast<uint64_t>(-(value + 1)));
+    }
+    return true;
+}
+
+bool
+CborEncoder::unsigned_integer(uint64_t value)
+{
+    this->write_head(CBOR_UNSIGNED, value);
+    return true;
+}
+
+bool
+CborEncoder::boolean(bool value)
+{
+    out_ += static_cast<char>((CBOR_SIMPLE << 5) | (value ? 21 : 20));
+    return true;
+}
+
+bool
+CborEncoder::null(void)
+{
+    out_ += static_cast<char>((CBOR_SIMPLE << 5) | 22);
+    return true;
+}
+
+void
+CborEncoder::write_head(uint8_t major, uint64_t value)
+{
+    char buf[9];
+    int size = 0;
+    uint8_t head = static_cast<uint8_t>(major << 5);
+    if (value < 24) {
+        buf[0] = static_cast<char>(head | value);
+        size = 1;
+    } else if (value <= 0xff) {
+        buf[0] = static_cast<char>(head | 24);
+        size = 2;
+    } else if (value <= 0xffff) {
+        buf[0] = static_cast<char>(head | 25);
+        size = 3;
+    } else if (value <= 0xffffffffULL) {
+        buf[0] = static_cast<char>(head | 26);
+        size = 5;
+    } else {
+        buf[0] = static_cast<char>(head | 27);
+        size = 9;
+    }
+    if (size > 1) {
+        store_big_endian(value, size - 1, buf + 1);
+    }
+    out_.append(buf, size);
+}
+
+void
+CborEncoder::write_text(const char *str, ssize_t size)
+{
+    if (memchr(str, '\\', size) == nullptr) {
+        this->write_head(CBOR_TEXT, static_cast<uint64_t>(size));
+        out_.append(str, size);
+        return ;
+    }
+
+    unescape_text(str, str + size, unescaped_);
+    this->write_head(CBOR_TEXT, unescaped_.size());
+    out_.append(unescaped_);
+}
+
+void
+CborEncoder::write_double(double value)
+{
+    char buf[9];
+    // 可以无损转换为 float 时只用 4 个字节
+    if (std::isinf(value) || (std::fabs(value) <= FLT_MAX && static_cast<double>(static_cast<float>(value)) == value)) {
+        float f = static_cast<float>(value);
+        uint32_t bits = 0;
+        memcpy(&bits, &f, sizeof(bits));
+        buf[0] = static_cast<char>((CBOR_SIMPLE << 5) | 26);
+        store_big_endian(bits, 4, buf + 1);
+        out_.append(buf, 5);
+        return ;
+    }
+
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    buf[0] = static_cast<char>((CBOR_SIMPLE << 5) | 27);
+    store_big_endian(bits, 8, buf + 1);
+    out_.append(buf, 9);
+}
+
+//////////////////////////////////////////////////////////////
+
+CborStreamParser::CborStreamParser(JsonHandler &handler)
+: handler_(handler)
+{
+    this->reset();
+}
+
+CborStreamParser::~CborStreamParser(void)
+{
+}
+
+void
+CborStreamParser::reset(void)
+{
+    state_ = STATE_HEAD;
+    chunk_ = nullptr;
+    consumed_ = 0;
+    stack_.clear();
+    head_size_ = 0;
+    head_need_ = 0;
+    buffer_.clear();
+    string_left_ = 0;
+    chunked_ = false;
+}
+
+ssize_t
+CborStreamParser::feed(const char *data, ssize_t size)
+{
+    if (state_ == STATE_STOPPED || state_ == STATE_ERROR) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"CborStreamParser: parsing was stopped or failed, need reset!\n%s\n", dump_stack().c_str()));
+    }
+
+    chunk_ = data;
+    const char *pos = data;
+    const char *end = data + (size > 0 ? size : 0);
+    bool keep_going = true;
+    try {
+        while (keep_going && pos < end && state_ != STATE_DONE) {
+            switch (state_)
+            {
+                case STATE_HEAD:
+                    keep_going = this->parse_head(pos, end);
+                    break;
+                case STATE_HEAD_PART: {
+                    int count = static_cast<int>(std::min<ssize_t>(head_need_ - head_size_, end - pos));
+                    memcpy(head_ + head_size_, pos, count);
+                    head_size_ += count;
+                    pos += count;
+                    if (head_size_ == head_need_) {
+                        state_ = STATE_HEAD;
+                        keep_going = this->process_head(head_[0], head_argument(head_), pos, end);
+                    }
+                } break;
+                default:
+                    keep_going = this->parse_string(pos, end);
+                    break;
+            }
+        }
+    } catch (...) {
+        state_ = STATE_ERROR;
+        throw;
+    }
+
+    consumed_ += pos - data;
+    if (!keep_going) {
+        state_ = STATE_STOPPED;
+        return -1;
+    }
+
+    return pos - data;
+}
+
+ssize_t
+CborStreamParser::feed(ByteBuffer &buff)
+{
+    buffptr first = nullptr, second = nullptr;
+    ssize_t first_size = 0, second_size = 0;
+    buff.get_read_segments(first, first_size, second, second_size);
+
+    ssize_t old_consumed = consumed_;
+    ssize_t ret = this->feed(first, first_size);
+    if (ret == first_size && second_size > 0) {
+        ret = this->feed(second, second_size);
+    }
+    buff.update_read_pos(consumed_ - old_consumed);
+
+    return ret == -1 ? -1 : consumed_ - old_consumed;
+}
+
+bool
+CborStreamParser::parse_head(const char *&pos, const char *end)
+{
+    const uint8_t *head = reinterpret_cast<const uint8_t*>(pos);
+    int need = head_length(head[0] & 0x1f);
+    if (need == 0) {
+        this->throw_error("Reserved additional information", pos);
+    }
+
+    if (end - pos < need) {
+        head_size_ = static_cast<int>(end - pos);
+        head_need_ = need;
+        memcpy(head_, pos, head_size_);
+        state_ = STATE_HEAD_PART;
+        pos = end;
+        return true;
+    }
+
+    pos += need;
+    return this->process_head(head[0], head_argument(head), pos, end);
+}
+
+bool
+CborStreamParser::process_head(uint8_t head, uint64_t value, const char *&pos, const char *end)
+{
+    uint8_t major = head >> 5;
+    uint8_t info = head & 0x1f;
+
+    // 不定长文本字符串由定长的文本字符串分块组成
+    if (chunked_) {
+        if (head == CBOR_BREAK) {
+            chunked_ = false;
+            return this->emit_text(buffer_.data(), buffer_.size());
+        }
+        if (major != CBOR_TEXT || info == CBOR_INDEFINITE) {
+            this->throw_error("Invalid chunk in indefinite-length string", pos);
+        }
+        string_left_ = value;
+        state_ = STATE_STRING;
+        return this->parse_string(pos, end);
+    }
+
+    if (this->expect_key() && major != CBOR_TEXT && major != CBOR_TAG && head != CBOR_BREAK) {
+        this->throw_error("Map key must be a text string", pos);
+    }
+
+    switch (major)
+    {
+        case CBOR_UNSIGNED:
+            if (value <= static_cast<uint64_t>(INT64_MAX)) {
+                return handler_.integer(static_cast<int64_t>(value)) && this->value_done();
+            }
+            return handler_.unsigned_integer(value) && this->value_done();
+        case CBOR_NEGATIVE:
+            if (value <= static_cast<uint64_t>(INT64_MAX)) {
+                return handler_.integer(-1 - static_cast<int64_t>(value)) && this->value_done();
+            }
+            return handler_.number(-1.0 - static_cast<double>(value)) && this->value_done();
+        case CBOR_BYTES:
+            this->throw_error("Byte string can't be represented in json", pos);
+            return false;
+        case CBOR_TEXT:
+            if (info == CBOR_INDEFINITE) {
+                chunked_ = true;
+                buffer_.clear();
+                return true;
+            }
+            if (value <= static_cast<uint64_t>(end - pos)) {
+                const char *str = pos;
+                pos += value;
+                return this->emit_text(str, static_cast<ssize_t>(value));
+            }
+            buffer_.clear();
+            string_left_ = value;
+            state_ = STATE_STRING;
+            return this->parse_string(pos, end);
+        case CBOR_ARRAY:
+        case CBOR_MAP:
+            return this->start_container(major == CBOR_MAP, info, value);
+        case CBOR_TAG:
+            // 忽略标签，接下来的数据项是它的值
+            return true;
+        default:
+            break;
+    }
+
+    switch (info)
+    {
+        case 20:
+        case 21:
+            return handler_.boolean(info == 21) && this->value_done();
+        case 22:
+        case 23:
+            return handler_.null() && this->value_done();
+        case 25:
+            return handler_.number(half_to_double(static_cast<uint16_t>(value))) && this->value_done();
+        case 26: {
+            uint32_t bits = static_cast<uint32_t>(value);
+            float f = 0;
+            memcpy(&f, &bits, sizeof(f));
+            return handler_.number(f) && this->value_done();
+        }
+        case 27: {
+            double d = 0;
+            memcpy(&d, &value, sizeof(d));
+            return handler_.number(d) && this->value_done();
+        }
+        case CBOR_INDEFINITE:
+            if (stack_.empty() || !stack_.back().indefinite || (stack_.back().is_map && !stack_.back().expect_key)) {
+                this->throw_error("Unexpected break", pos);
+            }
+            return this->emit_break();
+        default:
+            break;
+    }
+
+    this->throw_error("Simple value can't be represented in json", pos);
+    return false;
+}
+
+bool
+CborStreamParser::parse_string(const char *&pos, const char *end)
+{
+    std::size_t count = static_cast<std::size_t>(std::min<uint64_t>(string_left_, static_cast<uint64_t>(end - pos)));
+    buffer_.append(pos, count);
+    pos += count;
+    string_left_ -= count;
+    if (string_left_ > 0) {
+        return true;
+    }
+
+    state_ = STATE_HEAD;
+    if (chunked_) {
+        // 等待下一个分块
+        return true;
+    }
+    return this->emit_text(buffer_.data(), buffer_.size());
+}
+
+bool
+CborStreamParser::emit_text(const char *str, ssize_t size)
+{
+    if (escape_text(str, size, escaped_)) {
+        str = escaped_.data();
+        size = escaped_.size();
+    }
+
+    if (this->expect_key()) {
+        stack_.back().expect_key = false;
+        return handler_.key(str, size);
+    }
+    return handler_.string(str, size) && this->value_done();
+}
+
+bool
+CborStreamParser::start_container(bool is_map, uint8_t info, uint64_t value)
+{
+    if (!(is_map ? handler_.start_object() : handler_.start_array())) {
+        return false;
+    }
+    if (info != CBOR_INDEFINITE && value == 0) {
+        return (is_map ? handler_.end_object() : handler_.end_array()) && this->value_done();
+    }
+
+    Frame frame;
+    frame.remaining = value;
+    frame.indefinite = (info == CBOR_INDEFINITE);
+    frame.is_map = is_map;
+    frame.expect_key = is_map;
+    stack_.push_back(frame);
+
+    return true;
+}
+
+bool
+CborStreamParser::emit_break(void)
+{
+    bool is_map = stack_.back().is_map;
+    stack_.pop_back();
+
+    return (is_map ? handler_.end_object() : handler_.end_array()) && this->value_done();
+}
+
+bool
+CborStreamParser::value_done(void)
+{
+    while (!stack_.empty()) {
+        Frame &frame = stack_.back();
+        frame.expect_key = frame.is_map;
+        if (frame.indefinite || --frame.remaining > 0) {
+            return true;
+        }
+
+        bool is_map = frame.is_map;
+        stack_.pop_back();
+        if (!(is_map ? handler_.end_object() : handler_.end_array())) {
+            return false;
+        }
+    }
+
+    state_ = STATE_DONE;
+    return true;
+}
+
+void
+CborStreamParser::throw_error(const char *what, const char *pos)
+{
+    long offset = static_cast<long>(consumed_ + (pos - chunk_));
+    throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"CborStreamParser: %s at offset %ld\n%s\n", what, offset, dump_stack().c_str()));
+}
+
+//////////////////////////////////////////////////////////////
+
+ssize_t
+cbor_encode(const JsonValue &value, std::string &out)
+{
+    std::size_t old_size = out.size();
+    CborEncoder encoder(out);
+    encoder.encode(value);
+
+    return static_cast<ssize_t>(out.size() - old_size);
+}
+
+ssize_t
+cbor_encode(const JsonValue &value, ByteBuffer &out)
+{
+    std::string data;
+    cbor_encode(value, data);
+
+    return out.write_bytes(data.data(), data.size());
+}
+
+ssize_t
+cbor_decode(const char *data, ssize_t size, JsonValue &value)
+{
+    JsonDomBuilder builder(value);
+    CborStreamParser parser(builder);
+    parser.feed(data, size);
+    if (!parser.is_complete()) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"CborStreamParser: incomplete CBOR data. [size: %ld]\n%s\n", static_cast<long>(size), dump_stack().c_str()));
+    }
+
+    return parser.consumed();
+}
+
+ssize_t
+cbor_decode(const ByteBuffer &data, JsonValue &value)
+{
+    buffptr first = nullptr, second = nullptr;
+    ssize_t first_size = 0, second_size = 0;
+    data.get_read_segments(first, first_size, second, second_size);
+
+    JsonDomBuilder builder(value);
+    CborStreamParser parser(builder);
+    if (parser.feed(first, first_size) == first_size && second_size > 0) {
+        parser.feed(second, second_size);
+    }
+    if (!parser.is_complete()) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"CborStreamParser: incomplete CBOR data. [size: %ld]\n%s\n", static_cast<long>(first_size + second_size), dump_stack().c_str()));
+    }
+
+    return parser.consumed();
+}
+
+ssize_t
+json_to_cbor(const char *data, ssize_t size, std::string &out)
+{
+    std::size_t old_size = out.size();
+    CborEncoder encoder(out);
+    JsonParser parser(data, size);
+    parser.parse_document(encoder);
+
+    return static_cast<ssize_t>(out.size() - old_size);
+}
+
+ssize_t
+json_to_cbor(const char *data, ssize_t size, ByteBuffer &out)
+{
+    std::string cbor;
+    json_to_cbor(data, size, cbor);
+
+    return out.write_bytes(cbor.data(), cbor.size());
+}
+
+}
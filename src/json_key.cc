@@ -0,0 +1,294 @@
+#include "json_key.h"
+#include "logger.h"
+#include "debug.h"
+
+namespace basic {
+
+JsonKey::JsonKey(void)
+: size_(0),
+  storage_(KEY_INLINE)
+{
+    buf_[0] = '\0';
+}
+
+JsonKey::JsonKey(const char *str, std::size_t size, JsonArena *arena)
+: size_(0),
+  storage_(KEY_INLINE)
+{
+    if (size > UINT32_MAX) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonKey: key is too long.[size: %lu]\n%s\n", static_cast<unsigned long>(size), dump_stack().c_str()));
+    }
+
+    char *data = buf_;
+    if (size > JSON_KEY_INLINE_SIZE) {
+        if (arena != nullptr) {
+            data = static_cast<char*>(arena->allocate(size + 1, 1));
+            storage_ = KEY_ARENA;
+        } else {
+            data = new char[size + 1];
+            storage_ = KEY_HEAP;
+        }
+        ptr_ = data;
+    }
+    memcpy(data, str, size);
+    data[size] = '\0';
+    size_ = static_cast<uint32_t>(size);
+}
+
+JsonKey::JsonKey(const std::string &str)
+: JsonKey(str.data(), str.size())
+{
+}
+
+JsonKey::JsonKey(const JsonKey &rhs)
+: size_(0),
+  storage_(KEY_INLINE)
+{
+    buf_[0] = '\0';
+    *this = rhs;
+}
+
+JsonKey::JsonKey(JsonKey &&rhs) noexcept
+: size_(0),
+  storage_(KEY_INLINE)
+{
+    this->take(rhs);
+}
+
+JsonKey::~JsonKey(void)
+{
+    this->release();
+}
+
+JsonKey&
+JsonKey::operator=(const JsonKey &rhs)
+{
+    if (this == &rhs) {
+        return *this;
+    }
+
+    // 驻留的 key 共享字符串，其他的复制到堆上
+    if (rhs.storage_ == KEY_INTERNED) {
+        this->release();
+        ptr_ = rhs.ptr_;
+        size_ = rhs.size_;
+        storage_ = KEY_INTERNED;
+    } else {
+        JsonKey tmp(rhs.data(), rhs.size_);
+        this->release();
+        this->take(tmp);
+    }
+
+    return *this;
+}
+
+JsonKey&
+JsonKey::operator=(JsonKey &&rhs) noexcept
+{
+    if (this != &rhs) {
+        this->release();
+        this->take(rhs);
+    }
+
+    return *this;
+}
+
+void
+JsonKey::release(void)
+{
+    if (storage_ == KEY_HEAP) {
+        delete[] ptr_;
+    }
+    buf_[0] = '\0';
+    size_ = 0;
+    storage_ = KEY_INLINE;
+}
+
+void
+JsonKey::take(JsonKey &rhs)
+{
+    memcpy(buf_, rhs.buf_, sizeof(buf_));
+    size_ = rhs.size_;
+    storage_ = rhs.storage_;
+    rhs.buf_[0] = '\0';
+    rhs.size_ = 0;
+    rhs.storage_ = KEY_INLINE;
+}
+
+std::size_t
+JsonKey::hash(void) const
+{
+    if (storage_ == KEY_INTERNED) {
+        return JsonKeyTable::get_entry(ptr_)->hash;
+    }
+
+    return hash_string(this->data(), size_);
+}
+
+std::size_t
+JsonKey::hash_string(const char *str, std::size_t size)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(str[i]);
+        hash *= 1099511628211ULL;
+    }
+
+    return static_cast<std::size_t>(hash);
+}
+
+bool
+JsonKey::operator==(const JsonKey &rhs) const
+{
+    // 同一个驻留表中的字符串只有一份
+    if (storage_ == KEY_INTERNED && rhs.storage_ == KEY_INTERNED) {
+        if (ptr_ == rhs.ptr_) {
+            return true;
+        }
+        if (JsonKeyTable::get_entry(ptr_)->table == JsonKeyTable::get_entry(rhs.ptr_)->table) {
+            return false;
+        }
+    }
+
+    return this->equals(rhs.data(), rhs.size_);
+}
+
+bool
+JsonKey::operator<(const JsonKey &rhs) const
+{
+    int ret = memcmp(this->data(), rhs.data(), std::min(size_, rhs.size_));
+    return ret < 0 || (ret == 0 && size_ < rhs.size_);
+}
+
+bool operator==(const JsonKey &lhs, const std::string &rhs) {return lhs.equals(rhs.data(), rhs.size());}
+bool operator==(const std::string &lhs, const JsonKey &rhs) {return rhs.equals(lhs.data(), lhs.size());}
+bool operator!=(const JsonKey &lhs, const std::string &rhs) {return !lhs.equals(rhs.data(), rhs.size());}
+bool operator!=(const std::string &lhs, const JsonKey &rhs) {return !rhs.equals(lhs.data(), lhs.size());}
+
+std::ostream& operator<<(std::ostream &os, const JsonKey &key)
+{
+    os.write(key.data(), key.size());
+    return os;
+}
+
+///////////////////////////////////////////////////////////
+
+JsonKeyTable::JsonKeyTable(void)
+{
+    for (int i = 0; i < JSON_KEY_TABLE_SHARDS; ++i) {
+        shards_[i].count = 0;
+        shards_[i].memory = 0;
+    }
+}
+
+JsonKeyTable::~JsonKeyTable(void)
+{
+    for (int i = 0; i < JSON_KEY_TABLE_SHARDS; ++i) {
+        std::vector<Entry*> &slots = shards_[i].slots;
+        for (std::size_t j = 0; j < slots.size(); ++j) {
+            if (slots[j] != nullptr) {
+                ::operator delete(slots[j]);
+            }
+        }
+    }
+}
+
+JsonKey
+JsonKeyTable::intern(const char *str, std::size_t size)
+{
+    if (size > UINT32_MAX) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonKeyTable: key is too long.[size: %lu]\n%s\n", static_cast<unsigned long>(size), dump_stack().c_str()));
+    }
+
+    // 低位选择分片，其余的位在分片内寻址
+    std::size_t hash = JsonKey::hash_string(str, size);
+    Shard &shard = shards_[hash & (JSON_KEY_TABLE_SHARDS - 1)];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Entry *entry = nullptr;
+    if (!shard.slots.empty()) {
+        std::size_t mask = shard.slots.size() - 1;
+        for (std::size_t slot = (hash / JSON_KEY_TABLE_SHARDS) & mask; shard.slots[slot] != nullptr; slot = (slot + 1) & mask) {
+            Entry *cur = shard.slots[slot];
+            if (cur->hash == hash && cur->size == size && memcmp(cur->data, str, size) == 0) {
+                entry = cur;
+                break;
+            }
+        }
+    }
+
+    if (entry == nullptr) {
+        // 装载率不超过一半
+        if ((shard.count + 1) * 2 > shard.slots.size()) {
+            std::vector<Entry*> slots(std::max<std::size_t>(shard.slots.size() * 2, 64), nullptr);
+            std::size_t mask = slots.size() - 1;
+            for (std::size_t i = 0; i < shard.slots.size(); ++i) {
+                if (shard.slots[i] != nullptr) {
+                    std::size_t slot = (shard.slots[i]->hash / JSON_KEY_TABLE_SHARDS) & mask;
+                    while (slots[slot] != nullptr) {
+                        slot = (slot + 1) & mask;
+                    }
+                    slots[slot] = shard.slots[i];
+                }
+            }
+            shard.slots.swap(slots);
+        }
+
+        std::size_t entry_size = offsetof(Entry, data) + size + 1;
+        entry = static_cast<Entry*>(::operator new(entry_size));
+        entry->table = this;
+        entry->hash = hash;
+        entry->size = size;
+        memcpy(entry->data, str, size);
+        entry->data[size] = '\0';
+
+        std::size_t mask = shard.slots.size() - 1;
+        std::size_t slot = (hash / JSON_KEY_TABLE_SHARDS) & mask;
+        while (shard.slots[slot] != nullptr) {
+            slot = (slot + 1) & mask;
+        }
+        shard.slots[slot] = entry;
+        ++shard.count;
+        shard.memory += entry_size;
+    }
+
+    JsonKey key;
+    key.ptr_ = entry->data;
+    key.size_ = static_cast<uint32_t>(size);
+    key.storage_ = JsonKey::KEY_INTERNED;
+
+    return key;
+}
+
+std::size_t
+JsonKeyTable::size(void) const
+{
+    std::size_t count = 0;
+    for (int i = 0; i < JSON_KEY_TABLE_SHARDS; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        count += shards_[i].count;
+    }
+
+    return count;
+}
+
+std::size_t
+JsonKeyTable::memory_size(void) const
+{
+    std::size_t memory = 0;
+    for (int i = 0; i < JSON_KEY_TABLE_SHARDS; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        memory += shards_[i].memory + shards_[i].slots.size() * sizeof(Entry*);
+    }
+
+    return memory;
+}
+
+JsonKeyTable&
+JsonKeyTable::global(void)
+{
+    static JsonKeyTable *table = new JsonKeyTable();
+    return *table;
+}
+
+}
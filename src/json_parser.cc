@@ -0,0 +1,476 @@
+#include "json_parser.h"
+#include "debug.h"
+
+namespace basic {
+
+namespace {
+
+inline bool is_digit(char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+}
+
+///////////////////////////////// JsonDomBuilder ////////////////////////////////////
+
+JsonDomBuilder::JsonDomBuilder(JsonValue &value, JsonArena *arena, JsonKeyTable *key_table)
+: root_(value),
+  arena_(arena),
+  key_table_(key_table)
+{
+}
+
+JsonDomBuilder::~JsonDomBuilder(void)
+{
+}
+
+JsonValue&
+JsonDomBuilder::next_value(void)
+{
+    if (stack_.empty()) {
+        return root_;
+    }
+
+    if (stack_.back().value->type_ == JSON_ARRAY_TYPE) {
+        std::deque<JsonValue> &items = items_[stack_.size() - 1];
+        items.emplace_back();
+        return items.back();
+    }
+
+    std::deque<JsonObject::member_type> &members = members_[stack_.size() - 1];
+    members.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::move(key_)), std::forward_as_tuple());
+    return members.back().second;
+}
+
+bool
+JsonDomBuilder::start_object(void)
+{
+    JsonValue &value = this->next_value();
+    value.set_object(arena_);
+    stack_.emplace_back();
+    stack_.back().value = &value;
+    if (members_.size() < stack_.size()) {
+        members_.resize(stack_.size());
+    }
+    members_[stack_.size() - 1].clear();
+
+    return true;
+}
+
+bool
+JsonDomBuilder::key(const char *str, ssize_t size)
+{
+    if (key_table_ != nullptr) {
+        key_ = key_table_->intern(str, size);
+    } else {
+        key_ = JsonKey(str, size, arena_);
+    }
+    return true;
+}
+
+bool
+JsonDomBuilder::end_object(void)
+{
+    // 重复的 key 在建立索引时检查
+    JsonObject *object = stack_.back().value->object_;
+    std::deque<JsonObject::member_type> &members = members_[stack_.size() - 1];
+    object->value_.reserve(members.size());
+    for (auto iter = members.begin(); iter != members.end(); ++iter) {
+        object->value_.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::move(iter->first)), std::forward_as_tuple());
+        object->value_.back().second.swap(iter->second);
+    }
+    members.clear();
+    object->rebuild_index(true);
+    stack_.pop_back();
+
+    return true;
+}
+
+bool
+JsonDomBuilder::start_array(void)
+{
+    JsonValue &value = this->next_value();
+    value.set_array(arena_);
+    stack_.emplace_back();
+    stack_.back().value = &value;
+    if (items_.size() < stack_.size()) {
+        items_.resize(stack_.size());
+    }
+    items_[stack_.size() - 1].clear();
+
+    return true;
+}
+
+bool
+JsonDomBuilder::end_array(void)
+{
+    JsonArray *array = stack_.back().value->array_;
+    std::deque<JsonValue> &items = items_[stack_.size() - 1];
+    array->value_.reserve(items.size());
+    for (auto iter = items.begin(); iter != items.end(); ++iter) {
+        array->value_.emplace_back();
+        array->value_.back().swap(*iter);
+    }
+    items.clear();
+    stack_.pop_back();
+
+    return true;
+}
+
+bool
+JsonDomBuilder::string(const char *str, ssize_t size)
+{
+    this->next_value().set_string(str, size, arena_);
+    return true;
+}
+
+bool
+JsonDomBuilder::number(double value)
+{
+    this->next_value().set_number(value);
+    return true;
+}
+
+bool
+JsonDomBuilder::integer(int64_t value)
+{
+    this->next_value().set_int(value);
+    return true;
+}
+
+bool
+JsonDomBuilder::unsigned_integer(uint64_t value)
+{
+    this->next_value().set_uint(value);
+    return true;
+}
+
+bool
+JsonDomBuilder::boolean(bool value)
+{
+    this->next_value().set_bool(value);
+    return true;
+}
+
+bool
+JsonDomBuilder::null(void)
+{
+    this->next_value().release();
+    return true;
+}
+
+///////////////////////////////// JsonParser ////////////////////////////////////
+
+JsonParser::JsonParser(const char *data, ssize_t size)
+: begin_(data),
+  pos_(data),
+  end_(data + (size > 0 ? size : 0)),
+  use_index_(size >= JSON_STRUCTURAL_INDEX_MIN_SIZE),
+  has_index_(false),
+  index_base_(nullptr),
+  next_(0)
+{
+}
+
+JsonParser::~JsonParser(void)
+{
+}
+
+ssize_t
+JsonParser::parse(JsonValue &value)
+{
+    JsonDomBuilder builder(value);
+    return this->parse(builder);
+}
+
+ssize_t
+JsonParser::parse(JsonHandler &handler)
+{
+    if (!this->parse_value(handler)) {
+        return -1;
+    }
+
+    return pos_ - begin_;
+}
+
+ssize_t
+JsonParser::parse_document(JsonValue &value)
+{
+    JsonDomBuilder builder(value);
+    return this->parse_document(builder);
+}
+
+ssize_t
+JsonParser::parse_document(JsonHandler &handler)
+{
+    // 找json文本的开始，如果没有遇到'{'或'['开始的会返回失败
+    for (; pos_ < end_; ++pos_) {
+        if (*pos_ == '{' || *pos_ == '[') {
+            break;
+        }
+    }
+
+    if (pos_ >= end_) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Can't find any json text!\n%s\n", dump_stack().c_str()));
+    }
+
+    // 有注释时不能使用索引，逐字符解析
+    if (use_index_) {
+        has_index_ = build_structural_index(pos_, end_ - pos_, index_);
+        index_base_ = pos_;
+        next_ = 0;
+    }
+
+    return this->parse(handler);
+}
+
+bool
+JsonParser::parse_value(JsonHandler &handler)
+{
+    char ch = this->skip_whitespace();
+    switch (ch)
+    {
+        case '{':
+            return this->parse_object(handler);
+        case '[':
+            return this->parse_array(handler);
+        case '"':
+        {
+            const char *str = nullptr;
+            ssize_t size = 0;
+            this->parse_string(str, size);
+            return handler.string(str, size);
+        }
+        case 't':
+            this->parse_literal("true", 4);
+            return handler.boolean(true);
+        case 'f':
+            this->parse_literal("false", 5);
+            return handler.boolean(false);
+        case 'n':
+            this->parse_literal("null", 4);
+            return handler.null();
+        default:
+            break;
+    }
+
+    if (!is_digit(ch) && ch != '-' && ch != '+') {
+        this->throw_error("Unknown json value");
+    }
+    return this->parse_number(handler);
+}
+
+bool
+JsonParser::parse_object(JsonHandler &handler)
+{
+    ++pos_; // 跳过 '{'
+    if (!handler.start_object()) {
+        return false;
+    }
+    if (this->skip_whitespace() == '}') {
+        ++pos_;
+        return handler.end_object();
+    }
+
+    const char *key = nullptr;
+    ssize_t key_size = 0;
+    while (true) {
+        if (this->skip_whitespace() != '"') {
+            this->throw_error("Object key must be a string");
+        }
+        this->parse_string(key, key_size);
+        this->expect(':');
+
+        if (!handler.key(key, key_size) || !this->parse_value(handler)) {
+            return false;
+        }
+
+        char ch = this->skip_whitespace();
+        ++pos_;
+        if (ch == '}') {
+            break;
+        } else if (ch != ',') {
+            --pos_;
+            this->throw_error("Expected ',' or '}' in object");
+        }
+    }
+
+    return handler.end_object();
+}
+
+bool
+JsonParser::parse_array(JsonHandler &handler)
+{
+    ++pos_; // 跳过 '['
+    if (!handler.start_array()) {
+        return false;
+    }
+    if (this->skip_whitespace() == ']') {
+        ++pos_;
+        return handler.end_array();
+    }
+
+    while (true) {
+        if (!this->parse_value(handler)) {
+            return false;
+        }
+
+        char ch = this->skip_whitespace();
+        ++pos_;
+        if (ch == ']') {
+            break;
+        } else if (ch != ',') {
+            --pos_;
+            this->throw_error("Expected ',' or ']' in array");
+        }
+    }
+
+    return handler.end_array();
+}
+
+void
+JsonParser::parse_string(const char *&str, ssize_t &size)
+{
+    if (has_index_) {
+        // 开头和结尾的引号在索引中是相邻的
+        const char *start = pos_ + 1;
+        std::size_t close = next_ + 1;
+        if (close >= index_.size() || index_base_[index_[close]] != '"') {
+            pos_ = end_;
+            throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"String need to surround by \"\"\n%s\n", dump_stack().c_str()));
+        }
+        pos_ = index_base_ + index_[close];
+        next_ = close;
+        str = start;
+        size = pos_ - start;
+        ++pos_;
+        return ;
+    }
+
+    ++pos_; // 跳过开头的 '"'
+    const char *start = pos_;
+    while (pos_ < end_) {
+        if (*pos_ == '"') {
+            break;
+        } else if (*pos_ == '\\') { // '\' 为转义字符下一个字符不做解析
+            ++pos_;
+        }
+        ++pos_;
+    }
+
+    // 因为字符解析是以'"'为结尾的，所以当遇到结尾时说明字符不是以'"'结尾的
+    if (pos_ >= end_) {
+        pos_ = end_;
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"String need to surround by \"\"\n%s\n", dump_stack().c_str()));
+    }
+
+    str = start;
+    size = pos_ - start;
+    ++pos_;
+}
+
+bool
+JsonParser::parse_number(JsonHandler &handler)
+{
+    JsonNumberLiteral number;
+    const char *error = nullptr;
+    const char *pos = parse_json_number(pos_, end_, number, &error);
+    if (pos == nullptr) {
+        this->throw_error(error);
+    }
+    pos_ = pos;
+    this->check_value_end();
+
+    switch (number.kind)
+    {
+        case JSON_NUMBER_INT:
+            return handler.integer(number.i);
+        case JSON_NUMBER_UINT:
+            return handler.unsigned_integer(number.u);
+        default:
+            break;
+    }
+
+    return handler.number(number.d);
+}
+
+void
+JsonParser::parse_literal(const char *literal, ssize_t size)
+{
+    if (end_ - pos_ < size || memcmp(pos_, literal, size) != 0) {
+        std::string str(pos_, end_ - pos_ < size ? end_ - pos_ : size);
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Expected %s, but result is %s\n%s\n", literal, str.c_str(), dump_stack().c_str()));
+    }
+    pos_ += size;
+    this->check_value_end();
+}
+
+char
+JsonParser::skip_whitespace(void)
+{
+    if (has_index_) {
+        // 索引中下一个不在 pos_ 之前的位置就是下一个字符
+        while (next_ < index_.size() && index_base_ + index_[next_] < pos_) {
+            ++next_;
+        }
+        if (next_ >= index_.size()) {
+            pos_ = end_;
+            return '\0';
+        }
+        pos_ = index_base_ + index_[next_];
+        return *pos_;
+    }
+
+    while (pos_ < end_) {
+        char ch = *pos_;
+        if (ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t') {
+            ++pos_;
+        } else if (ch == '/' && pos_ + 1 < end_ && pos_[1] == '/') {
+            // "//" 以这个开头的注释会被忽略，注释一直到行尾
+            const char *line_end = static_cast<const char*>(memchr(pos_, '\n', end_ - pos_));
+            pos_ = (line_end == nullptr ? end_ : line_end + 1);
+        } else {
+            return ch;
+        }
+    }
+
+    return '\0';
+}
+
+void
+JsonParser::expect(char ch)
+{
+    if (this->skip_whitespace() != ch) {
+        std::string what = std::string("Expected '") + ch + "'";
+        this->throw_error(what.c_str());
+    }
+    ++pos_;
+}
+
+void
+JsonParser::check_value_end(void)
+{
+    if (pos_ >= end_) {
+        return ;
+    }
+
+    switch (*pos_)
+    {
+        case ' ': case '\t': case '\r': case '\n':
+        case ',': case ']': case '}': case '/':
+            return ;
+        default:
+            break;
+    }
+    this->throw_error("Unexpected character after value");
+}
+
+void
+JsonParser::throw_error(const char *what)
+{
+    char ch = (pos_ < end_ ? *pos_ : ' ');
+    throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"%s at offset %ld: %c\n%s\n", what, static_cast<long>(pos_ - begin_), ch, dump_stack().c_str()));
+}
+
+}
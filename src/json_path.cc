@@ -0,0 +1,391 @@
+#include "json_path.h"
+#include "debug.h"
+
+namespace basic {
+
+namespace {
+
+void
+throw_path_error(const char *what, const std::string &path)
+{
+    throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonPath: %s.[path: %s]\n%s\n", what, path.c_str(), dump_stack().c_str()));
+}
+
+// JsonValue 和 const JsonValue 共用的查找过程
+template <typename Value, typename TokenList>
+Value*
+find_value(const TokenList &tokens, Value &root)
+{
+    Value *value = &root;
+    for (auto iter = tokens.begin(); iter != tokens.end(); ++iter) {
+        if (value->type() == JSON_OBJECT_TYPE && !iter->index_only) {
+            auto &object = value->get_object();
+            auto member = object.find(iter->key);
+            if (member == object.end()) {
+                return nullptr;
+            }
+            value = &member->second;
+        } else if (value->type() == JSON_ARRAY_TYPE && iter->index >= 0) {
+            auto &array = value->get_array();
+            if (iter->index >= array.size()) {
+                return nullptr;
+            }
+            value = &array[static_cast<std::size_t>(iter->index)];
+        } else {
+            return nullptr;
+        }
+    }
+
+    return value;
+}
+
+}
+
+JsonPath::JsonPath(void)
+{
+}
+
+JsonPath::JsonPath(const std::string &path)
+{
+    if (path.empty() || path[0] == '/') {
+        *this = from_pointer(path);
+    } else {
+        *this = from_dotted(path);
+    }
+}
+
+JsonPath::~JsonPath(void)
+{
+}
+
+int64_t
+JsonPath::parse_index(const std::string &str)
+{
+    if (str.empty() || str.size() > 18 || (str[0] == '0' && str.size() > 1)) {
+        return -1;
+    }
+
+    int64_t index = 0;
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        if (str[i] < '0' || str[i] > '9') {
+            return -1;
+        }
+        index = index * 10 + (str[i] - '0');
+    }
+
+    return index;
+}
+
+JsonPath
+JsonPath::from_pointer(const std::string &pointer)
+{
+    JsonPath path;
+    if (pointer.empty()) {
+        return path;
+    }
+    if (pointer[0] != '/') {
+        throw_path_error("JSON Pointer must start with '/'", pointer);
+    }
+
+    std::size_t pos = 1;
+    while (true) {
+        std::size_t next = pointer.find('/', pos);
+        if (next == std::string::npos) {
+            next = pointer.size();
+        }
+
+        Token token;
+        for (std::size_t i = pos; i < next; ++i) {
+            if (pointer[i] != '~') {
+                token.key += pointer[i];
+            } else if (i + 1 < next && pointer[i + 1] == '0') {
+                token.key += '~';
+                ++i;
+            } else if (i + 1 < next && pointer[i + 1] == '1') {
+                token.key += '/';
+                ++i;
+            } else {
+                throw_path_error("'~' must be followed by '0' or '1'", pointer);
+            }
+        }
+        token.index = parse_index(token.key);
+        token.index_only = false;
+        path.tokens_.push_back(token);
+
+        if (next == pointer.size()) {
+            break;
+        }
+        pos = next + 1;
+    }
+
+    return path;
+}
+
+JsonPath
+JsonPath::from_dotted(const std::string &str)
+{
+    JsonPath path;
+    std::size_t pos = 0;
+    while (pos < str.size()) {
+        Token token;
+        if (str[pos] == '[') {
+            std::size_t close = std::string::npos;
+            if (pos + 1 < str.size() && (str[pos + 1] == '"' || str[pos + 1] == '\'')) {
+                // ["key"] 或 ['key']
+                std::size_t quote = str.find(str[pos + 1], pos + 2);
+                if (quote == std::string::npos || quote + 1 >= str.size() || str[quote + 1] != ']') {
+                    throw_path_error("Unclosed quoted key", str);
+                }
+                token.key = str.substr(pos + 2, quote - pos - 2);
+                token.index = -1;
+                token.index_only = false;
+                close = quote + 1;
+            } else {
+                close = str.find(']', pos);
+                if (close == std::string::npos) {
+                    throw_path_error("Unclosed '['", str);
+                }
+                token.index = parse_index(str.substr(pos + 1, close - pos - 1));
+                if (token.index < 0) {
+                    throw_path_error("Invalid array index", str);
+                }
+                token.index_only = true;
+            }
+            pos = close + 1;
+        } else {
+            std::size_t next = str.find_first_of(".[", pos);
+            if (next == std::string::npos) {
+                next = str.size();
+            }
+            if (next == pos) {
+                throw_path_error("Empty key", str);
+            }
+            token.key = str.substr(pos, next - pos);
+            token.index = parse_index(token.key);
+            token.index_only = false;
+            pos = next;
+        }
+        path.tokens_.push_back(token);
+
+        // 段之后只能是 '.'、'[' 或是结尾
+        if (pos < str.size() && str[pos] == '.') {
+            if (++pos >= str.size()) {
+                throw_path_error("Empty key", str);
+            }
+        } else if (pos < str.size() && str[pos] != '[') {
+            throw_path_error("Expected '.' or '['", str);
+        }
+    }
+
+    return path;
+}
+
+const JsonValue*
+JsonPath::find(const JsonValue &root) const
+{
+    return find_value(tokens_, root);
+}
+
+JsonValue*
+JsonPath::find(JsonValue &root) const
+{
+    return find_value(tokens_, root);
+}
+
+LazyJsonValue
+JsonPath::find(const LazyJsonValue &root) const
+{
+    LazyJsonValue value = root;
+    for (auto token = tokens_.begin(); token != tokens_.end(); ++token) {
+        ValueType type = value.type();
+        bool found = false;
+        if (type == JSON_OBJECT_TYPE && !token->index_only) {
+            for (auto iter = value.begin(); iter != value.end(); ++iter) {
+                if (token->match_key(iter.key_data(), iter.key_size())) {
+                    value = iter.value();
+                    found = true;
+                    break;
+                }
+            }
+        } else if (type == JSON_ARRAY_TYPE && token->index >= 0) {
+            int64_t index = 0;
+            for (auto iter = value.begin(); iter != value.end(); ++iter, ++index) {
+                if (index == token->index) {
+                    value = iter.value();
+                    found = true;
+                    break;
+                }
+            }
+        }
+
+        if (!found) {
+            return LazyJsonValue();
+        }
+    }
+
+    return value;
+}
+
+std::string
+JsonPath::to_pointer(void) const
+{
+    std::string pointer;
+    for (auto iter = tokens_.begin(); iter != tokens_.end(); ++iter) {
+        pointer += '/';
+        if (iter->index_only) {
+            pointer += std::to_string(iter->index);
+            continue;
+        }
+        for (std::size_t i = 0; i < iter->key.size(); ++i) {
+            if (iter->key[i] == '~') {
+                pointer += "~0";
+            } else if (iter->key[i] == '/') {
+                pointer += "~1";
+            } else {
+                pointer += iter->key[i];
+            }
+        }
+    }
+
+    return pointer;
+}
+
+bool
+JsonPath::operator==(const JsonPath &rhs) const
+{
+    return tokens_ == rhs.tokens_;
+}
+
+//////////////////////////////////////////////////////////////
+
+JsonPathExtractor::JsonPathExtractor(void)
+: path_count_(0)
+{
+    nodes_.resize(1);
+    nodes_[0].token.index = -1;
+    nodes_[0].token.index_only = false;
+    nodes_[0].max_index = -1;
+    nodes_[0].key_children = 0;
+}
+
+JsonPathExtractor::~JsonPathExtractor(void)
+{
+}
+
+std::size_t
+JsonPathExtractor::add(const JsonPath &path)
+{
+    // nodes_ 扩容时引用会失效，只保存位置
+    uint32_t cur = 0;
+    for (auto token = path.tokens_.begin(); token != path.tokens_.end(); ++token) {
+        uint32_t next = 0;
+        for (std::size_t i = 0; i < nodes_[cur].children.size(); ++i) {
+            if (nodes_[nodes_[cur].children[i]].token == *token) {
+                next = nodes_[cur].children[i];
+                break;
+            }
+        }
+
+        if (next == 0) {
+            next = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+            nodes_[next].token = *token;
+            nodes_[next].max_index = -1;
+            nodes_[next].key_children = 0;
+
+            Node &parent = nodes_[cur];
+            parent.children.push_back(next);
+            parent.max_index = std::max(parent.max_index, token->index);
+            if (!token->index_only) {
+                ++parent.key_children;
+            }
+        }
+        cur = next;
+    }
+    nodes_[cur].paths.push_back(static_cast<uint32_t>(path_count_));
+
+    return path_count_++;
+}
+
+std::size_t
+JsonPathExtractor::add(const std::string &path)
+{
+    return this->add(JsonPath(path));
+}
+
+ssize_t
+JsonPathExtractor::extract(const char *data, ssize_t size, std::vector<LazyJsonValue> &results) const
+{
+    LazyJson doc(data, size);
+    return this->extract(doc.root(), results);
+}
+
+ssize_t
+JsonPathExtractor::extract(const std::string &data, std::vector<LazyJsonValue> &results) const
+{
+    return this->extract(data.data(), static_cast<ssize_t>(data.size()), results);
+}
+
+ssize_t
+JsonPathExtractor::extract(const LazyJsonValue &root, std::vector<LazyJsonValue> &results) const
+{
+    results.assign(path_count_, LazyJsonValue());
+
+    std::size_t found = 0;
+    this->scan(nodes_[0], root, results, found);
+
+    return static_cast<ssize_t>(found);
+}
+
+bool
+JsonPathExtractor::scan(const Node &node, const LazyJsonValue &value, std::vector<LazyJsonValue> &results, std::size_t &found) const
+{
+    for (std::size_t i = 0; i < node.paths.size(); ++i) {
+        results[node.paths[i]] = value;
+        ++found;
+    }
+    if (found == path_count_) {
+        return true;
+    }
+    if (node.children.empty()) {
+        return false;
+    }
+
+    ValueType type = value.type();
+    if (type == JSON_OBJECT_TYPE && node.key_children > 0) {
+        // 对象中没有重复的 key，需要的成员都找到之后不再扫描这个对象
+        std::size_t matched = 0;
+        for (auto iter = value.begin(); iter != value.end(); ++iter) {
+            for (std::size_t i = 0; i < node.children.size(); ++i) {
+                const Node &child = nodes_[node.children[i]];
+                if (!child.token.match_key(iter.key_data(), iter.key_size())) {
+                    continue;
+                }
+                if (this->scan(child, iter.value(), results, found)) {
+                    return true;
+                }
+                ++matched;
+            }
+            if (matched == node.key_children) {
+                break;
+            }
+        }
+    } else if (type == JSON_ARRAY_TYPE && node.max_index >= 0) {
+        int64_t index = 0;
+        for (auto iter = value.begin(); iter != value.end(); ++iter, ++index) {
+            for (std::size_t i = 0; i < node.children.size(); ++i) {
+                const Node &child = nodes_[node.children[i]];
+                if (child.token.index == index && this->scan(child, iter.value(), results, found)) {
+                    return true;
+                }
+            }
+            if (index >= node.max_index) {
+                break;
+            }
+        }
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,357 @@
+#include "json_stream_parser.h"
+#include "debug.h"
+
+namespace basic {
+
+namespace {
+
+inline bool is_number_char(char ch)
+{
+    return (ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.' || ch == 'e' || ch == 'E';
+}
+
+inline bool is_space(char ch)
+{
+    return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+}
+
+}
+
+JsonStreamParser::JsonStreamParser(JsonHandler &handler)
+: handler_(handler)
+{
+    this->reset();
+}
+
+JsonStreamParser::~JsonStreamParser(void)
+{
+}
+
+void
+JsonStreamParser::reset(void)
+{
+    state_ = STATE_START;
+    token_ = TOKEN_NONE;
+    chunk_ = nullptr;
+    consumed_ = 0;
+    stack_.clear();
+    buffer_.clear();
+    buffered_ = false;
+    escaped_ = false;
+}
+
+ssize_t
+JsonStreamParser::feed(const char *data, ssize_t size)
+{
+    if (state_ == STATE_STOPPED || state_ == STATE_ERROR) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonStreamParser: parsing was stopped or failed, need reset!\n%s\n", dump_stack().c_str()));
+    }
+
+    chunk_ = data;
+    const char *pos = data;
+    const char *end = data + (size > 0 ? size : 0);
+    bool keep_going = true;
+    try {
+        while (keep_going && pos < end && state_ != STATE_DONE) {
+            if (token_ != TOKEN_NONE) {
+                keep_going = this->parse_token(pos, end);
+            } else {
+                keep_going = this->parse_char(pos, end);
+            }
+        }
+    } catch (...) {
+        state_ = STATE_ERROR;
+        throw;
+    }
+
+    consumed_ += pos - data;
+    if (!keep_going) {
+        state_ = STATE_STOPPED;
+        return -1;
+    }
+
+    return pos - data;
+}
+
+ssize_t
+JsonStreamParser::feed(ByteBuffer &buff)
+{
+    buffptr first = nullptr, second = nullptr;
+    ssize_t first_size = 0, second_size = 0;
+    buff.get_read_segments(first, first_size, second, second_size);
+
+    ssize_t old_consumed = consumed_;
+    ssize_t ret = this->feed(first, first_size);
+    if (ret == first_size && second_size > 0) {
+        ret = this->feed(second, second_size);
+    }
+    buff.update_read_pos(consumed_ - old_consumed);
+
+    return ret == -1 ? -1 : consumed_ - old_consumed;
+}
+
+bool
+JsonStreamParser::parse_char(const char *&pos, const char *end)
+{
+    char ch = *pos;
+    if (is_space(ch)) {
+        ++pos;
+        return true;
+    }
+
+    if (state_ == STATE_START) {
+        // 找json文本的开始，'{' 或 '[' 之前的内容都跳过
+        if (ch != '{' && ch != '[') {
+            ++pos;
+            return true;
+        }
+        state_ = STATE_VALUE;
+    }
+
+    if (ch == '/') {
+        ++pos;
+        this->start_token(TOKEN_SLASH);
+        return true;
+    }
+
+    switch (state_)
+    {
+        case STATE_VALUE:
+            return this->start_value(pos, end);
+        case STATE_ARRAY_FIRST:
+        {
+            if (ch != ']') {
+                return this->start_value(pos, end);
+            }
+            ++pos;
+            stack_.pop_back();
+            this->value_done();
+            return handler_.end_array();
+        }
+        case STATE_OBJECT_FIRST:
+        {
+            if (ch == '}') {
+                ++pos;
+                stack_.pop_back();
+                this->value_done();
+                return handler_.end_object();
+            }
+        } // fallthrough
+        case STATE_OBJECT_KEY:
+        {
+            if (ch != '"') {
+                this->throw_error("Object key must be a string", pos);
+            }
+            ++pos;
+            this->start_token(TOKEN_KEY);
+            return this->parse_token(pos, end);
+        }
+        case STATE_COLON:
+        {
+            if (ch != ':') {
+                this->throw_error("Expected ':'", pos);
+            }
+            ++pos;
+            state_ = STATE_VALUE;
+            return true;
+        }
+        case STATE_AFTER_VALUE:
+        {
+            char container = stack_.back();
+            if (ch == ',') {
+                ++pos;
+                state_ = (container == '{' ? STATE_OBJECT_KEY : STATE_VALUE);
+                return true;
+            } else if (ch == '}' && container == '{') {
+                ++pos;
+                stack_.pop_back();
+                this->value_done();
+                return handler_.end_object();
+            } else if (ch == ']' && container == '[') {
+                ++pos;
+                stack_.pop_back();
+                this->value_done();
+                return handler_.end_array();
+            }
+            this->throw_error(container == '{' ? "Expected ',' or '}' in object" : "Expected ',' or ']' in array", pos);
+        } break;
+        default:
+            break;
+    }
+
+    return true;
+}
+
+bool
+JsonStreamParser::start_value(const char *&pos, const char *end)
+{
+    char ch = *pos;
+    switch (ch)
+    {
+        case '{':
+        {
+            ++pos;
+            stack_.push_back('{');
+            state_ = STATE_OBJECT_FIRST;
+            return handler_.start_object();
+        }
+        case '[':
+        {
+            ++pos;
+            stack_.push_back('[');
+            state_ = STATE_ARRAY_FIRST;
+            return handler_.start_array();
+        }
+        case '"':
+        {
+            ++pos;
+            this->start_token(TOKEN_STRING);
+        } break;
+        case 't': case 'f': case 'n':
+            this->start_token(TOKEN_LITERAL);
+            break;
+        default:
+        {
+            if ((ch < '0' || ch > '9') && ch != '-' && ch != '+') {
+                this->throw_error("Unknown json value", pos);
+            }
+            this->start_token(TOKEN_NUMBER);
+        } break;
+    }
+
+    return this->parse_token(pos, end);
+}
+
+bool
+JsonStreamParser::parse_token(const char *&pos, const char *end)
+{
+    const char *start = pos;
+    switch (token_)
+    {
+        case TOKEN_SLASH:
+        {
+            if (*pos != '/') {
+                this->throw_error("Unexpected character after '/'", pos);
+            }
+            ++pos;
+            token_ = TOKEN_COMMENT;
+        } return true;
+        case TOKEN_COMMENT:
+        {
+            // "//" 开头的注释一直到行尾
+            const char *line_end = static_cast<const char*>(memchr(pos, '\n', end - pos));
+            if (line_end == nullptr) {
+                pos = end;
+            } else {
+                pos = line_end + 1;
+                token_ = TOKEN_NONE;
+            }
+        } return true;
+        case TOKEN_STRING:
+        case TOKEN_KEY:
+        {
+            for (; pos < end; ++pos) {
+                if (escaped_) { // '\' 为转义字符下一个字符不做解析
+                    escaped_ = false;
+                } else if (*pos == '\\') {
+                    escaped_ = true;
+                } else if (*pos == '"') {
+                    break;
+                }
+            }
+        } break;
+        case TOKEN_NUMBER:
+            for (; pos < end && is_number_char(*pos); ++pos) {}
+            break;
+        case TOKEN_LITERAL:
+            for (; pos < end && *pos >= 'a' && *pos <= 'z'; ++pos) {}
+            break;
+        default:
+            break;
+    }
+
+    // 数据段结束时 token 还没有结束，保存下来等待下一段数据
+    if (pos >= end) {
+        buffer_.append(start, end - start);
+        buffered_ = true;
+        return true;
+    }
+
+    const char *str = start;
+    ssize_t size = pos - start;
+    if (buffered_) {
+        buffer_.append(start, size);
+        str = buffer_.data();
+        size = buffer_.size();
+    }
+
+    Token token = token_;
+    token_ = TOKEN_NONE;
+    if (token == TOKEN_STRING || token == TOKEN_KEY) {
+        ++pos; // 跳过结尾的 '"'
+    }
+
+    return this->emit_token(token, str, size, pos);
+}
+
+bool
+JsonStreamParser::emit_token(Token token, const char *str, ssize_t size, const char *pos)
+{
+    switch (token)
+    {
+        case TOKEN_KEY:
+            state_ = STATE_COLON;
+            return handler_.key(str, size);
+        case TOKEN_STRING:
+            this->value_done();
+            return handler_.string(str, size);
+        case TOKEN_NUMBER:
+        {
+            // 数值的格式检查和转换和 JsonParser 一致
+            this->value_done();
+            JsonParser parser(str, size);
+            return parser.parse(handler_) != -1;
+        }
+        case TOKEN_LITERAL:
+        {
+            this->value_done();
+            if (size == 4 && memcmp(str, "true", 4) == 0) {
+                return handler_.boolean(true);
+            } else if (size == 5 && memcmp(str, "false", 5) == 0) {
+                return handler_.boolean(false);
+            } else if (size == 4 && memcmp(str, "null", 4) == 0) {
+                return handler_.null();
+            }
+            this->throw_error("Unknown json value", pos);
+        } break;
+        default:
+            break;
+    }
+
+    return true;
+}
+
+void
+JsonStreamParser::start_token(Token token)
+{
+    token_ = token;
+    buffer_.clear();
+    buffered_ = false;
+    escaped_ = false;
+}
+
+void
+JsonStreamParser::value_done(void)
+{
+    state_ = (stack_.empty() ? STATE_DONE : STATE_AFTER_VALUE);
+}
+
+void
+JsonStreamParser::throw_error(const char *what, const char *pos)
+{
+    char ch = (pos != nullptr ? *pos : ' ');
+    long offset = static_cast<long>(consumed_ + (pos - chunk_));
+    throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonStreamParser: %s at offset %ld: %c\n%s\n", what, offset, ch, dump_stack().c_str()));
+}
+
+}
@@ -0,0 +1,306 @@
+#include "json_structural.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define __BASIC_JSON_X86__
+#endif
+
+namespace basic {
+
+namespace {
+
+enum SimdLevel {
+    SIMD_LEVEL_NONE,
+    SIMD_LEVEL_SSE2,
+    SIMD_LEVEL_AVX2
+};
+
+SimdLevel
+simd_level(void)
+{
+    static SimdLevel level = []() {
+#if defined(__BASIC_JSON_X86__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return SIMD_LEVEL_AVX2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return SIMD_LEVEL_SSE2;
+        }
+#endif
+        return SIMD_LEVEL_NONE;
+    }();
+
+    return level;
+}
+
+// 64 个字节中各类字符所在的位，第 i 位对应第 i 个字节
+struct BlockMasks {
+    uint64_t quote;         // '"'
+    uint64_t backslash;     // '\'
+    uint64_t op;            // '{' '}' '[' ']' ':' ','
+    uint64_t whitespace;    // ' ' '\t' '\n' '\r'
+    uint64_t slash;         // '/'
+};
+
+typedef void (*classify_func)(const char *block, BlockMasks &masks);
+
+enum CharClass {
+    CHAR_OTHER = 0,
+    CHAR_QUOTE = 1,
+    CHAR_BACKSLASH = 2,
+    CHAR_OP = 4,
+    CHAR_WHITESPACE = 8,
+    CHAR_SLASH = 16
+};
+
+struct ClassTable {
+    uint8_t value[256];
+
+    ClassTable(void) {
+        memset(value, CHAR_OTHER, sizeof(value));
+        value[static_cast<uint8_t>('"')] = CHAR_QUOTE;
+        value[static_cast<uint8_t>('\\')] = CHAR_BACKSLASH;
+        value[static_cast<uint8_t>('/')] = CHAR_SLASH;
+        const char ops[] = "{}[]:,";
+        for (int i = 0; ops[i] != '\0'; ++i) {
+            value[static_cast<uint8_t>(ops[i])] = CHAR_OP;
+        }
+        const char spaces[] = " \t\n\r";
+        for (int i = 0; spaces[i] != '\0'; ++i) {
+            value[static_cast<uint8_t>(spaces[i])] = CHAR_WHITESPACE;
+        }
+    }
+};
+
+void
+classify_scalar(const char *block, BlockMasks &masks)
+{
+    static const ClassTable table;
+
+    memset(&masks, 0, sizeof(masks));
+    for (int i = 0; i < 64; ++i) {
+        uint8_t cls = table.value[static_cast<uint8_t>(block[i])];
+        if (cls == CHAR_OTHER) {
+            continue;
+        }
+
+        uint64_t bit = 1ULL << i;
+        if (cls == CHAR_QUOTE) {
+            masks.quote |= bit;
+        } else if (cls == CHAR_BACKSLASH) {
+            masks.backslash |= bit;
+        } else if (cls == CHAR_OP) {
+            masks.op |= bit;
+        } else if (cls == CHAR_WHITESPACE) {
+            masks.whitespace |= bit;
+        } else {
+            masks.slash |= bit;
+        }
+    }
+}
+
+#if defined(__BASIC_JSON_X86__)
+
+// 每次比较 16 个字节
+inline uint64_t
+sse2_eq(__m128i in, char ch)
+{
+    return static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(in, _mm_set1_epi8(ch))));
+}
+
+void
+classify_sse2(const char *block, BlockMasks &masks)
+{
+    memset(&masks, 0, sizeof(masks));
+    for (int i = 0; i < 4; ++i) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        int shift = 16 * i;
+
+        masks.quote |= sse2_eq(in, '"') << shift;
+        masks.backslash |= sse2_eq(in, '\\') << shift;
+        masks.slash |= sse2_eq(in, '/') << shift;
+        masks.op |= (sse2_eq(in, '{') | sse2_eq(in, '}') | sse2_eq(in, '[') | sse2_eq(in, ']')
+                        | sse2_eq(in, ':') | sse2_eq(in, ',')) << shift;
+        masks.whitespace |= (sse2_eq(in, ' ') | sse2_eq(in, '\t') | sse2_eq(in, '\n') | sse2_eq(in, '\r')) << shift;
+    }
+}
+
+// 每次比较 32 个字节
+__attribute__((target("avx2")))
+inline __m256i
+avx2_eq(__m256i in, char ch)
+{
+    return _mm256_cmpeq_epi8(in, _mm256_set1_epi8(ch));
+}
+
+__attribute__((target("avx2")))
+inline uint64_t
+avx2_bits(__m256i mask)
+{
+    return static_cast<uint32_t>(_mm256_movemask_epi8(mask));
+}
+
+__attribute__((target("avx2")))
+void
+classify_avx2(const char *block, BlockMasks &masks)
+{
+    memset(&masks, 0, sizeof(masks));
+    for (int i = 0; i < 2; ++i) {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * i));
+        int shift = 32 * i;
+
+        __m256i op = _mm256_or_si256(
+                        _mm256_or_si256(_mm256_or_si256(avx2_eq(in, '{'), avx2_eq(in, '}')),
+                                        _mm256_or_si256(avx2_eq(in, '['), avx2_eq(in, ']'))),
+                        _mm256_or_si256(avx2_eq(in, ':'), avx2_eq(in, ',')));
+        __m256i whitespace = _mm256_or_si256(
+                        _mm256_or_si256(avx2_eq(in, ' '), avx2_eq(in, '\t')),
+                        _mm256_or_si256(avx2_eq(in, '\n'), avx2_eq(in, '\r')));
+
+        masks.quote |= avx2_bits(avx2_eq(in, '"')) << shift;
+        masks.backslash |= avx2_bits(avx2_eq(in, '\\')) << shift;
+        masks.slash |= avx2_bits(avx2_eq(in, '/')) << shift;
+        masks.op |= avx2_bits(op) << shift;
+        masks.whitespace |= avx2_bits(whitespace) << shift;
+    }
+}
+
+#endif
+
+classify_func
+select_classify(void)
+{
+#if defined(__BASIC_JSON_X86__)
+    switch (simd_level())
+    {
+        case SIMD_LEVEL_AVX2:
+            return classify_avx2;
+        case SIMD_LEVEL_SSE2:
+            return classify_sse2;
+        default:
+            break;
+    }
+#endif
+
+    return classify_scalar;
+}
+
+// 每一位等于它和它之前所有位的异或，引号之间(包括开头的引号)的位为 1
+inline uint64_t
+prefix_xor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+
+    return bits;
+}
+
+// 跨越多个块的状态
+struct ScanState {
+    uint64_t prev_escaped;      // 上一块最后是奇数个 '\'，本块第一个字符被转义
+    uint64_t prev_in_string;    // 上一块结束时在字符串中为全 1
+    uint64_t prev_scalar;       // 上一块最后一个字符是值的一部分
+
+    ScanState(void) : prev_escaped(0), prev_in_string(0), prev_scalar(0) {}
+};
+
+// 找出被 '\' 转义的字符: 连续的 '\' 中，从开头数奇数位置的 '\' 转义它后面的字符
+inline uint64_t
+find_escaped(uint64_t backslash, ScanState &state)
+{
+    const uint64_t even_bits = 0x5555555555555555ULL;
+
+    backslash &= ~state.prev_escaped;
+    uint64_t follows_escape = (backslash << 1) | state.prev_escaped;
+
+    // 从奇数位开始的连续 '\' 加上自身后进位到序列的末尾，据此翻转这些序列的奇偶
+    uint64_t odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+    uint64_t sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+    state.prev_escaped = (sequences_starting_on_even_bits < backslash ? 1 : 0);
+    uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+
+    return (even_bits ^ invert_mask) & follows_escape;
+}
+
+// 将 bits 中为 1 的位的偏移追加到 index 中
+inline void
+flatten_bits(std::vector<uint32_t> &index, uint32_t base, uint64_t bits)
+{
+    if (bits == 0) {
+        return ;
+    }
+
+    std::size_t old_size = index.size();
+    index.resize(old_size + __builtin_popcountll(bits));
+    uint32_t *out = index.data() + old_size;
+    while (bits != 0) {
+        *out++ = base + static_cast<uint32_t>(__builtin_ctzll(bits));
+        bits &= bits - 1;
+    }
+}
+
+}
+
+bool
+build_structural_index(const char *data, ssize_t size, std::vector<uint32_t> &index)
+{
+    index.clear();
+    if (data == nullptr || size <= 0) {
+        return true;
+    }
+    if (size > static_cast<ssize_t>(UINT32_MAX)) {
+        return false;
+    }
+
+    static const classify_func classify = select_classify();
+
+    // 结构字符一般不会超过文本的 1/4
+    index.reserve(size / 4 + 16);
+
+    ScanState state;
+    BlockMasks masks;
+    char tail_block[64];
+    for (ssize_t offset = 0; offset < size; offset += 64) {
+        const char *block = data + offset;
+        if (size - offset < 64) {
+            // 最后不足 64 字节的部分用空格补齐
+            memset(tail_block, ' ', sizeof(tail_block));
+            memcpy(tail_block, block, size - offset);
+            block = tail_block;
+        }
+        classify(block, masks);
+
+        uint64_t escaped = find_escaped(masks.backslash, state);
+        uint64_t quote = masks.quote & ~escaped;
+        uint64_t in_string = prefix_xor(quote) ^ state.prev_in_string;
+        state.prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+        // 字符串外面出现 '/' 说明有注释
+        if ((masks.slash & ~in_string) != 0) {
+            return false;
+        }
+
+        // 字符串除开头引号外的部分(包括结尾的引号)
+        uint64_t string_tail = in_string ^ quote;
+
+        // 既不是结构字符也不是空白的字符属于值，只保留每个值的第一个字符
+        uint64_t scalar = ~(masks.op | masks.whitespace);
+        uint64_t nonquote_scalar = scalar & ~quote;
+        uint64_t follows_nonquote_scalar = (nonquote_scalar << 1) | state.prev_scalar;
+        state.prev_scalar = nonquote_scalar >> 63;
+
+        uint64_t structural = (masks.op | (scalar & ~follows_nonquote_scalar)) & ~string_tail;
+        uint64_t closing_quote = quote & ~in_string;
+
+        flatten_bits(index, static_cast<uint32_t>(offset), structural | closing_quote);
+    }
+
+    return true;
+}
+
+}
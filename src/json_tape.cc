@@ -0,0 +1,949 @@
+#include "json_tape.h"
+#include "debug.h"
+
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstddef>
+#include <algorithm>
+
+namespace basic {
+
+namespace {
+
+const char JSON_TAPE_MAGIC[8] = {'W', 'E', 'J', 'T', 'A', 'P', 'E', '\0'};
+const uint32_t JSON_TAPE_MAX_COUNT = 0xffffff;
+
+const uint64_t XXH_PRIME1 = 0x9e3779b185ebca87ULL;
+const uint64_t XXH_PRIME2 = 0xc2b2ae3d27d4eb4fULL;
+const uint64_t XXH_PRIME3 = 0x165667b19e3779f9ULL;
+const uint64_t XXH_PRIME4 = 0x85ebca77c2b2ae63ULL;
+const uint64_t XXH_PRIME5 = 0x27d4eb2f165667c5ULL;
+
+inline uint64_t
+rotl64(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t
+read64(const char *pos)
+{
+    uint64_t value = 0;
+    memcpy(&value, pos, sizeof(value));
+    return value;
+}
+
+inline uint32_t
+read32(const char *pos)
+{
+    uint32_t value = 0;
+    memcpy(&value, pos, sizeof(value));
+    return value;
+}
+
+inline uint64_t
+xxh_round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH_PRIME2;
+    acc = rotl64(acc, 31);
+    return acc * XXH_PRIME1;
+}
+
+inline uint64_t
+xxh_merge(uint64_t acc, uint64_t value)
+{
+    acc ^= xxh_round(0, value);
+    return acc * XXH_PRIME1 + XXH_PRIME4;
+}
+
+inline uint64_t
+make_word(uint8_t type, uint64_t payload)
+{
+    return (static_cast<uint64_t>(type) << 56) | payload;
+}
+
+uint64_t
+header_hash(const JsonTapeHeader &header)
+{
+    return json_tape_hash(reinterpret_cast<const char*>(&header), offsetof(JsonTapeHeader, header_hash));
+}
+
+// 写入 fd，处理部分写入
+void
+write_all(int fd, const char *data, std::size_t size, const std::string &path)
+{
+    while (size > 0) {
+        ssize_t ret = ::write(fd, data, size);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            int err = errno;
+            ::close(fd);
+            throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Can't write %s: %s\n%s\n", path.c_str(), strerror(err), dump_stack().c_str()));
+        }
+        data += ret;
+        size -= ret;
+    }
+}
+
+// 映射整个文件，文件为空时返回 nullptr
+const char*
+map_file(const std::string &path, ssize_t &size)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Can't open %s: %s\n%s\n", path.c_str(), strerror(errno), dump_stack().c_str()));
+    }
+
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) < 0) {
+        ::close(fd);
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Can't stat %s: %s\n%s\n", path.c_str(), strerror(errno), dump_stack().c_str()));
+    }
+
+    size = static_cast<ssize_t>(file_stat.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Can't mmap %s: %s\n%s\n", path.c_str(), strerror(errno), dump_stack().c_str()));
+    }
+
+    return static_cast<const char*>(addr);
+}
+
+}
+
+uint64_t
+json_tape_hash(const char *data, ssize_t size)
+{
+    const char *pos = data;
+    const char *end = data + (size > 0 ? size : 0);
+    uint64_t hash = 0;
+
+    if (end - pos >= 32) {
+        uint64_t v1 = XXH_PRIME1 + XXH_PRIME2;
+        uint64_t v2 = XXH_PRIME2;
+        uint64_t v3 = 0;
+        uint64_t v4 = 0 - XXH_PRIME1;
+        const char *limit = end - 32;
+        do {
+            v1 = xxh_round(v1, read64(pos));
+            v2 = xxh_round(v2, read64(pos + 8));
+            v3 = xxh_round(v3, read64(pos + 16));
+            v4 = xxh_round(v4, read64(pos + 24));
+            pos += 32;
+        } while (pos <= limit);
+
+        hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        hash = xxh_merge(hash, v1);
+        hash = xxh_merge(hash, v2);
+        hash = xxh_merge(hash, v3);
+        hash = xxh_merge(hash, v4);
+    } else {
+        hash = XXH_PRIME5;
+    }
+    hash += static_cast<uint64_t>(end - data);
+
+    while (end - pos >= 8) {
+        hash ^= xxh_round(0, read64(pos));
+        hash = rotl64(hash, 27) * XXH_PRIME1 + XXH_PRIME4;
+        pos += 8;
+    }
+    if (end - pos >= 4) {
+        hash ^= static_cast<uint64_t>(read32(pos)) * XXH_PRIME1;
+        hash = rotl64(hash, 23) * XXH_PRIME2 + XXH_PRIME3;
+        pos += 4;
+    }
+    while (pos < end) {
+        hash ^= static_cast<uint8_t>(*pos) * XXH_PRIME5;
+        hash = rotl64(hash, 11) * XXH_PRIME1;
+        ++pos;
+    }
+
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+//////////////////////////////////////////////////////////////
+
+// 根据解析事件或是 json 树追加到 tape
+class JsonTapeBuilder : public JsonHandler {
+public:
+    explicit JsonTapeBuilder(JsonTape &tape)
+    : tape_(tape.tape_),
+      strings_(tape.strings_)
+    {
+    }
+
+    // 遍历 json 树，产生和解析文本相同的事件
+    void add(const JsonValue &value) {
+        switch (value.type_)
+        {
+            case JSON_OBJECT_TYPE: {
+                const JsonObject &object = *value.object_;
+                this->start_object();
+                for (auto iter = object.value_.begin(); iter != object.value_.end(); ++iter) {
+                    this->key(iter->first.data(), iter->first.size());
+                    this->add(iter->second);
+                }
+                this->end_object();
+            } break;
+            case JSON_ARRAY_TYPE: {
+                const JsonArray &array = *value.array_;
+                this->start_array();
+                for (auto iter = array.value_.begin(); iter != array.value_.end(); ++iter) {
+                    this->add(*iter);
+                }
+                this->end_array();
+            } break;
+            case JSON_STRING_TYPE:
+                this->string(value.string_, value.size_);
+                break;
+            case JSON_NUMBER_TYPE:
+                if (value.kind_ == JSON_NUMBER_INT) {
+                    this->integer(value.int_);
+                } else if (value.kind_ == JSON_NUMBER_UINT) {
+                    this->unsigned_integer(value.uint_);
+                } else {
+                    this->number(value.number_);
+                }
+                break;
+            case JSON_BOOL_TYPE:
+                this->boolean(value.bool_);
+                break;
+            default:
+                this->null();
+                break;
+        }
+    }
+
+    virtual bool start_object(void) override {return this->start_container();}
+    virtual bool end_object(void) override {return this->end_container('{', '}');}
+    virtual bool start_array(void) override {return this->start_container();}
+    virtual bool end_array(void) override {return this->end_container('[', ']');}
+
+    virtual bool key(const char *str, ssize_t size) override {
+        this->add_string(str, size);
+        return true;
+    }
+    virtual bool string(const char *str, ssize_t size) override {
+        this->value_added();
+        this->add_string(str, size);
+        return true;
+    }
+    virtual bool number(double value) override {
+        uint64_t bits = 0;
+        memcpy(&bits, &value, sizeof(bits));
+        return this->add_scalar('d', bits);
+    }
+    virtual bool integer(int64_t value) override {
+        return this->add_scalar('l', static_cast<uint64_t>(value));
+    }
+    virtual bool unsigned_integer(uint64_t value) override {
+        return this->add_scalar('u', value);
+    }
+    virtual bool boolean(bool value) override {
+        this->value_added();
+        tape_.push_back(make_word(value ? 't' : 'f', 0));
+        return true;
+    }
+    virtual bool null(void) override {
+        this->value_added();
+        tape_.push_back(make_word('n', 0));
+        return true;
+    }
+
+private:
+    void value_added(void) {
+        if (!counts_.empty()) {
+            ++counts_.back();
+        }
+    }
+
+    bool start_container(void) {
+        this->value_added();
+        opens_.push_back(tape_.size());
+        counts_.push_back(0);
+        tape_.push_back(0);
+        return true;
+    }
+
+    bool end_container(uint8_t open_type, uint8_t close_type) {
+        uint64_t open = opens_.back();
+        uint64_t count = std::min<uint64_t>(counts_.back(), JSON_TAPE_MAX_COUNT);
+        opens_.pop_back();
+        counts_.pop_back();
+        if (tape_.size() + 1 > 0xffffffffULL) {
+            throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonTape: document is too large. [tape size: %lu]\n%s\n", static_cast<unsigned long>(tape_.size()), dump_stack().c_str()));
+        }
+
+        tape_[open] = make_word(open_type, (count << 32) | (tape_.size() + 1));
+        tape_.push_back(make_word(close_type, open));
+        return true;
+    }
+
+    bool add_scalar(uint8_t type, uint64_t bits) {
+        this->value_added();
+        tape_.push_back(make_word(type, 0));
+        tape_.push_back(bits);
+        return true;
+    }
+
+    void add_string(const char *str, ssize_t size) {
+        uint32_t length = static_cast<uint32_t>(size);
+        tape_.push_back(make_word('"', strings_.size()));
+        strings_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        strings_.append(str, size);
+        strings_ += '\0';
+    }
+
+private:
+    std::vector<uint64_t> &tape_;
+    std::string &strings_;
+    // 没有结束的容器开头的下标和已经添加的值的数量
+    std::vector<uint64_t> opens_;
+    std::vector<uint64_t> counts_;
+};
+
+//////////////////////////////////////////////////////////////
+
+JsonTape::JsonTape(void)
+: map_addr_(nullptr),
+  map_size_(0),
+  words_(nullptr),
+  word_count_(0),
+  string_base_(nullptr),
+  string_size_(0)
+{
+}
+
+JsonTape::~JsonTape(void)
+{
+    this->release();
+}
+
+void
+JsonTape::release(void)
+{
+    if (map_addr_ != nullptr) {
+        ::munmap(map_addr_, map_size_);
+        map_addr_ = nullptr;
+        map_size_ = 0;
+    }
+    tape_.clear();
+    strings_.clear();
+    words_ = nullptr;
+    word_count_ = 0;
+    string_base_ = nullptr;
+    string_size_ = 0;
+}
+
+void
+JsonTape::build(const JsonValue &value)
+{
+    this->release();
+    JsonTapeBuilder builder(*this);
+    builder.add(value);
+
+    words_ = tape_.data();
+    word_count_ = tape_.size();
+    string_base_ = strings_.data();
+    string_size_ = strings_.size();
+}
+
+void
+JsonTape::build(const char *data, ssize_t size)
+{
+    this->release();
+    // 每个字对应文本中的若干个字节，按文本大小预留一部分
+    tape_.reserve(static_cast<std::size_t>(size > 0 ? size : 0) / 8);
+    JsonTapeBuilder builder(*this);
+    JsonParser parser(data, size);
+    try {
+        parser.parse_document(builder);
+    } catch (...) {
+        this->release();
+        throw;
+    }
+
+    words_ = tape_.data();
+    word_count_ = tape_.size();
+    string_base_ = strings_.data();
+    string_size_ = strings_.size();
+}
+
+ssize_t
+JsonTape::serialize(std::string &out, uint64_t source_hash, uint64_t source_size) const
+{
+    JsonTapeHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, JSON_TAPE_MAGIC, sizeof(header.magic));
+    header.version = JSON_TAPE_VERSION;
+    header.header_size = sizeof(JsonTapeHeader);
+    header.source_size = source_size;
+    header.source_hash = source_hash;
+    header.tape_size = word_count_;
+    header.string_size = string_size_;
+    header.header_hash = header_hash(header);
+
+    std::size_t old_size = out.size();
+    out.reserve(old_size + sizeof(header) + word_count_ * sizeof(uint64_t) + string_size_);
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.append(reinterpret_cast<const char*>(words_), word_count_ * sizeof(uint64_t));
+    out.append(string_base_, string_size_);
+
+    return static_cast<ssize_t>(out.size() - old_size);
+}
+
+ssize_t
+JsonTape::save(const std::string &path, uint64_t source_hash, uint64_t source_size) const
+{
+    std::string data;
+    this->serialize(data, source_hash, source_size);
+
+    std::string tmp_path = path + ".tmp." + std::to_string(::getpid());
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Can't open %s: %s\n%s\n", tmp_path.c_str(), strerror(errno), dump_stack().c_str()));
+    }
+    write_all(fd, data.data(), data.size(), tmp_path);
+    ::close(fd);
+
+    if (::rename(tmp_path.c_str(), path.c_str()) < 0) {
+        int err = errno;
+        ::unlink(tmp_path.c_str());
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Can't rename %s to %s: %s\n%s\n", tmp_path.c_str(), path.c_str(), strerror(err), dump_stack().c_str()));
+    }
+
+    return static_cast<ssize_t>(data.size());
+}
+
+bool
+JsonTape::load(const char *data, ssize_t size, uint64_t source_hash, uint64_t source_size)
+{
+    this->release();
+    if (data == nullptr || size < static_cast<ssize_t>(sizeof(JsonTapeHeader)) || reinterpret_cast<uintptr_t>(data) % sizeof(uint64_t) != 0) {
+        return false;
+    }
+
+    JsonTapeHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, JSON_TAPE_MAGIC, sizeof(header.magic)) != 0
+            || header.version != JSON_TAPE_VERSION
+            || header.header_size != sizeof(JsonTapeHeader)
+            || header.header_hash != header_hash(header)) {
+        return false;
+    }
+    if (header.source_hash != source_hash || header.source_size != source_size) {
+        return false;
+    }
+
+    uint64_t body_size = static_cast<uint64_t>(size) - sizeof(header);
+    if (header.tape_size == 0 || header.tape_size > body_size / sizeof(uint64_t)
+            || header.tape_size * sizeof(uint64_t) + header.string_size != body_size) {
+        return false;
+    }
+
+    words_ = reinterpret_cast<const uint64_t*>(data + sizeof(header));
+    word_count_ = header.tape_size;
+    string_base_ = data + sizeof(header) + header.tape_size * sizeof(uint64_t);
+    string_size_ = header.string_size;
+
+    return true;
+}
+
+bool
+JsonTape::load_file(const std::string &path, uint64_t source_hash, uint64_t source_size)
+{
+    this->release();
+    if (::access(path.c_str(), F_OK) < 0) {
+        return false;
+    }
+
+    ssize_t size = 0;
+    const char *data = map_file(path, size);
+    if (data == nullptr) {
+        return false;
+    }
+    if (!this->load(data, size, source_hash, source_size)) {
+        ::munmap(const_cast<char*>(data), size);
+        return false;
+    }
+    map_addr_ = const_cast<char*>(data);
+    map_size_ = size;
+
+    return true;
+}
+
+bool
+JsonTape::open(const std::string &source_path, const std::string &tape_path)
+{
+    ssize_t size = 0;
+    const char *source = map_file(source_path, size);
+    uint64_t hash = json_tape_hash(source, size);
+
+    bool loaded = false;
+    try {
+        loaded = this->load_file(tape_path, hash, static_cast<uint64_t>(size));
+        if (!loaded) {
+            this->build(source, size);
+            this->save(tape_path, hash, static_cast<uint64_t>(size));
+        }
+    } catch (...) {
+        if (source != nullptr) {
+            ::munmap(const_cast<char*>(source), size);
+        }
+        throw;
+    }
+    if (source != nullptr) {
+        ::munmap(const_cast<char*>(source), size);
+    }
+
+    return loaded;
+}
+
+JsonTapeValue
+JsonTape::root(void) const
+{
+    if (words_ == nullptr) {
+        return JsonTapeValue();
+    }
+
+    return JsonTapeValue(this, 0);
+}
+
+uint64_t
+JsonTape::next_index(uint64_t index) const
+{
+    uint64_t next = index + 1;
+    switch (this->type_at(index))
+    {
+        case '{':
+        case '[':
+            next = this->payload_at(index) & 0xffffffffULL;
+            break;
+        case 'l':
+        case 'u':
+        case 'd':
+            next = index + 2;
+            break;
+        default:
+            break;
+    }
+
+    if (next <= index || next > word_count_) {
+        this->throw_corrupted(index);
+    }
+
+    return next;
+}
+
+const char*
+JsonTape::string_at(uint64_t index, uint32_t &size) const
+{
+    uint64_t offset = this->payload_at(index);
+    if (offset + sizeof(uint32_t) > string_size_) {
+        this->throw_corrupted(index);
+    }
+    memcpy(&size, string_base_ + offset, sizeof(size));
+    if (offset + sizeof(uint32_t) + size + 1 > string_size_) {
+        this->throw_corrupted(index);
+    }
+
+    return string_base_ + offset + sizeof(uint32_t);
+}
+
+void
+JsonTape::throw_corrupted(uint64_t index) const
+{
+    throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonTape: corrupted tape at index %lu\n%s\n", static_cast<unsigned long>(index), dump_stack().c_str()));
+}
+
+//////////////////////////////////////////////////////////////
+
+JsonTapeValue::JsonTapeValue(void)
+: tape_(nullptr),
+  index_(0)
+{
+}
+
+JsonTapeValue::JsonTapeValue(const JsonTape *tape, uint64_t index)
+: tape_(tape),
+  index_(index)
+{
+}
+
+JsonTapeValue::~JsonTapeValue(void)
+{
+}
+
+ValueType
+JsonTapeValue::type(void) const
+{
+    if (tape_ == nullptr) {
+        return JSON_UNKNOWN_TYPE;
+    }
+
+    switch (tape_->type_at(index_))
+    {
+        case '{':
+            return JSON_OBJECT_TYPE;
+        case '[':
+            return JSON_ARRAY_TYPE;
+        case '"':
+            return JSON_STRING_TYPE;
+        case 'l':
+        case 'u':
+        case 'd':
+            return JSON_NUMBER_TYPE;
+        case 't':
+        case 'f':
+            return JSON_BOOL_TYPE;
+        case 'n':
+            return JSON_NULL_TYPE;
+        default:
+            break;
+    }
+
+    return JSON_UNKNOWN_TYPE;
+}
+
+bool
+JsonTapeValue::find(const std::string &key, JsonTapeValue &value) const
+{
+    if (this->type() != JSON_OBJECT_TYPE) {
+        return false;
+    }
+
+    for (iterator iter = this->begin(); iter != this->end(); ++iter) {
+        if (iter.key_size() == static_cast<ssize_t>(key.size()) && memcmp(iter.key_data(), key.data(), key.size()) == 0) {
+            value = iter.value();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+JsonTapeValue
+JsonTapeValue::operator[](const std::string &key) const
+{
+    if (this->type() != JSON_OBJECT_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonTapeValue::operator[%s]: current type is not object. [type: %s]\n%s\n", key.c_str(), JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+
+    JsonTapeValue value;
+    if (!this->find(key, value)) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonTapeValue: out of range.[key: %s]\n%s\n", key.c_str(), dump_stack().c_str()));
+    }
+
+    return value;
+}
+
+JsonTapeValue
+JsonTapeValue::operator[](const char *key) const
+{
+    return (*this)[std::string(key)];
+}
+
+JsonTapeValue
+JsonTapeValue::operator[](int index) const
+{
+    if (this->type() != JSON_ARRAY_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonTapeValue::operator[%d]: current type is not array. [type: %s]\n%s\n", index, JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+
+    iterator iter = this->begin();
+    for (int i = 0; i < index && iter != this->end(); ++i) {
+        ++iter;
+    }
+
+    if (index < 0 || iter == this->end()) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonTapeValue: out of range[index: %d]\n%s\n", index, dump_stack().c_str()));
+    }
+
+    return iter.value();
+}
+
+int
+JsonTapeValue::size(void) const
+{
+    ValueType value_type = this->type();
+    if (value_type != JSON_OBJECT_TYPE && value_type != JSON_ARRAY_TYPE) {
+        return 0;
+    }
+
+    uint64_t count = tape_->payload_at(index_) >> 32;
+    if (count < JSON_TAPE_MAX_COUNT) {
+        return static_cast<int>(count);
+    }
+
+    // 数量超过了保存的上限时逐个计数
+    int total = 0;
+    for (iterator iter = this->begin(); iter != this->end(); ++iter) {
+        ++total;
+    }
+
+    return total;
+}
+
+JsonTapeValue::iterator
+JsonTapeValue::begin(void) const
+{
+    ValueType value_type = this->type();
+    if (value_type != JSON_OBJECT_TYPE && value_type != JSON_ARRAY_TYPE) {
+        return JsonTapeIterator();
+    }
+
+    return JsonTapeIterator(tape_, value_type == JSON_OBJECT_TYPE, index_ + 1);
+}
+
+JsonTapeValue::iterator
+JsonTapeValue::end(void) const
+{
+    ValueType value_type = this->type();
+    if (value_type != JSON_OBJECT_TYPE && value_type != JSON_ARRAY_TYPE) {
+        return JsonTapeIterator();
+    }
+
+    return JsonTapeIterator(tape_, value_type == JSON_OBJECT_TYPE, tape_->next_index(index_) - 1);
+}
+
+double
+JsonTapeValue::to_double(void) const
+{
+    if (this->type() != JSON_NUMBER_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not number. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+
+    uint64_t bits = tape_->words_[index_ + 1];
+    switch (tape_->type_at(index_))
+    {
+        case 'l':
+            return static_cast<double>(static_cast<int64_t>(bits));
+        case 'u':
+            return static_cast<double>(bits);
+        default:
+            break;
+    }
+
+    double value = 0;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int64_t
+JsonTapeValue::to_int(void) const
+{
+    if (this->type() != JSON_NUMBER_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not number. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+
+    // 整数保存的是精确值，浮点数会丢失小数部分
+    if (tape_->type_at(index_) == 'd') {
+        return static_cast<int64_t>(this->to_double());
+    }
+    return static_cast<int64_t>(tape_->words_[index_ + 1]);
+}
+
+bool
+JsonTapeValue::to_bool(void) const
+{
+    if (this->type() != JSON_BOOL_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not a bool. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+
+    return tape_->type_at(index_) == 't';
+}
+
+bool
+JsonTapeValue::is_null(void) const
+{
+    return this->type() == JSON_NULL_TYPE;
+}
+
+std::string
+JsonTapeValue::to_string(void) const
+{
+    return std::string(this->string_data(), this->string_size());
+}
+
+const char*
+JsonTapeValue::string_data(void) const
+{
+    if (this->type() != JSON_STRING_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not std::string. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+
+    uint32_t size = 0;
+    return tape_->string_at(index_, size);
+}
+
+ssize_t
+JsonTapeValue::string_size(void) const
+{
+    if (this->type() != JSON_STRING_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not std::string. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+
+    uint32_t size = 0;
+    tape_->string_at(index_, size);
+    return size;
+}
+
+JsonValue
+JsonTapeValue::to_value(void) const
+{
+    JsonValue value;
+    if (tape_ != nullptr) {
+        JsonDomBuilder builder(value);
+        this->emit(builder);
+    }
+
+    return value;
+}
+
+bool
+JsonTapeValue::emit(JsonHandler &handler) const
+{
+    switch (this->type())
+    {
+        case JSON_OBJECT_TYPE: {
+            if (!handler.start_object()) {
+                return false;
+            }
+            for (iterator iter = this->begin(); iter != this->end(); ++iter) {
+                if (!handler.key(iter.key_data(), iter.key_size()) || !iter.value().emit(handler)) {
+                    return false;
+                }
+            }
+            return handler.end_object();
+        }
+        case JSON_ARRAY_TYPE: {
+            if (!handler.start_array()) {
+                return false;
+            }
+            for (iterator iter = this->begin(); iter != this->end(); ++iter) {
+                if (!(*iter).emit(handler)) {
+                    return false;
+                }
+            }
+            return handler.end_array();
+        }
+        case JSON_STRING_TYPE: {
+            uint32_t size = 0;
+            const char *str = tape_->string_at(index_, size);
+            return handler.string(str, size);
+        }
+        case JSON_NUMBER_TYPE:
+            switch (tape_->type_at(index_))
+            {
+                case 'l':
+                    return handler.integer(this->to_int());
+                case 'u':
+                    return handler.unsigned_integer(tape_->words_[index_ + 1]);
+                default:
+                    return handler.number(this->to_double());
+            }
+        case JSON_BOOL_TYPE:
+            return handler.boolean(this->to_bool());
+        case JSON_NULL_TYPE:
+            return handler.null();
+        default:
+            break;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+
+JsonTapeIterator::JsonTapeIterator(void)
+: tape_(nullptr),
+  is_object_(false),
+  pos_(0)
+{
+}
+
+JsonTapeIterator::JsonTapeIterator(const JsonTape *tape, bool is_object, uint64_t pos)
+: tape_(tape),
+  is_object_(is_object),
+  pos_(pos)
+{
+}
+
+JsonTapeIterator::~JsonTapeIterator(void)
+{
+}
+
+std::string
+JsonTapeIterator::key(void) const
+{
+    if (!is_object_) {
+        return "";
+    }
+
+    return std::string(this->key_data(), this->key_size());
+}
+
+const char*
+JsonTapeIterator::key_data(void) const
+{
+    if (!is_object_) {
+        return "";
+    }
+
+    uint32_t size = 0;
+    return tape_->string_at(pos_, size);
+}
+
+ssize_t
+JsonTapeIterator::key_size(void) const
+{
+    if (!is_object_) {
+        return 0;
+    }
+
+    uint32_t size = 0;
+    tape_->string_at(pos_, size);
+    return size;
+}
+
+JsonTapeValue
+JsonTapeIterator::value(void) const
+{
+    return JsonTapeValue(tape_, is_object_ ? pos_ + 1 : pos_);
+}
+
+JsonTapeIterator&
+JsonTapeIterator::operator++()
+{
+    // 对象的成员是 key 和值两项
+    pos_ = tape_->next_index(is_object_ ? pos_ + 1 : pos_);
+    return *this;
+}
+
+bool
+JsonTapeIterator::operator==(const JsonTapeIterator &rhs) const
+{
+    return tape_ == rhs.tape_ && pos_ == rhs.pos_;
+}
+
+bool
+JsonTapeIterator::operator!=(const JsonTapeIterator &rhs) const
+{
+    return !(*this == rhs);
+}
+
+}
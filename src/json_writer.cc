@@ -0,0 +1,416 @@
+#include "json_writer.h"
+#include "debug.h"
+
+#include <algorithm>
+
+namespace basic {
+
+namespace {
+
+// 数值输出的最大长度，例如 "-0.000001234567890123456" 和 "-9223372036854775808"
+const std::size_t max_double_size = 25;
+const std::size_t max_integer_size = 20;
+
+// 写入一段已经确定足够大的内存
+class PointerSink {
+public:
+    explicit PointerSink(char *pos) : pos_(pos) {}
+
+    void put(char ch) {*pos_++ = ch;}
+    void append(const char *str, std::size_t size) {
+        memcpy(pos_, str, size);
+        pos_ += size;
+    }
+    void fill(char ch, std::size_t size) {
+        memset(pos_, ch, size);
+        pos_ += size;
+    }
+    void number(const JsonNumber &value) {pos_ = value.to_chars(pos_);}
+
+    char* pos(void) const {return pos_;}
+
+private:
+    char *pos_;
+};
+
+// 追加到 std::string 中，空间不够时由 std::string 扩容
+class StringSink {
+public:
+    explicit StringSink(std::string &out) : out_(out) {}
+
+    void put(char ch) {out_.push_back(ch);}
+    void append(const char *str, std::size_t size) {out_.append(str, size);}
+    void fill(char ch, std::size_t size) {out_.append(size, ch);}
+    void number(const JsonNumber &value) {
+        char buf[JSON_NUMBER_BUFFER_SIZE];
+        out_.append(buf, value.to_chars(buf) - buf);
+    }
+
+private:
+    std::string &out_;
+};
+
+}
+
+JsonWriter::JsonWriter(std::string &out)
+: string_out_(&out),
+  buffer_out_(nullptr),
+  estimate_(true),
+  indent_width_(0),
+  indent_char_(' '),
+  sort_keys_(false),
+  max_inline_width_(0)
+{
+}
+
+JsonWriter::JsonWriter(ByteBuffer &out)
+: string_out_(nullptr),
+  buffer_out_(&out),
+  estimate_(true),
+  indent_width_(0),
+  indent_char_(' '),
+  sort_keys_(false),
+  max_inline_width_(0)
+{
+}
+
+JsonWriter::~JsonWriter(void)
+{
+}
+
+void
+JsonWriter::set_indent(int width, char ch)
+{
+    indent_width_ = width > 0 ? width : 0;
+    indent_char_ = ch;
+}
+
+ssize_t
+JsonWriter::write(const JsonValue &value)
+{
+    return this->write_root(value);
+}
+
+ssize_t
+JsonWriter::write(const JsonObject &value)
+{
+    return this->write_root(value);
+}
+
+ssize_t
+JsonWriter::write(const JsonArray &value)
+{
+    return this->write_root(value);
+}
+
+template <typename T>
+ssize_t
+JsonWriter::write_root(const T &value)
+{
+    bool pretty = indent_width_ > 0;
+    if (string_out_ != nullptr) {
+        std::string &out = *string_out_;
+        std::size_t old_size = out.size();
+        if (estimate_) {
+            out.resize(old_size + estimate_node(value, 0, indent_width_));
+            PointerSink sink(&out[old_size]);
+            this->write_node(value, sink, 0, pretty);
+            out.resize(sink.pos() - out.data());
+        } else {
+            StringSink sink(out);
+            this->write_node(value, sink, 0, pretty);
+        }
+        return static_cast<ssize_t>(out.size() - old_size);
+    }
+
+    ByteBuffer &buff = *buffer_out_;
+    if (!estimate_) {
+        std::string out;
+        StringSink sink(out);
+        this->write_node(value, sink, 0, pretty);
+        return buff.write_bytes(out.data(), static_cast<ssize_t>(out.size()));
+    }
+
+    // 预留一段连续的空闲空间
+    ssize_t size = static_cast<ssize_t>(estimate_node(value, 0, indent_width_));
+    if (buff.get_cont_write_size() < size) {
+        if (buff.idle_size() >= size) {
+            buff.compact();
+        }
+        if (buff.get_cont_write_size() < size) {
+            buff.resize(buff.data_size() + size + 1);
+        }
+        if (buff.get_cont_write_size() < size) {
+            throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonWriter: output is too large.[size: %ld]\n%s\n", static_cast<long>(size), dump_stack().c_str()));
+        }
+    }
+
+    buffptr start = buff.get_write_buffer_ptr();
+    PointerSink sink(start);
+    this->write_node(value, sink, 0, pretty);
+    buff.update_write_pos(sink.pos() - start);
+
+    return sink.pos() - start;
+}
+
+template <typename Sink>
+void
+JsonWriter::write_node(const JsonValue &value, Sink &sink, int depth, bool pretty)
+{
+    switch (value.type_)
+    {
+        case JSON_OBJECT_TYPE:
+            this->write_node(*value.object_, sink, depth, pretty);
+            break;
+        case JSON_ARRAY_TYPE:
+            this->write_node(*value.array_, sink, depth, pretty);
+            break;
+        case JSON_STRING_TYPE: {
+            sink.put('"');
+            sink.append(value.string_, value.size_);
+            sink.put('"');
+        } break;
+        case JSON_NUMBER_TYPE:
+            sink.number(value.to_number());
+            break;
+        case JSON_BOOL_TYPE: {
+            if (value.bool_) {
+                sink.append("true", 4);
+            } else {
+                sink.append("false", 5);
+            }
+        } break;
+        default:
+            sink.append("null", 4);
+            break;
+    }
+}
+
+template <typename Sink>
+void
+JsonWriter::write_node(const JsonObject &value, Sink &sink, int depth, bool pretty)
+{
+    if (value.value_.empty()) {
+        sink.append("{}", 2);
+        return;
+    }
+    if (pretty && this->fits_inline(value)) {
+        pretty = false;
+    }
+
+    sink.put('{');
+    if (sort_keys_) {
+        std::vector<const JsonObject::member_type*> members;
+        members.reserve(value.value_.size());
+        for (auto iter = value.value_.begin(); iter != value.value_.end(); ++iter) {
+            members.push_back(&*iter);
+        }
+        std::sort(members.begin(), members.end(),
+            [](const JsonObject::member_type *lhs, const JsonObject::member_type *rhs) {
+                return lhs->first < rhs->first;
+            });
+        for (std::size_t i = 0; i < members.size(); ++i) {
+            this->write_member(members[i]->first, members[i]->second, i == 0, sink, depth, pretty);
+        }
+    } else {
+        for (auto iter = value.value_.begin(); iter != value.value_.end(); ++iter) {
+            this->write_member(iter->first, iter->second, iter == value.value_.begin(), sink, depth, pretty);
+        }
+    }
+    if (pretty) {
+        this->write_newline(sink, depth);
+    }
+    sink.put('}');
+}
+
+template <typename Sink>
+void
+JsonWriter::write_node(const JsonArray &value, Sink &sink, int depth, bool pretty)
+{
+    if (value.value_.empty()) {
+        sink.append("[]", 2);
+        return;
+    }
+    if (pretty && this->fits_inline(value)) {
+        pretty = false;
+    }
+
+    sink.put('[');
+    for (auto iter = value.value_.begin(); iter != value.value_.end(); ++iter) {
+        if (iter != value.value_.begin()) {
+            sink.put(',');
+        }
+        if (pretty) {
+            this->write_newline(sink, depth + 1);
+        }
+        this->write_node(*iter, sink, depth + 1, pretty);
+    }
+    if (pretty) {
+        this->write_newline(sink, depth);
+    }
+    sink.put(']');
+}
+
+template <typename Sink>
+void
+JsonWriter::write_member(const JsonKey &key, const JsonValue &value, bool first, Sink &sink, int depth, bool pretty)
+{
+    if (!first) {
+        sink.put(',');
+    }
+    if (pretty) {
+        this->write_newline(sink, depth + 1);
+    }
+    sink.put('"');
+    sink.append(key.data(), key.size());
+    sink.put('"');
+    sink.put(':');
+    if (pretty) {
+        sink.put(' ');
+    }
+    this->write_node(value, sink, depth + 1, pretty);
+}
+
+template <typename Sink>
+void
+JsonWriter::write_newline(Sink &sink, int depth)
+{
+    sink.put('\n');
+    sink.fill(indent_char_, static_cast<std::size_t>(depth) * indent_width_);
+}
+
+template <typename T>
+bool
+JsonWriter::fits_inline(const T &value) const
+{
+    if (max_inline_width_ <= 0) {
+        return false;
+    }
+
+    std::size_t size = 0;
+    return this->measure(value, size);
+}
+
+bool
+JsonWriter::measure(const JsonValue &value, std::size_t &size) const
+{
+    switch (value.type_)
+    {
+        case JSON_OBJECT_TYPE:
+            return this->measure(*value.object_, size);
+        case JSON_ARRAY_TYPE:
+            return this->measure(*value.array_, size);
+        case JSON_STRING_TYPE:
+            size += value.size_ + 2;
+            break;
+        case JSON_NUMBER_TYPE: {
+            char buf[JSON_NUMBER_BUFFER_SIZE];
+            size += value.to_number().to_chars(buf) - buf;
+        } break;
+        case JSON_BOOL_TYPE:
+            size += value.bool_ ? 4 : 5;
+            break;
+        default:
+            size += 4;
+            break;
+    }
+
+    return size <= static_cast<std::size_t>(max_inline_width_);
+}
+
+bool
+JsonWriter::measure(const JsonObject &value, std::size_t &size) const
+{
+    // 超过宽度后不再继续计算，大的容器只会访问开头的一部分
+    size += value.value_.empty() ? 2 : 1;
+    for (auto iter = value.value_.begin(); iter != value.value_.end(); ++iter) {
+        size += iter->first.size() + 4;
+        if (!this->measure(iter->second, size)) {
+            return false;
+        }
+    }
+
+    return size <= static_cast<std::size_t>(max_inline_width_);
+}
+
+bool
+JsonWriter::measure(const JsonArray &value, std::size_t &size) const
+{
+    size += value.value_.empty() ? 2 : 1;
+    for (auto iter = value.value_.begin(); iter != value.value_.end(); ++iter) {
+        size += 1;
+        if (!this->measure(*iter, size)) {
+            return false;
+        }
+    }
+
+    return size <= static_cast<std::size_t>(max_inline_width_);
+}
+
+std::size_t
+JsonWriter::estimate_size(const JsonValue &value)
+{
+    return estimate_node(value, 0, 0);
+}
+
+std::size_t
+JsonWriter::estimate_size(const JsonObject &value)
+{
+    return estimate_node(value, 0, 0);
+}
+
+std::size_t
+JsonWriter::estimate_size(const JsonArray &value)
+{
+    return estimate_node(value, 0, 0);
+}
+
+std::size_t
+JsonWriter::estimate_node(const JsonValue &value, int depth, int width)
+{
+    switch (value.type_)
+    {
+        case JSON_OBJECT_TYPE:
+            return estimate_node(*value.object_, depth, width);
+        case JSON_ARRAY_TYPE:
+            return estimate_node(*value.array_, depth, width);
+        case JSON_STRING_TYPE:
+            return value.size_ + 2;
+        case JSON_NUMBER_TYPE:
+            return value.kind_ == JSON_NUMBER_DOUBLE ? max_double_size : max_integer_size;
+        case JSON_BOOL_TYPE:
+            return 5;
+        default:
+            break;
+    }
+
+    return 4;
+}
+
+std::size_t
+JsonWriter::estimate_node(const JsonObject &value, int depth, int width)
+{
+    // '{' '}'，每个成员的两个引号、':' 和 ','
+    // 格式化时每个成员和 '}' 前面还有换行和缩进，':' 后面有一个空格
+    std::size_t indent = width > 0 ? 1 + static_cast<std::size_t>(depth + 1) * width : 0;
+    std::size_t size = 2 + (width > 0 ? 1 + static_cast<std::size_t>(depth) * width : 0);
+    for (auto iter = value.value_.begin(); iter != value.value_.end(); ++iter) {
+        size += iter->first.size() + 4 + indent + (width > 0 ? 1 : 0) + estimate_node(iter->second, depth + 1, width);
+    }
+
+    return size;
+}
+
+std::size_t
+JsonWriter::estimate_node(const JsonArray &value, int depth, int width)
+{
+    std::size_t indent = width > 0 ? 1 + static_cast<std::size_t>(depth + 1) * width : 0;
+    std::size_t size = 2 + (width > 0 ? 1 + static_cast<std::size_t>(depth) * width : 0);
+    for (auto iter = value.value_.begin(); iter != value.value_.end(); ++iter) {
+        size += estimate_node(*iter, depth + 1, width) + 1 + indent;
+    }
+
+    return size;
+}
+
+}
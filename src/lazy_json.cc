@@ -0,0 +1,526 @@
+#include "lazy_json.h"
+#include "json_parser.h"
+#include "debug.h"
+
+namespace basic {
+
+namespace {
+
+// 跳过容器时需要关注的字符
+struct SkipTable {
+    bool value[256];
+
+    SkipTable(void) {
+        memset(value, 0, sizeof(value));
+        const char chars[] = "\"{}[]/";
+        for (int i = 0; chars[i] != '\0'; ++i) {
+            value[static_cast<uint8_t>(chars[i])] = true;
+        }
+    }
+};
+
+void
+throw_error(const char *what, const char *pos, const char *end)
+{
+    std::string near_text(pos, end - pos < 16 ? end - pos : 16);
+    throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"LazyJson: %s near: %s\n%s\n", what, near_text.c_str(), dump_stack().c_str()));
+}
+
+// 跳过空白和 "//" 注释
+const char*
+skip_whitespace(const char *pos, const char *end)
+{
+    while (pos < end) {
+        char ch = *pos;
+        if (ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t') {
+            ++pos;
+        } else if (ch == '/' && pos + 1 < end && pos[1] == '/') {
+            const char *line_end = static_cast<const char*>(memchr(pos, '\n', end - pos));
+            pos = (line_end == nullptr ? end : line_end + 1);
+        } else {
+            break;
+        }
+    }
+
+    return pos;
+}
+
+// pos 指向开头的引号，返回结尾引号之后的位置
+const char*
+skip_string(const char *pos, const char *end)
+{
+    const char *start = pos;
+    ++pos;
+    while (pos < end) {
+        const char *quote = static_cast<const char*>(memchr(pos, '"', end - pos));
+        if (quote == nullptr) {
+            break;
+        }
+
+        // 引号前面有奇数个 '\' 时引号被转义
+        const char *back = quote;
+        while (back > pos && back[-1] == '\\') {
+            --back;
+        }
+        if ((quote - back) % 2 == 0) {
+            return quote + 1;
+        }
+        pos = quote + 1;
+    }
+
+    throw_error("String need to surround by \"\"", start, end);
+    return end;
+}
+
+// 通过括号匹配跳过对象或数组，返回结尾括号之后的位置
+const char*
+skip_container(const char *pos, const char *end)
+{
+    static const SkipTable table;
+
+    const char *start = pos;
+    int depth = 0;
+    while (pos < end) {
+        if (!table.value[static_cast<uint8_t>(*pos)]) {
+            ++pos;
+            continue;
+        }
+
+        switch (*pos)
+        {
+            case '"':
+                pos = skip_string(pos, end);
+                continue;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if (--depth == 0) {
+                    return pos + 1;
+                }
+                break;
+            default: // '/'
+                if (pos + 1 < end && pos[1] == '/') {
+                    pos = skip_whitespace(pos, end);
+                    continue;
+                }
+                break;
+        }
+        ++pos;
+    }
+
+    throw_error("Unclosed object or array", start, end);
+    return end;
+}
+
+}
+
+//////////////////////////////////////////////////////////////
+
+LazyJsonValue::LazyJsonValue(void)
+: pos_(nullptr),
+  end_(nullptr)
+{
+}
+
+LazyJsonValue::LazyJsonValue(const char *pos, const char *end)
+: pos_(pos < end ? pos : nullptr),
+  end_(end)
+{
+}
+
+LazyJsonValue::~LazyJsonValue(void)
+{
+}
+
+ValueType
+LazyJsonValue::type(void) const
+{
+    if (pos_ == nullptr) {
+        return JSON_UNKNOWN_TYPE;
+    }
+
+    switch (*pos_)
+    {
+        case '{':
+            return JSON_OBJECT_TYPE;
+        case '[':
+            return JSON_ARRAY_TYPE;
+        case '"':
+            return JSON_STRING_TYPE;
+        case 't':
+        case 'f':
+            return JSON_BOOL_TYPE;
+        case 'n':
+            return JSON_NULL_TYPE;
+        default:
+            break;
+    }
+
+    if ((*pos_ >= '0' && *pos_ <= '9') || *pos_ == '-' || *pos_ == '+') {
+        return JSON_NUMBER_TYPE;
+    }
+
+    return JSON_UNKNOWN_TYPE;
+}
+
+const char*
+LazyJsonValue::skip(void) const
+{
+    if (pos_ == nullptr) {
+        return nullptr;
+    }
+
+    switch (*pos_)
+    {
+        case '"':
+            return skip_string(pos_, end_);
+        case '{':
+        case '[':
+            return skip_container(pos_, end_);
+        default:
+            break;
+    }
+
+    // 数值和 true/false/null 一直到分隔字符
+    const char *pos = pos_;
+    while (pos < end_) {
+        char ch = *pos;
+        if (ch == ',' || ch == ']' || ch == '}' || ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == '/') {
+            break;
+        }
+        ++pos;
+    }
+
+    return pos;
+}
+
+bool
+LazyJsonValue::find(const std::string &key, LazyJsonValue &value) const
+{
+    if (this->type() != JSON_OBJECT_TYPE) {
+        return false;
+    }
+
+    for (iterator iter = this->begin(); iter != this->end(); ++iter) {
+        if (iter.key_size_ == static_cast<ssize_t>(key.size()) && memcmp(iter.key_, key.c_str(), key.size()) == 0) {
+            value = iter.value_;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+LazyJsonValue
+LazyJsonValue::operator[](const std::string &key) const
+{
+    if (this->type() != JSON_OBJECT_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"LazyJsonValue::operator[%s]: current type is not object. [type: %s]\n%s\n", key.c_str(), JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+
+    LazyJsonValue value;
+    if (!this->find(key, value)) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"LazyJsonValue: out of range.[key: %s]\n%s\n", key.c_str(), dump_stack().c_str()));
+    }
+
+    return value;
+}
+
+LazyJsonValue
+LazyJsonValue::operator[](const char *key) const
+{
+    return (*this)[std::string(key)];
+}
+
+LazyJsonValue
+LazyJsonValue::operator[](int index) const
+{
+    if (this->type() != JSON_ARRAY_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"LazyJsonValue::operator[%d]: current type is not array. [type: %s]\n%s\n", index, JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+
+    iterator iter = this->begin();
+    for (int i = 0; i < index && iter != this->end(); ++i) {
+        ++iter;
+    }
+
+    if (index < 0 || iter == this->end()) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"LazyJsonValue: out of range[index: %d]\n%s\n", index, dump_stack().c_str()));
+    }
+
+    return iter.value_;
+}
+
+int
+LazyJsonValue::size(void) const
+{
+    int count = 0;
+    for (iterator iter = this->begin(); iter != this->end(); ++iter) {
+        ++count;
+    }
+
+    return count;
+}
+
+LazyJsonValue::iterator
+LazyJsonValue::begin(void) const
+{
+    ValueType value_type = this->type();
+    if (value_type != JSON_OBJECT_TYPE && value_type != JSON_ARRAY_TYPE) {
+        return LazyJsonIterator();
+    }
+
+    return LazyJsonIterator(value_type == JSON_OBJECT_TYPE, pos_ + 1, end_);
+}
+
+LazyJsonValue::iterator
+LazyJsonValue::end(void) const
+{
+    return LazyJsonIterator();
+}
+
+JsonValue
+LazyJsonValue::to_value(void) const
+{
+    JsonValue value;
+    if (pos_ == nullptr) {
+        return value;
+    }
+
+    JsonParser parser(pos_, end_ - pos_);
+    parser.parse(value);
+
+    return value;
+}
+
+double
+LazyJsonValue::to_double(void) const
+{
+    if (this->type() != JSON_NUMBER_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not number. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+
+    JsonValue value = this->to_value();
+    return static_cast<JsonNumber>(value).to_double();
+}
+
+int64_t
+LazyJsonValue::to_int(void) const
+{
+    if (this->type() != JSON_NUMBER_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not number. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+
+    // 整数保存的是精确值，超过 2^53 也不会丢失精度
+    JsonValue value = this->to_value();
+    return static_cast<JsonNumber>(value).to_int();
+}
+
+bool
+LazyJsonValue::to_bool(void) const
+{
+    if (this->type() != JSON_BOOL_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not a bool. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+
+    JsonValue value = this->to_value();
+    return static_cast<JsonBool>(value).to_bool();
+}
+
+bool
+LazyJsonValue::is_null(void) const
+{
+    return this->type() == JSON_NULL_TYPE;
+}
+
+std::string
+LazyJsonValue::to_string(void) const
+{
+    if (this->type() != JSON_STRING_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not std::string. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+
+    const char *value_end = skip_string(pos_, end_);
+    return std::string(pos_ + 1, value_end - pos_ - 2);
+}
+
+std::string
+LazyJsonValue::raw(void) const
+{
+    if (pos_ == nullptr) {
+        return "";
+    }
+
+    return std::string(pos_, this->skip() - pos_);
+}
+
+//////////////////////////////////////////////////////////////
+
+LazyJsonIterator::LazyJsonIterator(void)
+: is_object_(false),
+  pos_(nullptr),
+  end_(nullptr),
+  key_(nullptr),
+  key_size_(0)
+{
+}
+
+LazyJsonIterator::LazyJsonIterator(bool is_object, const char *pos, const char *end)
+: is_object_(is_object),
+  pos_(pos),
+  end_(end),
+  key_(nullptr),
+  key_size_(0)
+{
+    const char *next = skip_whitespace(pos_, end_);
+    if (next < end_ && *next == (is_object_ ? '}' : ']')) {
+        pos_ = nullptr;
+        return ;
+    }
+    this->load();
+}
+
+LazyJsonIterator::~LazyJsonIterator(void)
+{
+}
+
+void
+LazyJsonIterator::load(void)
+{
+    const char *pos = skip_whitespace(pos_, end_);
+    if (pos >= end_) {
+        throw_error("Unexpected end of json text", pos_, end_);
+    }
+
+    if (is_object_) {
+        if (*pos != '"') {
+            throw_error("Object key must be a string", pos, end_);
+        }
+        const char *key_end = skip_string(pos, end_);
+        key_ = pos + 1;
+        key_size_ = key_end - pos - 2;
+
+        pos = skip_whitespace(key_end, end_);
+        if (pos >= end_ || *pos != ':') {
+            throw_error("Expected ':'", pos, end_);
+        }
+        pos = skip_whitespace(pos + 1, end_);
+    }
+
+    if (pos >= end_) {
+        throw_error("Unexpected end of json text", pos_, end_);
+    }
+    pos_ = pos;
+    value_ = LazyJsonValue(pos, end_);
+}
+
+std::string
+LazyJsonIterator::key(void) const
+{
+    if (!is_object_ || key_ == nullptr) {
+        return "";
+    }
+
+    return std::string(key_, key_size_);
+}
+
+LazyJsonIterator&
+LazyJsonIterator::operator++()
+{
+    if (pos_ == nullptr) {
+        return *this;
+    }
+
+    const char *pos = skip_whitespace(value_.skip(), end_);
+    if (pos < end_ && *pos == ',') {
+        pos_ = pos + 1;
+        this->load();
+    } else if (pos < end_ && *pos == (is_object_ ? '}' : ']')) {
+        pos_ = nullptr;
+    } else {
+        throw_error(is_object_ ? "Expected ',' or '}' in object" : "Expected ',' or ']' in array", pos, end_);
+    }
+
+    return *this;
+}
+
+bool
+LazyJsonIterator::operator==(const LazyJsonIterator &rhs) const
+{
+    return pos_ == rhs.pos_;
+}
+
+bool
+LazyJsonIterator::operator!=(const LazyJsonIterator &rhs) const
+{
+    return !(*this == rhs);
+}
+
+//////////////////////////////////////////////////////////////
+
+LazyJson::LazyJson(void)
+{
+}
+
+LazyJson::LazyJson(const char *data, ssize_t size)
+{
+    this->parse(data, size);
+}
+
+LazyJson::LazyJson(const std::string &json)
+{
+    this->parse(json);
+}
+
+LazyJson::LazyJson(const ByteBuffer &data)
+{
+    this->parse(data);
+}
+
+LazyJson::~LazyJson(void)
+{
+}
+
+void
+LazyJson::parse(const char *data, ssize_t size)
+{
+    // 找json文本的开始，如果没有遇到'{'或'['开始的会返回失败
+    const char *end = data + (size > 0 ? size : 0);
+    const char *pos = data;
+    for (; pos < end; ++pos) {
+        if (*pos == '{' || *pos == '[') {
+            break;
+        }
+    }
+
+    if (pos >= end) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Can't find any json text!\n%s\n", dump_stack().c_str()));
+    }
+    root_ = LazyJsonValue(pos, end);
+}
+
+void
+LazyJson::parse(const std::string &json)
+{
+    text_ = json;
+    this->parse(text_.c_str(), static_cast<ssize_t>(text_.size()));
+}
+
+void
+LazyJson::parse(const ByteBuffer &data)
+{
+    buffptr first = nullptr, second = nullptr;
+    ssize_t first_size = 0, second_size = 0;
+    data.get_read_segments(first, first_size, second, second_size);
+
+    text_.clear();
+    text_.reserve(first_size + second_size);
+    text_.append(first != nullptr ? first : "", first_size);
+    text_.append(second != nullptr ? second : "", second_size);
+    this->parse(text_.c_str(), static_cast<ssize_t>(text_.size()));
+}
+
+}
@@ -0,0 +1,271 @@
+#include "ndjson_reader.h"
+#include "json_parser.h"
+#include "debug.h"
+
+#include <sys/mman.h>
+#include <cerrno>
+
+namespace basic {
+
+namespace {
+
+inline bool is_space(char ch)
+{
+    return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+}
+
+// 解析一条记录，记录之后只能有空白
+void parse_record(const char *begin, const char *end, WeJson &value, JsonKeyTable *key_table)
+{
+    JsonParser parser(begin, end - begin);
+    JsonDomBuilder builder(value, nullptr, key_table);
+    ssize_t ret = 0;
+    if (*begin == '{' || *begin == '[') {
+        ret = parser.parse_document(builder);
+    } else {
+        ret = parser.parse(builder);
+    }
+
+    for (const char *pos = begin + ret; pos < end; ++pos) {
+        if (!is_space(*pos)) {
+            throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Unexpected data after json record: %c\n%s\n", *pos, dump_stack().c_str()));
+        }
+    }
+}
+
+}
+
+NdJsonReader::NdJsonReader(int thread_num)
+: key_table_(nullptr),
+  generation_(0),
+  running_(0),
+  exit_(false),
+  data_(nullptr),
+  records_(nullptr),
+  callback_(nullptr),
+  next_(0),
+  failed_(false)
+{
+    if (thread_num < 0) {
+        thread_num = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    }
+
+    for (int i = 0; i < thread_num; ++i) {
+        threads_.emplace_back(&NdJsonReader::worker_loop, this);
+    }
+}
+
+NdJsonReader::~NdJsonReader(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        exit_ = true;
+    }
+    work_cond_.notify_all();
+
+    for (std::size_t i = 0; i < threads_.size(); ++i) {
+        threads_[i].join();
+    }
+}
+
+ssize_t
+NdJsonReader::parse(const char *data, ssize_t size, std::vector<WeJson> &records)
+{
+    return this->parse_records(data, size, &records, nullptr);
+}
+
+ssize_t
+NdJsonReader::parse(const ByteBuffer &data, std::vector<WeJson> &records)
+{
+    buffptr first = nullptr, second = nullptr;
+    ssize_t first_size = 0, second_size = 0;
+    data.get_read_segments(first, first_size, second, second_size);
+
+    // 数据折返时拷贝成连续的一段再解析
+    if (second_size == 0) {
+        return this->parse_records(first, first_size, &records, nullptr);
+    }
+    std::string text(first, first_size);
+    text.append(second, second_size);
+
+    return this->parse_records(text.c_str(), text.size(), &records, nullptr);
+}
+
+ssize_t
+NdJsonReader::parse(const char *data, ssize_t size, const RecordCallback &callback)
+{
+    return this->parse_records(data, size, nullptr, &callback);
+}
+
+ssize_t
+NdJsonReader::parse_file(const std::string &path, std::vector<WeJson> &records)
+{
+    return this->parse_mapped_file(path, &records, nullptr);
+}
+
+ssize_t
+NdJsonReader::parse_file(const std::string &path, const RecordCallback &callback)
+{
+    return this->parse_mapped_file(path, nullptr, &callback);
+}
+
+ssize_t
+NdJsonReader::parse_mapped_file(const std::string &path, std::vector<WeJson> *records, const RecordCallback *callback)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Can't open %s: %s\n%s\n", path.c_str(), strerror(errno), dump_stack().c_str()));
+    }
+
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) < 0) {
+        ::close(fd);
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Can't stat %s: %s\n%s\n", path.c_str(), strerror(errno), dump_stack().c_str()));
+    }
+
+    ssize_t size = static_cast<ssize_t>(file_stat.st_size);
+    if (size == 0) {
+        ::close(fd);
+        if (records != nullptr) {
+            records->clear();
+        }
+        return 0;
+    }
+
+    void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Can't mmap %s: %s\n%s\n", path.c_str(), strerror(errno), dump_stack().c_str()));
+    }
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+
+    ssize_t ret = 0;
+    try {
+        ret = this->parse_records(static_cast<const char*>(addr), size, records, callback);
+    } catch (...) {
+        ::munmap(addr, size);
+        throw;
+    }
+    ::munmap(addr, size);
+
+    return ret;
+}
+
+ssize_t
+NdJsonReader::parse_records(const char *data, ssize_t size, std::vector<WeJson> *records, const RecordCallback *callback)
+{
+    this->split_records(data, size);
+    if (records != nullptr) {
+        records->clear();
+        records->resize(lines_.size());
+    }
+
+    data_ = data;
+    records_ = records;
+    callback_ = callback;
+    next_ = 0;
+    failed_ = false;
+    error_.clear();
+
+    // 记录较少时不唤醒工作线程
+    if (lines_.size() <= NDJSON_BATCH_RECORDS || threads_.empty()) {
+        this->run_job();
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = static_cast<int>(threads_.size());
+            ++generation_;
+        }
+        work_cond_.notify_all();
+
+        this->run_job();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cond_.wait(lock, [this]() {return running_ == 0;});
+    }
+
+    records_ = nullptr;
+    callback_ = nullptr;
+    if (failed_) {
+        throw std::runtime_error(error_);
+    }
+
+    return static_cast<ssize_t>(lines_.size());
+}
+
+void
+NdJsonReader::split_records(const char *data, ssize_t size)
+{
+    lines_.clear();
+
+    const char *pos = data;
+    const char *end = data + (size > 0 ? size : 0);
+    while (pos < end) {
+        const char *line_end = static_cast<const char*>(memchr(pos, '\n', end - pos));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+
+        for (; pos < line_end && is_space(*pos); ++pos) {}
+        if (pos < line_end) {
+            lines_.push_back(std::make_pair(pos, line_end));
+        }
+        pos = line_end + 1;
+    }
+}
+
+void
+NdJsonReader::run_job(void)
+{
+    while (!failed_) {
+        std::size_t begin = next_.fetch_add(NDJSON_BATCH_RECORDS);
+        if (begin >= lines_.size()) {
+            break;
+        }
+        std::size_t end = std::min(begin + NDJSON_BATCH_RECORDS, lines_.size());
+
+        for (std::size_t i = begin; i < end; ++i) {
+            try {
+                WeJson local;
+                WeJson &value = (records_ != nullptr ? (*records_)[i] : local);
+                parse_record(lines_[i].first, lines_[i].second, value, key_table_);
+                if (callback_ != nullptr) {
+                    (*callback_)(i, value);
+                }
+            } catch (std::exception &e) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!failed_) {
+                    error_ = GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"NdJsonReader: record %lu at offset %ld: %s\n",
+                                static_cast<unsigned long>(i), static_cast<long>(lines_[i].first - data_), e.what());
+                    failed_ = true;
+                }
+                return ;
+            }
+        }
+    }
+}
+
+void
+NdJsonReader::worker_loop(void)
+{
+    uint64_t generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cond_.wait(lock, [this, generation]() {return exit_ || generation_ != generation;});
+            if (exit_) {
+                return ;
+            }
+            generation = generation_;
+        }
+
+        this->run_job();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--running_ == 0) {
+            done_cond_.notify_all();
+        }
+    }
+}
+
+}
@@ -1,4 +1,7 @@
 #include "wejson.h"
+#include "json_parser.h"
+#include "json_writer.h"
+#include "json_cbor.h"
 #include "debug.h"
 
 namespace basic {
@@ -83,16 +86,44 @@ JsonType::value_type_to_string(ValueType type)
 ///////////////////////////////////////////////////////////
 
 JsonNumber::JsonNumber(void)
-: value_(0)
 {
-
+    value_.kind = JSON_NUMBER_INT;
+    value_.i = 0;
 }
 
 JsonNumber::JsonNumber(const double &val)
-: value_(val)
 {
+    value_.kind = JSON_NUMBER_DOUBLE;
+    value_.d = val;
+}
+
+JsonNumber::JsonNumber(const int &val)
+{
+    value_.kind = JSON_NUMBER_INT;
+    value_.i = val;
+}
+
+JsonNumber::JsonNumber(const int64_t &val)
+{
+    value_.kind = JSON_NUMBER_INT;
+    value_.i = val;
 }
 
+JsonNumber::JsonNumber(const uint64_t &val)
+{
+    if (val <= static_cast<uint64_t>(INT64_MAX)) {
+        value_.kind = JSON_NUMBER_INT;
+        value_.i = static_cast<int64_t>(val);
+    } else {
+        value_.kind = JSON_NUMBER_UINT;
+        value_.u = val;
+    }
+}
+
+JsonNumber::JsonNumber(const JsonNumberLiteral &val)
+: value_(val)
+{
+}
 
 JsonNumber::~JsonNumber(void) {}
 
@@ -101,56 +132,92 @@ JsonNumber::parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &j
 {
     ByteBuffer::iterator iter = value_start_pos;
     std::string str;
-    bool is_negative = false;
-
-    if (*iter == '-') {
-        is_negative = true;
-        ++iter;
-    } else if (*iter == '+') {
-        is_negative = false;
-        ++iter;
-    }
-
-    if (iter != json_end_pos && *iter == '0') {
-        if (isdigit(*(iter+1))) { // 除了小数和数值0之外，零不能作为第一个数
-            throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR, "Zero can't be first number of integer!\n%s\n", dump_stack().c_str()));
-        }
-    }
-
-    for (; iter != json_end_pos && *iter != ','; ++iter) {
-        if (!isdigit(*iter) && *iter != '.') {
+    for (; iter != json_end_pos; ++iter) {
+        char ch = *iter;
+        if (!isdigit(ch) && ch != '-' && ch != '+' && ch != '.' && ch != 'e' && ch != 'E') {
             break;
         }
-
-        str += *iter;
+        str += ch;
     }
 
-    value_ = stod(str) * (is_negative?-1:1);
+    const char *error = nullptr;
+    const char *pos = parse_json_number(str.data(), str.data() + str.size(), value_, &error);
+    if (pos == nullptr) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR, "%s: %s\n%s\n", error, str.c_str(), dump_stack().c_str()));
+    }
 
-    return iter;
+    return value_start_pos + (pos - str.data());
 }
 
 std::string 
 JsonNumber::to_string(void) const
 {
-    char buf[256] = {0};
-    snprintf(buf, 256, "%lf", value_);
+    char buf[JSON_NUMBER_BUFFER_SIZE];
+    return std::string(buf, this->to_chars(buf) - buf);
+}
+
+char*
+JsonNumber::to_chars(char *buf) const
+{
+    switch (value_.kind)
+    {
+        case JSON_NUMBER_INT:
+            return format_json_int(value_.i, buf);
+        case JSON_NUMBER_UINT:
+            return format_json_uint(value_.u, buf);
+        default:
+            break;
+    }
 
-    int j = 255;
-    for (; j >=0; --j) {
-        if (buf[j] == '.') {
+    return format_json_double(value_.d, buf);
+}
+
+double
+JsonNumber::to_double(void) const
+{
+    switch (value_.kind)
+    {
+        case JSON_NUMBER_INT:
+            return static_cast<double>(value_.i);
+        case JSON_NUMBER_UINT:
+            return static_cast<double>(value_.u);
+        default:
             break;
-        }
     }
 
-    for (int i = 255; j >= 0 && i >= j; --i) {
-        if (buf[i] <= '9' && buf[i] > '0') {
+    return value_.d;
+}
+
+uint64_t
+JsonNumber::to_uint(void) const
+{
+    switch (value_.kind)
+    {
+        case JSON_NUMBER_INT:
+            return static_cast<uint64_t>(value_.i);
+        case JSON_NUMBER_UINT:
+            return value_.u;
+        default:
             break;
-        }
-        buf[i] = '\0';
     }
 
-    return buf;
+    return static_cast<uint64_t>(value_.d);
+}
+
+int64_t
+JsonNumber::to_int(void) const
+{
+    switch (value_.kind)
+    {
+        case JSON_NUMBER_INT:
+            return value_.i;
+        case JSON_NUMBER_UINT:
+            return static_cast<int64_t>(value_.u);
+        default:
+            break;
+    }
+
+    return static_cast<int64_t>(value_.d);
 }
 
 std::ostream& 
@@ -164,11 +231,15 @@ operator<<(std::ostream &os, JsonNumber &rhs)
 bool
 JsonNumber::operator==(const JsonNumber& rhs) const
 {
-   if (value_ == rhs.value_) {
-       return true;
-   }
+    // 两个都是整数时比较精确值
+    if (this->is_integer() && rhs.is_integer()) {
+        if (value_.kind == rhs.value_.kind) {
+            return value_.u == rhs.value_.u;
+        }
+        return false; // 一个是负数或小于 INT64_MAX，另一个大于 INT64_MAX
+    }
 
-    return false;
+    return this->to_double() == rhs.to_double();
 }
 bool 
 JsonNumber::operator!=(const JsonNumber& rhs) const
@@ -179,11 +250,7 @@ JsonNumber::operator!=(const JsonNumber& rhs) const
 bool
 JsonNumber::operator==(const double& rhs) const
 {
-   if (value_ == rhs) {
-       return true;
-   }
-
-    return false;
+    return this->to_double() == rhs;
 }
 bool 
 JsonNumber::operator!=(const double& rhs) const
@@ -356,8 +423,9 @@ JsonNull::operator=(JsonNull rhs)
 ///////////////////////////////////////////////////////////
 
 JsonString::JsonString(void) {}
-JsonString::JsonString(const std::string val): value_(val) {}
+JsonString::JsonString(const std::string val): value_(val.data(), val.size()) {}
 JsonString::JsonString(const char *val): value_(val) {};
+JsonString::JsonString(const char *str, ssize_t size): value_(str, size) {}
 JsonString::~JsonString(void) {}
 
 ByteBuffer::iterator 
@@ -383,7 +451,7 @@ JsonString::parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &j
     {
         throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"String need to surround by \"\"\n%s\n", dump_stack().c_str()));
     }
-    value_ = str;
+    value_.assign(str.data(), str.size());
     ++iter; //  iter 指向下一个字符
     return iter;
 }
@@ -391,7 +459,7 @@ JsonString::parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &j
 std::string 
 JsonString::to_string(void) const
 {
-    return value_;
+    return std::string(value_.data(), value_.size());
 }
 
 std::ostream& operator<<(std::ostream &os, JsonString &rhs)
@@ -417,7 +485,7 @@ bool JsonString::operator!=(const JsonString& rhs) const
 
 bool JsonString::operator==(const std::string& rhs) const
 {
-    if (value_ != rhs) {
+    if (value_.size() != rhs.size() || value_.compare(0, value_.size(), rhs.data(), rhs.size()) != 0) {
         return false;
     }
 
@@ -439,11 +507,27 @@ JsonString::operator=(JsonString rhs)
 
 ///////////////////////////////////////////////////////////
 
-JsonObject::JsonObject(void) {}
+JsonObject::JsonObject(void): refs_(1) {}
+JsonObject::JsonObject(JsonArena *arena): value_(member_array::allocator_type(arena)), index_(member_array::allocator_type(arena)), refs_(1) {}
 JsonObject::JsonObject(const JsonObject &jobj)
+: refs_(1)
 {
     *this = jobj;
 }
+JsonObject::JsonObject(JsonObject &&jobj)
+: refs_(1)
+{
+    // arena 中的成员拷贝到堆上，arena 可能随文档一起释放
+    if (jobj.value_.get_allocator().arena() != nullptr) {
+        *this = jobj;
+        jobj.clear();
+        return ;
+    }
+
+    value_.swap(jobj.value_);
+    index_.swap(jobj.index_);
+    this->detach_members();
+}
 JsonObject::~JsonObject(void) {}
 
 ByteBuffer::iterator 
@@ -479,44 +563,47 @@ JsonObject::parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &j
             {
                 JsonObject val;
                 iter = val.parse(iter, json_end_pos);
-                vtc = val;
+                vtc = std::move(val);
             } break;
             case JSON_ARRAY_TYPE:
             {
                 JsonArray val;
                 iter = val.parse(iter, json_end_pos);
-                vtc = val;
+                vtc = std::move(val);
             } break;
             case JSON_STRING_TYPE:
             {
                 JsonString val;
                 iter = val.parse(iter, json_end_pos);
-                vtc = val;
+                vtc = std::move(val);
             } break;
             case JSON_BOOL_TYPE:
             {
                 JsonBool val;
                 iter = val.parse(iter, json_end_pos);
-                vtc = val;
+                vtc = std::move(val);
             } break;
             case JSON_NULL_TYPE:
             {
                 JsonNull val;
                 iter = val.parse(iter, json_end_pos);
-                vtc = val;
+                vtc = std::move(val);
             } break;
             case JSON_NUMBER_TYPE:
             {
                 JsonNumber val;
                 iter = val.parse(iter, json_end_pos);
-                vtc = val;
+                vtc = std::move(val);
             } break;
         default:
             break;
         }
 
-        if (value_.find(value_name) == value_.end()) {
-            value_[value_name] = vtc;
+        if (this->find_pos(value_name.data(), value_name.size()) < 0) {
+            this->reserve_one();
+            value_.emplace_back(std::piecewise_construct, std::forward_as_tuple(value_name.data(), value_name.size()), std::forward_as_tuple());
+            value_.back().second.swap(vtc);
+            this->insert_index(value_.size() - 1);
         } else {
             throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"The \"%s\" is already exists.\n%s\n", value_name.c_str(), dump_stack().c_str()));
         }
@@ -536,66 +623,199 @@ JsonObject::parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &j
 std::string 
 JsonObject::to_string(void) const
 {
-    std::ostringstream output_obj;
-    output_obj << "{";
-    for (auto iter = value_.begin(); iter != value_.end(); ++iter) {
-        if (iter != value_.begin()) {
-            output_obj << ",";
-        }
-
-        output_obj << "\"" << iter->first << "\"";
-        output_obj << ":";
-        switch (iter->second.type_)
-        {
-            case JSON_ARRAY_TYPE: {
-                output_obj << dynamic_cast<JsonArray*>(iter->second.value_)->to_string();
-            } break;
-            case JSON_OBJECT_TYPE: {
-                output_obj << dynamic_cast<JsonObject*>(iter->second.value_)->to_string();
-            } break;
-            case JSON_STRING_TYPE: {
-                output_obj << "\"" << dynamic_cast<JsonString*>(iter->second.value_)->to_string() << "\"";
-            } break;
-            case JSON_NUMBER_TYPE: {
-                output_obj << dynamic_cast<JsonNumber*>(iter->second.value_)->to_string();
-            } break;
-            case JSON_BOOL_TYPE: {
-                output_obj << dynamic_cast<JsonBool*>(iter->second.value_)->to_string();
-            } break;
-            default: {
-                output_obj << JsonNull().to_string();
-            }
-        }
-    }
-    output_obj << "}";
+    std::string out;
+    JsonWriter(out).write(*this);
 
-    return output_obj.str();
+    return out;
 }
 
 JsonObject::iterator
 JsonObject::find(const std::string &key)
 {
-    auto iter = value_.find(key);
-    return iter;
+    ssize_t pos = this->find_pos(key.data(), key.size());
+    return pos < 0 ? value_.end() : value_.begin() + pos;
+}
+
+JsonObject::const_iterator
+JsonObject::find(const std::string &key) const
+{
+    ssize_t pos = this->find_pos(key.data(), key.size());
+    return pos < 0 ? value_.end() : value_.begin() + pos;
+}
+
+JsonObject::iterator
+JsonObject::find(const JsonKey &key)
+{
+    ssize_t pos = this->find_pos(key);
+    return pos < 0 ? value_.end() : value_.begin() + pos;
 }
 
 int JsonObject::erase(const std::string &key)
 {
-    return static_cast<int>(value_.erase(key));
+    ssize_t pos = this->find_pos(key.data(), key.size());
+    if (pos < 0) {
+        return 0;
+    }
+
+    this->remove_at(static_cast<std::size_t>(pos));
+    this->rebuild_index();
+    return 1;
 }
 
 JsonObject::iterator
 JsonObject::erase(JsonObject::iterator &remove_iter)
 {
-    return value_.erase(remove_iter);
+    std::size_t pos = static_cast<std::size_t>(remove_iter - value_.begin());
+    this->remove_at(pos);
+    this->rebuild_index();
+    return value_.begin() + pos;
 }
 
 int JsonObject::add(const std::string &key, const JsonValue &value)
 {
-    value_[key] = value;
+    ssize_t pos = this->find_pos(key.data(), key.size());
+    if (pos >= 0) {
+        value_[pos].second = value;
+        return 0;
+    }
+
+    this->reserve_one();
+    value_.emplace_back(JsonKey(key), value);
+    this->insert_index(value_.size() - 1);
+    return 0;
+}
+
+int JsonObject::add(const std::string &key, JsonValue &&value)
+{
+    // 其他 arena 中的值拷贝过来，同一个 arena 中的值直接接管
+    if (value.is_foreign(value_.get_allocator().arena())) {
+        return this->add(key, static_cast<const JsonValue&>(value));
+    }
+
+    ssize_t pos = this->find_pos(key.data(), key.size());
+    if (pos >= 0) {
+        JsonValue old;
+        old.swap(value_[pos].second);
+        value_[pos].second.swap(value);
+        return 0;
+    }
+
+    this->reserve_one();
+    value_.emplace_back(std::piecewise_construct, std::forward_as_tuple(key.data(), key.size()), std::forward_as_tuple());
+    value_.back().second.swap(value);
+    this->insert_index(value_.size() - 1);
     return 0;
 }
 
+void
+JsonObject::clear(void)
+{
+    value_.clear();
+    index_.clear();
+}
+
+ssize_t
+JsonObject::find_pos(const char *key, std::size_t size) const
+{
+    // 成员较少时顺序比较，连续的内存比哈希更快
+    if (index_.empty()) {
+        for (std::size_t i = 0; i < value_.size(); ++i) {
+            if (value_[i].first.equals(key, size)) {
+                return static_cast<ssize_t>(i);
+            }
+        }
+        return -1;
+    }
+
+    std::size_t mask = index_.size() - 1;
+    for (std::size_t slot = JsonKey::hash_string(key, size) & mask; index_[slot] != 0; slot = (slot + 1) & mask) {
+        if (value_[index_[slot] - 1].first.equals(key, size)) {
+            return static_cast<ssize_t>(index_[slot] - 1);
+        }
+    }
+
+    return -1;
+}
+
+ssize_t
+JsonObject::find_pos(const JsonKey &key) const
+{
+    if (index_.empty()) {
+        for (std::size_t i = 0; i < value_.size(); ++i) {
+            if (value_[i].first == key) {
+                return static_cast<ssize_t>(i);
+            }
+        }
+        return -1;
+    }
+
+    std::size_t mask = index_.size() - 1;
+    for (std::size_t slot = key.hash() & mask; index_[slot] != 0; slot = (slot + 1) & mask) {
+        if (value_[index_[slot] - 1].first == key) {
+            return static_cast<ssize_t>(index_[slot] - 1);
+        }
+    }
+
+    return -1;
+}
+
+void
+JsonObject::rebuild_index(bool check_duplicate)
+{
+    if (value_.size() <= JSON_OBJECT_INDEX_THRESHOLD) {
+        index_.clear();
+        if (check_duplicate) {
+            for (std::size_t i = 1; i < value_.size(); ++i) {
+                if (this->find_pos(value_[i].first) != static_cast<ssize_t>(i)) {
+                    throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"The \"%s\" is already exists.\n%s\n", value_[i].first.c_str(), dump_stack().c_str()));
+                }
+            }
+        }
+        return;
+    }
+
+    // 装载率不超过一半
+    std::size_t capacity = JSON_OBJECT_INDEX_THRESHOLD * 4;
+    while (capacity < value_.size() * 2) {
+        capacity <<= 1;
+    }
+    index_.assign(capacity, 0);
+
+    std::size_t mask = capacity - 1;
+    for (std::size_t i = 0; i < value_.size(); ++i) {
+        const JsonKey &key = value_[i].first;
+        std::size_t slot = key.hash() & mask;
+        for (; index_[slot] != 0; slot = (slot + 1) & mask) {
+            if (check_duplicate && value_[index_[slot] - 1].first == key) {
+                throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"The \"%s\" is already exists.\n%s\n", key.c_str(), dump_stack().c_str()));
+            }
+        }
+        index_[slot] = static_cast<uint32_t>(i + 1);
+    }
+}
+
+void
+JsonObject::insert_index(std::size_t pos)
+{
+    if (index_.empty()) {
+        if (value_.size() > JSON_OBJECT_INDEX_THRESHOLD) {
+            this->rebuild_index();
+        }
+        return;
+    }
+    if (value_.size() * 2 > index_.size()) {
+        this->rebuild_index();
+        return;
+    }
+
+    std::size_t mask = index_.size() - 1;
+    std::size_t slot = value_[pos].first.hash() & mask;
+    while (index_[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    index_[slot] = static_cast<uint32_t>(pos + 1);
+}
+
 std::ostream& operator<<(std::ostream &os, JsonObject &rhs)
 {
     os << rhs.to_string();
@@ -610,25 +830,14 @@ JsonObject::operator==(const JsonObject& rhs) const
         return false;
     }
 
-    auto iter_this = this->value_.begin();
-    auto iter_rhs = rhs.value_.begin();
-    while (iter_rhs != rhs.value_.end() && iter_this != this->value_.end()) {
-        if (iter_this->first != iter_rhs->first) {
-            return false;
-        }
-
-        if (iter_this->second != iter_rhs->second) {
+    for (auto iter = value_.begin(); iter != value_.end(); ++iter) {
+        ssize_t pos = rhs.find_pos(iter->first);
+        if (pos < 0 || iter->second != rhs.value_[pos].second) {
             return false;
         }
-        iter_this++;
-        iter_rhs++;
     }
 
-    if (iter_rhs == rhs.value_.end() && iter_this == this->value_.end()) {
-        return true;
-    }
-
-    return false;
+    return true;
 }
 
 bool 
@@ -640,16 +849,115 @@ JsonObject::operator!=(const JsonObject& rhs) const
 JsonValue& 
 JsonObject::operator[](const std::string &key)
 {
-    if (value_.find(key) == value_.end()) {
+    ssize_t pos = this->find_pos(key.data(), key.size());
+    if (pos < 0) {
         throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonObject: out of range.[key: %s]\n%s\n", key.c_str(), dump_stack().c_str()));
     }
-    return value_[key];
+    return value_[pos].second;
+}
+
+const JsonValue& 
+JsonObject::operator[](const std::string &key) const
+{
+    ssize_t pos = this->find_pos(key.data(), key.size());
+    if (pos < 0) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonObject: out of range.[key: %s]\n%s\n", key.c_str(), dump_stack().c_str()));
+    }
+    return value_[pos].second;
+}
+
+void
+JsonObject::reserve_one(void)
+{
+    if (value_.size() < value_.capacity()) {
+        return ;
+    }
+
+    // 成员的移动会把 arena 中的值拷贝出来，扩容时逐个交换到新的内存中
+    member_array members(value_.get_allocator());
+    members.reserve(value_.empty() ? 4 : value_.size() * 2);
+    for (auto iter = value_.begin(); iter != value_.end(); ++iter) {
+        members.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::move(iter->first)), std::forward_as_tuple());
+        members.back().second.swap(iter->second);
+    }
+    value_.swap(members);
+}
+
+void
+JsonObject::remove_at(std::size_t pos)
+{
+    // 之后的成员逐个交换到前面，被删除的值交换到末尾再释放
+    for (std::size_t i = pos; i + 1 < value_.size(); ++i) {
+        value_[i].first = std::move(value_[i + 1].first);
+        value_[i].second.swap(value_[i + 1].second);
+    }
+    value_.pop_back();
+}
+
+void
+JsonObject::detach_members(void)
+{
+    // 写时复制出来的堆上的对象，成员仍然可能在文档的 arena 中
+    for (auto iter = value_.begin(); iter != value_.end(); ++iter) {
+        iter->second.detach(nullptr);
+    }
+}
+
+bool
+JsonObject::is_shared(void) const
+{
+    JsonArena *arena = value_.get_allocator().arena();
+    return refs_.load(std::memory_order_acquire) > 1 || (arena != nullptr && arena->is_shared());
 }
 
 JsonObject& 
 JsonObject::operator=(const JsonObject &rhs)
 {
     value_ = rhs.value_;
+    index_ = rhs.index_;
+
+    return *this;
+}
+
+JsonObject& 
+JsonObject::operator=(JsonObject &&rhs)
+{
+    if (this == &rhs) {
+        return *this;
+    }
+
+    // 先把 rhs 的成员取出来再释放原来的成员，rhs 可能是当前对象的子节点
+    if (value_.get_allocator() == rhs.value_.get_allocator()) {
+        // 同一个 arena 或是都在堆上，直接接管 rhs 的数组
+        member_array members(std::move(rhs.value_));
+        std::vector<uint32_t, JsonAllocator<uint32_t>> index(std::move(rhs.index_));
+        value_.swap(members);
+        index_.swap(index);
+        if (value_.get_allocator().arena() == nullptr) {
+            this->detach_members();
+        }
+    } else {
+        // 逐个移动成员，其他 arena 中的 key 和值拷贝过来
+        member_array members(value_.get_allocator());
+        members.reserve(rhs.value_.size());
+        JsonArena *arena = value_.get_allocator().arena();
+        bool in_arena = rhs.value_.get_allocator().arena() != nullptr;
+        for (auto iter = rhs.value_.begin(); iter != rhs.value_.end(); ++iter) {
+            if (in_arena) {
+                members.emplace_back(std::piecewise_construct, std::forward_as_tuple(iter->first), std::forward_as_tuple());
+            } else {
+                members.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::move(iter->first)), std::forward_as_tuple());
+            }
+            if (iter->second.is_foreign(arena)) {
+                members.back().second = iter->second;
+            } else {
+                members.back().second.swap(iter->second);
+            }
+        }
+        rhs.clear();
+        value_.swap(members);
+        this->rebuild_index();
+    }
 
     return *this;
 }
@@ -668,11 +976,26 @@ JsonObject::end()
 
 ////////////////////////////////////////////////////////////
 
-JsonArray::JsonArray(void){}
+JsonArray::JsonArray(void): refs_(1) {}
+JsonArray::JsonArray(JsonArena *arena): value_(array_type::allocator_type(arena)), refs_(1) {}
 JsonArray::JsonArray(JsonArray &jarr)
+: refs_(1)
 {
     *this = jarr;
 }
+JsonArray::JsonArray(JsonArray &&jarr)
+: refs_(1)
+{
+    // arena 中的元素拷贝到堆上，arena 可能随文档一起释放
+    if (jarr.value_.get_allocator().arena() != nullptr) {
+        *this = jarr;
+        jarr.clear();
+        return ;
+    }
+
+    value_.swap(jarr.value_);
+    this->detach_values();
+}
 JsonArray::~JsonArray(void){}
 
 ByteBuffer::iterator 
@@ -698,43 +1021,45 @@ JsonArray::parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &js
             {
                 JsonObject val;
                 iter = val.parse(iter, json_end_pos);
-                vtc = val;
+                vtc = std::move(val);
             } break;
             case JSON_ARRAY_TYPE:
             {
                 JsonArray val;
                 iter = val.parse(iter, json_end_pos);
-                vtc = val;
+                vtc = std::move(val);
             } break;
             case JSON_STRING_TYPE:
             {
                 JsonString val;
                 iter = val.parse(iter, json_end_pos);
-                vtc = val;
+                vtc = std::move(val);
             } break;
             case JSON_BOOL_TYPE:
             {
                 JsonBool val;
                 iter = val.parse(iter, json_end_pos);
-                vtc = val;
+                vtc = std::move(val);
             } break;
             case JSON_NULL_TYPE:
             {
                 JsonNull val;
                 iter = val.parse(iter, json_end_pos);
-                vtc = val;
+                vtc = std::move(val);
             } break;
             case JSON_NUMBER_TYPE:
             {
                 JsonNumber val;
                 iter = val.parse(iter, json_end_pos);
-                vtc = val;
+                vtc = std::move(val);
             } break;
         default:
             break;
         }
         
-        value_.push_back(vtc);
+        this->reserve_one();
+        value_.emplace_back();
+        value_.back().swap(vtc);
         if (iter != json_end_pos && *iter == ']') { // 有些解析玩就直接指向']'， 如果不退出在回到循环会因值自增错过
             break;
         }
@@ -748,60 +1073,48 @@ JsonArray::parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &js
 std::string 
 JsonArray::to_string(void) const
 {
-    std::ostringstream output_arr;
-    output_arr << "[";
-    for (auto iter = value_.begin(); iter != value_.end(); ++iter) {
-        if (iter != value_.begin()) { // 每输出一个类型后跟一个','
-            output_arr << ",";
-        }
-        switch (iter->type_)
-        {
-            case JSON_ARRAY_TYPE: {
-                output_arr << dynamic_cast<JsonArray*>(iter->value_)->to_string();
-            } break;
-            case JSON_OBJECT_TYPE: {
-                output_arr << dynamic_cast<JsonObject*>(iter->value_)->to_string();
-            } break;
-            case JSON_STRING_TYPE: {
-                output_arr << "\"" << dynamic_cast<JsonString*>(iter->value_)->to_string() << "\"";
-            } break;
-            case JSON_NUMBER_TYPE: {
-                output_arr << dynamic_cast<JsonNumber*>(iter->value_)->to_string();
-            } break;
-            case JSON_BOOL_TYPE: {
-                output_arr << dynamic_cast<JsonBool*>(iter->value_)->to_string();
-            } break;
-            default: {
-                output_arr << JsonNull().to_string();
-            }
-        }
-    }
+    std::string out;
+    JsonWriter(out).write(*this);
 
-    output_arr <<  "]";
-    return output_arr.str();
+    return out;
 }
 
 
 int JsonArray::add(const JsonValue &value)
 {
+    this->reserve_one();
     value_.push_back(value);
 
     return 1;
 }
 
+int JsonArray::add(JsonValue &&value)
+{
+    // 其他 arena 中的值拷贝过来，同一个 arena 中的值直接接管
+    if (value.is_foreign(value_.get_allocator().arena())) {
+        return this->add(static_cast<const JsonValue&>(value));
+    }
+
+    this->reserve_one();
+    value_.emplace_back();
+    value_.back().swap(value);
+
+    return 1;
+}
+
 JsonArray::iterator 
 JsonArray::erase(const int &index)
 {
-    auto remove_iter = value_.begin();
-    // 移动迭代器index个距离
-    advance(remove_iter, index);
-    return value_.erase(remove_iter);
+    this->remove_at(static_cast<std::size_t>(index));
+    return value_.begin() + index;
 }
 
 JsonArray::iterator 
 JsonArray::erase(const JsonArray::iterator &remove_iter)
 {
-    return value_.erase(remove_iter);
+    std::size_t pos = static_cast<std::size_t>(remove_iter - value_.begin());
+    this->remove_at(pos);
+    return value_.begin() + pos;
 }
 
 std::ostream& operator<<(std::ostream &os, JsonArray &rhs)
@@ -821,6 +1134,57 @@ JsonArray::operator[](size_t key)
     return value_[key];
 }
 
+const JsonValue& 
+JsonArray::operator[](const size_t key) const
+{
+    if (key >= value_.size()) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonArray: out of range[index: %d]\n%s", key, dump_stack().c_str()));
+    }
+
+    return value_[key];
+}
+
+void
+JsonArray::reserve_one(void)
+{
+    if (value_.size() < value_.capacity()) {
+        return ;
+    }
+
+    // 和 JsonObject 一样，扩容时逐个交换到新的内存中
+    array_type values(value_.get_allocator());
+    values.reserve(value_.empty() ? 4 : value_.size() * 2);
+    for (auto iter = value_.begin(); iter != value_.end(); ++iter) {
+        values.emplace_back();
+        values.back().swap(*iter);
+    }
+    value_.swap(values);
+}
+
+void
+JsonArray::remove_at(std::size_t pos)
+{
+    for (std::size_t i = pos; i + 1 < value_.size(); ++i) {
+        value_[i].swap(value_[i + 1]);
+    }
+    value_.pop_back();
+}
+
+void
+JsonArray::detach_values(void)
+{
+    for (auto iter = value_.begin(); iter != value_.end(); ++iter) {
+        iter->detach(nullptr);
+    }
+}
+
+bool
+JsonArray::is_shared(void) const
+{
+    JsonArena *arena = value_.get_allocator().arena();
+    return refs_.load(std::memory_order_acquire) > 1 || (arena != nullptr && arena->is_shared());
+}
+
 bool 
 JsonArray::operator==(const JsonArray& rhs) const
 {
@@ -828,7 +1192,7 @@ JsonArray::operator==(const JsonArray& rhs) const
         return false;
     }
 
-    for (std::size_t i = 0; i > value_.size(); ++i) {
+    for (std::size_t i = 0; i < value_.size(); ++i) {
         if (value_[i].type_ != rhs.value_[i].type_) {
             return false;
         }
@@ -853,6 +1217,40 @@ JsonArray::operator=(const JsonArray &rhs)
     return *this;
 }
 
+JsonArray& 
+JsonArray::operator=(JsonArray &&rhs)
+{
+    if (this == &rhs) {
+        return *this;
+    }
+
+    // 先把 rhs 的元素取出来再释放原来的元素，rhs 可能是当前数组的子节点
+    if (value_.get_allocator() == rhs.value_.get_allocator()) {
+        array_type values(std::move(rhs.value_));
+        value_.swap(values);
+        if (value_.get_allocator().arena() == nullptr) {
+            this->detach_values();
+        }
+    } else {
+        // 逐个移动元素，其他 arena 中的值拷贝过来
+        array_type values(value_.get_allocator());
+        values.reserve(rhs.value_.size());
+        JsonArena *arena = value_.get_allocator().arena();
+        for (auto iter = rhs.value_.begin(); iter != rhs.value_.end(); ++iter) {
+            if (iter->is_foreign(arena)) {
+                values.push_back(*iter);
+            } else {
+                values.emplace_back();
+                values.back().swap(*iter);
+            }
+        }
+        rhs.value_.clear();
+        value_.swap(values);
+    }
+
+    return *this;
+}
+
 JsonArray::iterator 
 JsonArray::begin()
 {
@@ -868,137 +1266,494 @@ JsonArray::end()
 /////////////////////////////////////////////////////////////////
 
 JsonValue::JsonValue(void) 
-:type_(JSON_NULL_TYPE)
+: type_(JSON_NULL_TYPE),
+  in_arena_(0),
+  kind_(JSON_NUMBER_DOUBLE),
+  size_(0),
+  number_(0)
 {
-    value_ = new JsonNull();
+    static_assert(sizeof(JsonValue) == 16, "JsonValue should be 16 bytes");
 }
 
 JsonValue::JsonValue(const JsonBool &value)
-    : type_(JSON_BOOL_TYPE)
+: JsonValue()
 {
-    value_ = new JsonBool(value.to_bool());
+    this->set_bool(value.to_bool());
 }
     
 JsonValue::JsonValue(const JsonNumber &value)
-    : type_(JSON_NUMBER_TYPE)
+: JsonValue()
 {
-    value_ = new JsonNumber(value.to_double());
+    this->set_number(value);
 }
 
 JsonValue::JsonValue(const JsonString &value)
-    : type_(JSON_STRING_TYPE)
+: JsonValue()
 {
-    value_ = new JsonString(value.to_string());
+    this->set_string(value.value_.data(), value.value_.size());
 }
 
 JsonValue::JsonValue(const JsonObject &value)
-    : type_(JSON_OBJECT_TYPE)
+: JsonValue()
 {
-    JsonObject *object = new JsonObject();
-    *object = value;
-    value_ = object;
+    *this = value;
 }
 
 JsonValue::JsonValue(const JsonArray &value)
-    : type_(JSON_ARRAY_TYPE)
+: JsonValue()
 {
-    JsonArray *array = new JsonArray();
-    *array = value;
-    value_ = array;
+    *this = value;
 }
 
 JsonValue::JsonValue(const JsonNull &value)
-    : type_(JSON_NULL_TYPE)
+: JsonValue()
 {
-    value_ = new JsonNull();
 }
 
 JsonValue::JsonValue(const JsonValue &value)
-    : type_(value.type_)
+: JsonValue()
 {
-    this->copy(value, false);
+    this->copy(value);
 }
 
-JsonValue::JsonValue(const bool &value)
-    :type_(JSON_BOOL_TYPE)
+JsonValue::JsonValue(JsonValue &&value)
+: JsonValue()
 {
-    value_ = new JsonBool(value);
-}
+    // 不知道移动到哪里，arena 中的值拷贝到堆上，arena 可能随文档一起释放
+    // 文档内部的移动由对象和数组直接交换，不经过这里
+    if (value.in_arena_ != 0) {
+        this->copy(value);
+        value.release();
+        return ;
+    }
+
+    this->swap(value);
+}
+
+JsonValue::JsonValue(JsonObject &&value)
+: JsonValue()
+{
+    *this = std::move(value);
+}
+
+JsonValue::JsonValue(JsonArray &&value)
+: JsonValue()
+{
+    *this = std::move(value);
+}
+
+JsonValue::JsonValue(const bool &value)
+: JsonValue()
+{
+    this->set_bool(value);
+}
 
 JsonValue::JsonValue(const int &value)
-    :type_(JSON_NUMBER_TYPE)
+: JsonValue()
+{
+    this->set_int(value);
+}
+
+JsonValue::JsonValue(const int64_t &value)
+: JsonValue()
 {
-    value_ = new JsonNumber(value);
+    this->set_int(value);
+}
+
+JsonValue::JsonValue(const uint64_t &value)
+: JsonValue()
+{
+    this->set_number(JsonNumber(value));
 }
 
 JsonValue::JsonValue(const double &value)
-    :type_(JSON_NUMBER_TYPE)
+: JsonValue()
 {
-    value_ = new JsonNumber(value);
+    this->set_number(value);
 }
 
 JsonValue::JsonValue(const std::string &value)
-    :type_(JSON_STRING_TYPE)
+: JsonValue()
 {
-    value_ = new JsonString(value);
+    this->set_string(value.data(), value.size());
 }
 
 JsonValue::JsonValue(const char *value)
-    :type_(JSON_STRING_TYPE)
+: JsonValue()
 {
-    value_ = new JsonString(value);
+    this->set_string(value, strlen(value));
 }
 
 JsonValue::~JsonValue(void) 
 {
-    if (value_ != nullptr) {
-        delete value_;
-        value_ = nullptr;
+    this->release();
+}
+
+void
+JsonValue::release(void)
+{
+    switch (type_)
+    {
+        case JSON_STRING_TYPE: {
+            if (in_arena_ == 0) {
+                delete[] string_;
+            }
+        } break;
+        case JSON_OBJECT_TYPE: {
+            // 最后一个引用释放时才销毁
+            if (object_->refs_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                break;
+            }
+            if (in_arena_ == 1) {
+                object_->~JsonObject();
+            } else {
+                delete object_;
+            }
+        } break;
+        case JSON_ARRAY_TYPE: {
+            if (array_->refs_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                break;
+            }
+            if (in_arena_ == 1) {
+                array_->~JsonArray();
+            } else {
+                delete array_;
+            }
+        } break;
+        default:
+            break;
+    }
+
+    type_ = JSON_NULL_TYPE;
+    in_arena_ = 0;
+    kind_ = JSON_NUMBER_DOUBLE;
+    size_ = 0;
+    number_ = 0;
+}
+
+void
+JsonValue::set_string(const char *str, std::size_t size, JsonArena *arena)
+{
+    if (size > UINT32_MAX) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonValue: string is too long.[size: %lu]\n%s\n", static_cast<unsigned long>(size), dump_stack().c_str()));
+    }
+
+    // 先拷贝再释放，str 可能是当前值的一部分
+    char *buf = nullptr;
+    if (arena != nullptr) {
+        buf = static_cast<char*>(arena->allocate(size + 1, 1));
+    } else {
+        buf = new char[size + 1];
+    }
+    memcpy(buf, str, size);
+    buf[size] = '\0';
+
+    this->release();
+    type_ = JSON_STRING_TYPE;
+    in_arena_ = (arena != nullptr ? 1 : 0);
+    size_ = static_cast<uint32_t>(size);
+    string_ = buf;
+}
+
+JsonObject*
+JsonValue::set_object(JsonArena *arena)
+{
+    JsonObject *object = nullptr;
+    if (arena != nullptr) {
+        object = new (arena->allocate(sizeof(JsonObject), alignof(JsonObject))) JsonObject(arena);
+    } else {
+        object = new JsonObject();
+    }
+
+    this->release();
+    type_ = JSON_OBJECT_TYPE;
+    in_arena_ = (arena != nullptr ? 1 : 0);
+    object_ = object;
+
+    return object;
+}
+
+JsonArray*
+JsonValue::set_array(JsonArena *arena)
+{
+    JsonArray *array = nullptr;
+    if (arena != nullptr) {
+        array = new (arena->allocate(sizeof(JsonArray), alignof(JsonArray))) JsonArray(arena);
+    } else {
+        array = new JsonArray();
+    }
+
+    this->release();
+    type_ = JSON_ARRAY_TYPE;
+    in_arena_ = (arena != nullptr ? 1 : 0);
+    array_ = array;
+
+    return array;
+}
+
+void
+JsonValue::set_number(double value)
+{
+    this->release();
+    type_ = JSON_NUMBER_TYPE;
+    number_ = value;
+}
+
+void
+JsonValue::set_number(const JsonNumber &value)
+{
+    switch (value.kind())
+    {
+        case JSON_NUMBER_INT:
+            this->set_int(value.to_int());
+            break;
+        case JSON_NUMBER_UINT:
+            this->set_uint(value.to_uint());
+            break;
+        default:
+            this->set_number(value.to_double());
+            break;
+    }
+}
+
+void
+JsonValue::set_int(int64_t value)
+{
+    this->release();
+    type_ = JSON_NUMBER_TYPE;
+    kind_ = JSON_NUMBER_INT;
+    int_ = value;
+}
+
+void
+JsonValue::set_uint(uint64_t value)
+{
+    this->release();
+    type_ = JSON_NUMBER_TYPE;
+    kind_ = JSON_NUMBER_UINT;
+    uint_ = value;
+}
+
+JsonNumber
+JsonValue::to_number(void) const
+{
+    switch (kind_)
+    {
+        case JSON_NUMBER_INT:
+            return JsonNumber(int_);
+        case JSON_NUMBER_UINT:
+            return JsonNumber(uint_);
+        default:
+            break;
+    }
+
+    return JsonNumber(number_);
+}
+
+void
+JsonValue::set_bool(bool value)
+{
+    this->release();
+    type_ = JSON_BOOL_TYPE;
+    bool_ = value;
+}
+
+void
+JsonValue::swap(JsonValue &rhs)
+{
+    std::swap(type_, rhs.type_);
+    std::swap(in_arena_, rhs.in_arena_);
+    std::swap(kind_, rhs.kind_);
+    std::swap(size_, rhs.size_);
+
+    // 联合体中的成员大小不超过 double，整体交换
+    char tmp[sizeof(number_)];
+    memcpy(tmp, &number_, sizeof(number_));
+    memcpy(&number_, &rhs.number_, sizeof(number_));
+    memcpy(&rhs.number_, tmp, sizeof(number_));
+}
+
+void
+JsonValue::share(const JsonValue &val)
+{
+    if (this == &val) {
+        return ;
     }
+
+    switch (val.type_)
+    {
+    case JSON_STRING_TYPE:
+        if (val.in_arena_ == 0) {
+            this->set_string(val.string_, val.size_);
+            return ;
+        }
+        break;
+    case JSON_OBJECT_TYPE:
+        val.object_->refs_.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case JSON_ARRAY_TYPE:
+        val.array_->refs_.fetch_add(1, std::memory_order_relaxed);
+        break;
+    default:
+        break;
+    }
+
+    // 先增加引用计数再释放，val 可能是当前值的子节点
+    this->release();
+    type_ = val.type_;
+    in_arena_ = val.in_arena_;
+    kind_ = val.kind_;
+    size_ = val.size_;
+    memcpy(&number_, &val.number_, sizeof(number_));
+}
+
+JsonObject*
+JsonValue::mutable_object(void)
+{
+    if (!object_->is_shared()) {
+        return object_;
+    }
+
+    // 只拷贝这一层，成员的值继续共享，拷贝出来的对象在堆上
+    std::unique_ptr<JsonObject> object(new JsonObject());
+    object->value_.reserve(object_->value_.size());
+    for (auto iter = object_->value_.begin(); iter != object_->value_.end(); ++iter) {
+        object->value_.emplace_back(std::piecewise_construct, std::forward_as_tuple(iter->first), std::forward_as_tuple());
+        object->value_.back().second.share(iter->second);
+    }
+    object->index_.assign(object_->index_.begin(), object_->index_.end());
+
+    uint8_t in_arena = (in_arena_ != 0 ? 2 : 0);
+    this->release();
+    type_ = JSON_OBJECT_TYPE;
+    in_arena_ = in_arena;
+    object_ = object.release();
+
+    return object_;
+}
+
+JsonArray*
+JsonValue::mutable_array(void)
+{
+    if (!array_->is_shared()) {
+        return array_;
+    }
+
+    std::unique_ptr<JsonArray> array(new JsonArray());
+    array->value_.resize(array_->value_.size());
+    for (std::size_t i = 0; i < array_->value_.size(); ++i) {
+        array->value_[i].share(array_->value_[i]);
+    }
+
+    uint8_t in_arena = (in_arena_ != 0 ? 2 : 0);
+    this->release();
+    type_ = JSON_ARRAY_TYPE;
+    in_arena_ = in_arena;
+    array_ = array.release();
+
+    return array_;
+}
+
+bool
+JsonValue::is_foreign(const JsonArena *arena) const
+{
+    if (in_arena_ == 0) {
+        return false;
+    }
+    // 堆上的对象或数组的子节点在哪个 arena 中无法直接判断，按不属于处理
+    if (in_arena_ != 1 || arena == nullptr) {
+        return true;
+    }
+
+    const void *ptr = nullptr;
+    switch (type_)
+    {
+        case JSON_STRING_TYPE:
+            ptr = string_;
+            break;
+        case JSON_OBJECT_TYPE:
+            ptr = object_;
+            break;
+        case JSON_ARRAY_TYPE:
+            ptr = array_;
+            break;
+        default:
+            return false;
+    }
+
+    return !arena->owns(ptr);
+}
+
+void
+JsonValue::detach(const JsonArena *arena)
+{
+    if (!this->is_foreign(arena)) {
+        return ;
+    }
+
+    // copy() 把 arena 中的内容逐层拷贝到堆上
+    JsonValue value(*this);
+    this->swap(value);
 }
 
 JsonValue::operator JsonBool()
 {
     if (type_ == JSON_BOOL_TYPE) {
-        return JsonBool((dynamic_cast<JsonBool*>(value_))->to_bool());
+        return JsonBool(bool_);
     } else {
-        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not a bool. [type: %s]\n%s\n", JsonType::value_type_to_string(type_), dump_stack().c_str()));
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not a bool. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
     }
 }
 
 JsonValue::operator JsonNumber()
 {
     if (type_ == JSON_NUMBER_TYPE) {
-        return JsonNumber(dynamic_cast<JsonNumber*>(value_)->to_double());
+        return this->to_number();
     } else {
-        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not number. [type: %s]\n%s\n", JsonType::value_type_to_string(type_), dump_stack().c_str()));
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not number. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
     }
 }
 JsonValue::operator JsonString()
 {
     if (type_ == JSON_STRING_TYPE) {
-        return JsonString(dynamic_cast<JsonString*>(value_)->to_string());
+        return JsonString(string_, size_);
+    } else {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not std::string. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+}
+
+JsonValue::operator JsonObject() &
+{
+    if (type_ == JSON_OBJECT_TYPE) {
+        return JsonObject(*object_);
+    } else {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not object. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+}
+JsonValue::operator JsonArray() &
+{
+    if (type_ == JSON_ARRAY_TYPE) {
+        return *array_;
     } else {
-        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not std::string. [type: %s]\n%s\n", JsonType::value_type_to_string(type_), dump_stack().c_str()));
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not array. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
     }
 }
 
-JsonValue::operator JsonObject()
+JsonValue::operator JsonObject() &&
 {
     if (type_ == JSON_OBJECT_TYPE) {
-        JsonObject *js_obj = dynamic_cast<JsonObject*>(value_);
-        return JsonObject(*js_obj);
+        return std::move(*this->mutable_object());
     } else {
-        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not object. [type: %s]\n%s\n", JsonType::value_type_to_string(type_), dump_stack().c_str()));
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not object. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
     }
 }
-JsonValue::operator JsonArray()
+
+JsonValue::operator JsonArray() &&
 {
     if (type_ == JSON_ARRAY_TYPE) {
-        JsonArray *js_arr = dynamic_cast<JsonArray*>(value_);
-        return *js_arr;
+        return std::move(*this->mutable_array());
     } else {
-        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not array. [type: %s]\n%s\n", JsonType::value_type_to_string(type_), dump_stack().c_str()));
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not array. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
     }
 }
 
@@ -1007,16 +1762,14 @@ JsonValue::operator JsonNull()
     if (type_ == JSON_NULL_TYPE) {
         return JsonNull();
     } else {
-        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not null. [type: %s]\n%s\n", JsonType::value_type_to_string(type_), dump_stack().c_str()));
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"value cast failed: current type is not null. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
     }
 }
 
 JsonValue& 
 JsonValue::operator=(const JsonBool &val)
 {
-    type_ = JSON_BOOL_TYPE;
-    delete value_;
-    value_ = new JsonBool(val.to_bool());
+    this->set_bool(val.to_bool());
 
     return *this;
 }
@@ -1024,9 +1777,7 @@ JsonValue::operator=(const JsonBool &val)
 JsonValue& 
 JsonValue::operator=(const JsonNumber &val)
 {
-    type_ = JSON_NUMBER_TYPE;
-    delete value_;
-    value_ = new JsonNumber(val.to_double());
+    this->set_number(val);
 
     return *this;
 }
@@ -1034,9 +1785,7 @@ JsonValue::operator=(const JsonNumber &val)
 JsonValue& 
 JsonValue::operator=(const JsonString &val)
 {
-    type_ = JSON_STRING_TYPE;
-    delete value_;
-    value_ = new JsonString(val.to_string());
+    this->set_string(val.value_.data(), val.value_.size());
 
     return *this;
 }
@@ -1044,11 +1793,11 @@ JsonValue::operator=(const JsonString &val)
 JsonValue& 
 JsonValue::operator=(const JsonObject &val)
 {
+    // 先拷贝再释放，val 可能是当前值的一部分
+    std::unique_ptr<JsonObject> object(new JsonObject(val));
+    this->release();
     type_ = JSON_OBJECT_TYPE;
-    delete value_;
-    JsonObject *object = new JsonObject();
-    object->value_ = val.value_;
-    value_ = object;
+    object_ = object.release();
 
     return *this;
 }
@@ -1056,11 +1805,34 @@ JsonValue::operator=(const JsonObject &val)
 JsonValue& 
 JsonValue::operator=(const JsonArray &val)
 {
+    std::unique_ptr<JsonArray> array(new JsonArray());
+    *array = val;
+    this->release();
+    type_ = JSON_ARRAY_TYPE;
+    array_ = array.release();
+
+    return *this;
+}
+
+JsonValue& 
+JsonValue::operator=(JsonObject &&val)
+{
+    // 移动构造时 arena 中的成员已经拷贝到堆上
+    std::unique_ptr<JsonObject> object(new JsonObject(std::move(val)));
+    this->release();
+    type_ = JSON_OBJECT_TYPE;
+    object_ = object.release();
+
+    return *this;
+}
+
+JsonValue& 
+JsonValue::operator=(JsonArray &&val)
+{
+    std::unique_ptr<JsonArray> array(new JsonArray(std::move(val)));
+    this->release();
     type_ = JSON_ARRAY_TYPE;
-    delete value_;
-    JsonArray *array = new JsonArray();
-    array->value_ = val.value_;
-    value_ = array;
+    array_ = array.release();
 
     return *this;
 }
@@ -1068,9 +1840,7 @@ JsonValue::operator=(const JsonArray &val)
 JsonValue& 
 JsonValue::operator=(const JsonNull &val)
 {
-    type_ = JSON_NULL_TYPE;
-    delete value_;
-    value_ = new JsonNull();
+    this->release();
 
     return *this;
 }
@@ -1082,22 +1852,45 @@ JsonValue::operator=(const JsonValue &val)
     return *this;
 }
 
+JsonValue& 
+JsonValue::operator=(JsonValue &&val)
+{
+    if (this == &val) {
+        return *this;
+    }
+
+    // 和移动构造一样，arena 中的值拷贝到堆上
+    // 先把 val 取出来再释放原来的值，val 可能是当前值的子节点
+    JsonValue tmp(std::move(val));
+    this->swap(tmp);
+
+    return *this;
+}
+
 bool JsonValue::operator==(const JsonValue& rhs) const
 {
+    if (type_ != rhs.type_) {
+        // 兼容之前的行为：null 和字符串 "null" 相等
+        if (type_ == JSON_NULL_TYPE && rhs.type_ == JSON_STRING_TYPE) {
+            return rhs.size_ == 4 && memcmp(rhs.string_, "null", 4) == 0;
+        }
+        return false;
+    }
+
     switch (type_)
     {
     case JSON_NULL_TYPE:
-        return *dynamic_cast<JsonNull*>(value_) == *dynamic_cast<JsonNull*>(rhs.value_);
+        return true;
     case JSON_NUMBER_TYPE:
-        return *dynamic_cast<JsonNumber*>(value_) == *dynamic_cast<JsonNumber*>(rhs.value_);
+        return this->to_number() == rhs.to_number();
     case JSON_STRING_TYPE:
-        return *dynamic_cast<JsonString*>(value_) == *dynamic_cast<JsonString*>(rhs.value_);
+        return size_ == rhs.size_ && memcmp(string_, rhs.string_, size_) == 0;
     case JSON_BOOL_TYPE:
-        return *dynamic_cast<JsonBool*>(value_) == *dynamic_cast<JsonBool*>(rhs.value_);
+        return bool_ == rhs.bool_;
     case JSON_ARRAY_TYPE:
-        return *dynamic_cast<JsonArray*>(value_) == *dynamic_cast<JsonArray*>(rhs.value_);
+        return array_ == rhs.array_ || *array_ == *rhs.array_;
     case  JSON_OBJECT_TYPE:
-        return *dynamic_cast<JsonObject*>(value_) == *dynamic_cast<JsonObject*>(rhs.value_);
+        return object_ == rhs.object_ || *object_ == *rhs.object_;
     default:
         break;
     }
@@ -1114,7 +1907,7 @@ JsonValue&
 JsonValue::operator[](const std::string &key)
 {
     if (type_ == JSON_OBJECT_TYPE) {
-        return (*dynamic_cast<JsonObject*>(value_))[key];
+        return (*this->mutable_object())[key];
     }
 
     throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonValue::operator[%s]: out of range.\n%s\n", key.c_str(), dump_stack().c_str()));
@@ -1124,7 +1917,27 @@ JsonValue&
 JsonValue::operator[](const int &key)
 {
     if (type_ == JSON_ARRAY_TYPE) {
-        return (*dynamic_cast<JsonArray*>(value_))[key];
+        return (*this->mutable_array())[key];
+    }
+
+    throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonValue::operator[%d]: out of range.\n%s\n", key, dump_stack().c_str()));
+}
+
+const JsonValue& 
+JsonValue::operator[](const std::string &key) const
+{
+    if (type_ == JSON_OBJECT_TYPE) {
+        return static_cast<const JsonObject&>(*object_)[key];
+    }
+
+    throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonValue::operator[%s]: out of range.\n%s\n", key.c_str(), dump_stack().c_str()));
+}
+
+const JsonValue& 
+JsonValue::operator[](const int &key) const
+{
+    if (type_ == JSON_ARRAY_TYPE) {
+        return static_cast<const JsonArray&>(*array_)[key];
     }
 
     throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"JsonValue::operator[%d]: out of range.\n%s\n", key, dump_stack().c_str()));
@@ -1132,62 +1945,105 @@ JsonValue::operator[](const int &key)
 
 void JsonValue::copy(const JsonValue &val, bool is_release)
 {
-    if (is_release == true) {
-        delete value_;
+    if (is_release == false) {
+        // 当前的内容还没有初始化，不能释放
+        type_ = JSON_NULL_TYPE;
+        in_arena_ = 0;
+        kind_ = JSON_NUMBER_DOUBLE;
+        size_ = 0;
+        number_ = 0;
+    }
+    if (this == &val) {
+        return ;
     }
 
-    type_ = val.type_;
-    switch (type_)
+    // 拷贝出来的值都在堆上：堆上的对象和数组直接共享，arena 中的逐层拷贝
+    switch (val.type_)
     {
-    case JSON_NULL_TYPE:{
-        value_ = new JsonNull();
-    } break;
-    case JSON_NUMBER_TYPE:{
-        JsonNumber *value = new JsonNumber(dynamic_cast<JsonNumber*>(val.value_)->to_double());
-        value_ = value;
-    } break;
-    case JSON_STRING_TYPE:{
-        JsonString *value = new JsonString(dynamic_cast<JsonString*>(val.value_)->to_string());
-        value_ = value;
-    } break;
-    case JSON_BOOL_TYPE:{
-        JsonBool *value = new JsonBool(dynamic_cast<JsonBool*>(val.value_)->to_bool());
-        value_ = value;
-    } break;
-    case JSON_ARRAY_TYPE:{
-        JsonArray *value = new JsonArray();
-        *value = *dynamic_cast<JsonArray*>(val.value_);
-        value_ = value;
-    } break;
-    case  JSON_OBJECT_TYPE:{
-        JsonObject *value = new JsonObject();
-        *value = *dynamic_cast<JsonObject*>(val.value_);
-        value_ = value;
-    } break;
+    case JSON_NUMBER_TYPE:
+        this->set_number(val.to_number());
+        break;
+    case JSON_STRING_TYPE:
+        this->set_string(val.string_, val.size_);
+        break;
+    case JSON_BOOL_TYPE:
+        this->set_bool(val.bool_);
+        break;
+    case JSON_ARRAY_TYPE:
+        if (val.in_arena_ == 0) {
+            this->share(val);
+        } else {
+            *this = *val.array_;
+        }
+        break;
+    case  JSON_OBJECT_TYPE:
+        if (val.in_arena_ == 0) {
+            this->share(val);
+        } else {
+            *this = *val.object_;
+        }
+        break;
     default:
+        this->release();
         break;
     }
 }
 
+JsonObject& 
+JsonValue::get_object(void)
+{
+    if (type_ != JSON_OBJECT_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"get object failed: current type is not a object. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+    return *this->mutable_object();
+}
+
+JsonArray& 
+JsonValue::get_array(void)
+{
+    if (type_ != JSON_ARRAY_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"get array failed: current type is not a array. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+    return *this->mutable_array();
+}
+
+const JsonObject& 
+JsonValue::get_object(void) const
+{
+    if (type_ != JSON_OBJECT_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"get object failed: current type is not a object. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+    return *object_;
+}
+
+const JsonArray& 
+JsonValue::get_array(void) const
+{
+    if (type_ != JSON_ARRAY_TYPE) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"get array failed: current type is not a array. [type: %s]\n%s\n", JsonType::value_type_to_string(this->type()).c_str(), dump_stack().c_str()));
+    }
+    return *array_;
+}
+
 std::string 
-JsonValue::to_string(void)
+JsonValue::to_string(void) const
 {
     switch (type_)
     {
         case JSON_ARRAY_TYPE: {
-            return dynamic_cast<JsonArray*>(value_)->to_string();
+            return array_->to_string();
         } break;
         case JSON_OBJECT_TYPE: {
-            return dynamic_cast<JsonObject*>(value_)->to_string();
+            return object_->to_string();
         } break;
         case JSON_STRING_TYPE: {
-            return dynamic_cast<JsonString*>(value_)->to_string();
+            return std::string(string_, size_);
         } break;
         case JSON_NUMBER_TYPE: {
-            return dynamic_cast<JsonNumber*>(value_)->to_string();
+            return this->to_number().to_string();
         } break;
         case JSON_BOOL_TYPE: {
-            return dynamic_cast<JsonBool*>(value_)->to_string();
+            return JsonBool(bool_).to_string();
         } break;
         default: {
             return JsonNull().to_string();
@@ -1198,162 +2054,209 @@ JsonValue::to_string(void)
 
 ///////////////////////////////// WeJson //////////////////////////////////////////////////
 WeJson::WeJson(void)
+: doc_arena_(nullptr),
+  key_table_(nullptr)
 {
 
 }
     
 WeJson::WeJson(const std::string &json)
-{
-    this->parse(json);
+: doc_arena_(nullptr),
+  key_table_(nullptr)
+{
+    try {
+        this->parse(json);
+    } catch (...) {
+        // 构造函数抛出异常时不会调用析构函数
+        this->destroy();
+        throw;
+    }
 }
     
 WeJson::WeJson(const ByteBuffer &data)
+: doc_arena_(nullptr),
+  key_table_(nullptr)
+{
+    try {
+        this->parse(data);
+    } catch (...) {
+        this->destroy();
+        throw;
+    }
+}
+
+WeJson::WeJson(const WeJson &rhs)
+: doc_arena_(rhs.doc_arena_),
+  key_table_(rhs.key_table_)
 {
-    this->parse(data);
+    // 共享 arena 和 json 树，arena 在最后一个文档销毁时释放
+    if (doc_arena_ != nullptr) {
+        doc_arena_->add_ref();
+    }
+    this->share(rhs);
+}
+
+WeJson::WeJson(WeJson &&rhs) noexcept
+: doc_arena_(rhs.doc_arena_),
+  key_table_(rhs.key_table_)
+{
+    this->swap(rhs);
+    rhs.doc_arena_ = nullptr;
 }
 
 WeJson::~WeJson(void)
 {
+    this->destroy();
 }
 
 void 
-WeJson::create_object(void)
+WeJson::destroy(void)
 {
-    if (value_ != nullptr) {
-        delete value_;
+    // json 树中的值在 arena 中，需要在 arena 释放之前析构
+    this->release();
+    if (doc_arena_ != nullptr && doc_arena_->remove_ref() == 0) {
+        delete doc_arena_;
     }
-    type_ = JSON_OBJECT_TYPE;
-    value_ = new JsonObject();
+    doc_arena_ = nullptr;
 }
 
-void 
-WeJson::create_array(void)
+WeJson& 
+WeJson::operator=(const WeJson &rhs)
 {
-    if (value_ != nullptr) {
-        delete value_;
+    if (this == &rhs) {
+        return *this;
     }
-    type_ = JSON_ARRAY_TYPE;
-    value_ = new JsonArray();
+
+    JsonArena *arena = rhs.doc_arena_;
+    if (arena != nullptr) {
+        arena->add_ref();
+    }
+    JsonValue tmp;
+    tmp.share(rhs);
+
+    this->destroy();
+    this->swap(tmp);
+    doc_arena_ = arena;
+
+    return *this;
 }
 
-JsonObject& 
-WeJson::get_object(void)
+WeJson& 
+WeJson::operator=(WeJson &&rhs) noexcept
 {
-    if (type_ != JSON_OBJECT_TYPE) {
-        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"get object failed: current type is not a object. [type: %s]\n%s\n", JsonType::value_type_to_string(type_), dump_stack().c_str()));
+    if (this != &rhs) {
+        this->destroy();
+        this->swap(rhs);
+        doc_arena_ = rhs.doc_arena_;
+        key_table_ = rhs.key_table_;
+        rhs.doc_arena_ = nullptr;
     }
-    return *dynamic_cast<JsonObject*>(value_);
+
+    return *this;
 }
 
-JsonArray& 
-WeJson::get_array(void)
+void 
+WeJson::create_object(void)
 {
-    if (type_ != JSON_ARRAY_TYPE) {
-        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"get array failed: current type is not a array. [type: %s]\n%s\n", JsonType::value_type_to_string(type_), dump_stack().c_str()));
-    }
-    return *dynamic_cast<JsonArray*>(value_);
+    this->set_object();
+}
+
+void 
+WeJson::create_array(void)
+{
+    this->set_array();
 }
 
 int 
 WeJson::parse(const std::string &data)
 {
-    return this->parse(ByteBuffer(data));
+    return this->parse(data.c_str(), static_cast<ssize_t>(data.size()));
 }
 
 int 
 WeJson::parse(const ByteBuffer &buff)
 {
-    ByteBuffer simple_json_text;
-    ByteBuffer::iterator start_pos;
-    
-    // 找json文本的开始，如果没有遇到'{'或'['开始的会返回失败
-    for (start_pos = buff.begin(); start_pos != buff.end(); ++start_pos) {
-        ValueType ret = JsonType::check_value_type(start_pos);
-        if (ret == JSON_OBJECT_TYPE || ret == JSON_ARRAY_TYPE) {
-            break;
-        }
+    buffptr first = nullptr, second = nullptr;
+    ssize_t first_size = 0, second_size = 0;
+    buff.get_read_segments(first, first_size, second, second_size);
+    if (second_size == 0) {
+        return this->parse(first, first_size);
     }
 
-    if (start_pos == buff.end()) {
-        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Can't find any json text!\n%s\n", dump_stack().c_str()));
-    }
+    // 数据折返时拷贝成连续的再解析
+    std::string data;
+    data.reserve(first_size + second_size);
+    data.append(first, first_size);
+    data.append(second, second_size);
 
-    bool quotation_marks = false;
-    for (auto iter = start_pos; iter != buff.end(); ++iter) {
-        if (quotation_marks == false && *iter == '"') {
-            quotation_marks = true;
-            simple_json_text.write_int8(*iter); // 写入字符串的第一个 "\""
-            continue;
-        }
+    return this->parse(data);
+}
 
-        if (quotation_marks == true) {
-            if (*iter == '\\'){ 
-                simple_json_text.write_int8(*iter);
-                ++iter; // '\' 为转义字符下一个字符不做解析
-                simple_json_text.write_int8(*iter);
-            } else if (*iter == '"') {
-                quotation_marks = false;
-            }
-        }
+int 
+WeJson::parse(const char *data, ssize_t size)
+{
+    this->prepare_arena(size);
 
-        int i = 0;
-        for (i = 0; i < 4; ++i) {
-            if (sperate_chars[i] == *iter) {
-                break;
-            }
-        }
-        // 如果匹配到json的结构字符并且不是在字符串中，那么就忽略
-        if (i < 4 && quotation_marks == false) {
-            continue;
-        }
+    JsonParser parser(data, size);
+    JsonDomBuilder builder(*this, doc_arena_, key_table_);
+    parser.parse_document(builder);
 
-        // "//" 以这个开头的注释也会被忽略，这个注释可以单独一行或是跟在json那行的末尾，不能出现在json文本那行的前面
-        if (quotation_marks == false && *iter == '/' && *(iter+1) == '/') {
-            for (; iter != buff.end(); ++iter) {
-                if (*iter == '\n') {
-                    break;
-                }
-            }
+    return 0;
+}
 
-            if (*iter == '\n') {
-                continue;
-            }
-        }
+int
+WeJson::parse_cbor(const char *data, ssize_t size)
+{
+    // CBOR 比文本紧凑，按两倍的大小估算
+    this->prepare_arena(size * 2);
 
-        simple_json_text.write_int8(*iter);
+    JsonDomBuilder builder(*this, doc_arena_, key_table_);
+    CborStreamParser parser(builder);
+    parser.feed(data, size);
+    if (!parser.is_complete()) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"WeJson: incomplete CBOR data. [size: %ld]\n%s\n", static_cast<long>(size), dump_stack().c_str()));
     }
-    auto begin_json = simple_json_text.begin();
-    auto end_json = simple_json_text.end();
-
-    parse(begin_json, end_json);
 
     return 0;
 }
 
-
-ByteBuffer::iterator 
-WeJson::parse(ByteBuffer::iterator &value_start_pos, ByteBuffer::iterator &json_end_pos)
+int
+WeJson::parse_cbor(const ByteBuffer &buff)
 {
-    ValueType ret_type = JsonType::check_value_type(value_start_pos);
-    type_ = ret_type;
-    switch (ret_type)
-    {
-    case JSON_ARRAY_TYPE: {
-        this->create_array();
-        return dynamic_cast<JsonArray*>(value_)->parse(value_start_pos, json_end_pos);
+    buffptr first = nullptr, second = nullptr;
+    ssize_t first_size = 0, second_size = 0;
+    buff.get_read_segments(first, first_size, second, second_size);
+    this->prepare_arena((first_size + second_size) * 2);
+
+    // 增量解码，数据折返时不需要拷贝成连续的
+    JsonDomBuilder builder(*this, doc_arena_, key_table_);
+    CborStreamParser parser(builder);
+    if (parser.feed(first, first_size) == first_size && second_size > 0) {
+        parser.feed(second, second_size);
     }
-    case  JSON_OBJECT_TYPE: {
-        this->create_object();
-        return dynamic_cast<JsonObject*>(value_)->parse(value_start_pos, json_end_pos);
-    }
-    default:
-        std::string err_str = GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"Unknown json type (object or array). [type: %s]", JsonType::value_type_to_string(type_));
-        break;
+    if (!parser.is_complete()) {
+        throw std::runtime_error(GLOBAL_GET_MSG(LOG_LEVEL_ERROR,"WeJson: incomplete CBOR data. [size: %ld]\n%s\n", static_cast<long>(first_size + second_size), dump_stack().c_str()));
     }
 
-    return json_end_pos;
+    return 0;
 }
 
+void
+WeJson::prepare_arena(ssize_t size)
+{
+    // 释放上一次解析的结果之后重用 arena 的内存，arena 被其他文档共享时重新创建
+    // 移动出文档的值已经拷贝到堆上(见 JsonValue 的移动构造)，不会引用被重用的内存
+    this->release();
+    if (doc_arena_ != nullptr && doc_arena_->is_shared()) {
+        this->destroy();
+    }
+    if (doc_arena_ == nullptr) {
+        std::size_t block_size = static_cast<std::size_t>(size > 0 ? size : 0) * 2;
+        doc_arena_ = new JsonArena(std::min<std::size_t>(std::max<std::size_t>(block_size, 256), JSON_ARENA_MAX_BLOCK_SIZE));
+    } else {
+        doc_arena_->reset();
+    }
+}
 
 std::string 
 WeJson::to_string(void)
@@ -1361,9 +2264,9 @@ WeJson::to_string(void)
     switch (type_)
     {
     case JSON_ARRAY_TYPE:
-        return dynamic_cast<JsonArray*>(value_)->to_string();
+        return array_->to_string();
     case  JSON_OBJECT_TYPE:
-        return dynamic_cast<JsonObject*>(value_)->to_string();
+        return object_->to_string();
     default:
         break;
     }
@@ -1374,75 +2277,17 @@ WeJson::to_string(void)
 std::string 
 WeJson::format_json(void)
 {
-    if (type_ == JSON_OBJECT_TYPE || type_ == JSON_ARRAY_TYPE){
-        std::string raw_json = this->to_string();
-
-        bool bracket_flag = false;      // 中括号标志， 表示在数组内
-        bool quotation_flag = false;    // 引号标志， 表示在字符串内
-        int tab = 0;
-        std::ostringstream oformat_json;
-        for (std::size_t i = 0; i < raw_json.size(); ++i) {
-            if (raw_json[i] == '{' || raw_json[i] == '[') {
-                ++tab;
-                oformat_json << raw_json[i];
-                oformat_json << '\n';
-                for (int j = 0; j < tab; ++j) {
-                    oformat_json << '\t';
-                }
-
-                if (raw_json[i] == '[') {
-                    bracket_flag = true;
-                }
-            } else if (raw_json[i] == '}' || raw_json[i] == ']') {
-                oformat_json << '\n';
-                --tab;
-                for (int j = 0; j < tab; ++j) {
-                    oformat_json << '\t';
-                }
-                oformat_json << raw_json[i];
-                
-                if (raw_json[i] == ']') {
-                    bracket_flag = false;
-                }
-            } else if (quotation_flag == false && raw_json[i] == ',' && (raw_json[i+1] == '"' || bracket_flag == true)) {
-                if (raw_json[i+1] == '"') {
-                    quotation_flag = true;
-                }
-                oformat_json << raw_json[i];
-                oformat_json << '\n';
-                for (int j = 0; j < tab; ++j) {
-                    oformat_json << '\t';
-                }
-            } else {
-                // 计算转义符号，防止在字符串内出现 "\"," 这样的格式，确保是不是真的是字符串的结束位置
-                if (raw_json[i] == '"' && (raw_json[i+1] == ',' || raw_json[i+1] == ':' || raw_json[i+1] == '}' || raw_json[i+1] == ']') && quotation_flag == true) {
-                    int pos = static_cast<int>(i);
-                    int cnt = 0;
-                    for ( ; pos >= 0; --pos) {
-                        if (raw_json[pos] == '\\') {
-                            cnt++;
-                        } else {
-                            break;
-                        }
-                    }
-                    if (cnt % 2 == 0) {
-                        quotation_flag = false;
-                    }
-                }
-                oformat_json << raw_json[i];
-                if (raw_json[i] == ':' && quotation_flag == false) { // : 后加个空格
-                    oformat_json << ' ';
-                    if (raw_json[i+1] == '"') { // 进入值字符串
-                        quotation_flag = true;
-                    } 
-                }
-            }
-        }
-
-        return oformat_json.str().c_str();
-    } else {
+    if (type_ != JSON_OBJECT_TYPE && type_ != JSON_ARRAY_TYPE) {
         return this->to_string();
     }
+
+    // 每层缩进一个制表符
+    std::string out;
+    JsonWriter writer(out);
+    writer.set_indent(1, '\t');
+    writer.write(*this);
+
+    return out;
 }
 
 